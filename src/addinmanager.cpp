@@ -370,6 +370,19 @@ namespace {
     }
   }
 
+  void AddinManager::unload_addins_for_note(NoteBase & note)
+  {
+    NoteAddinMap::iterator iter = m_note_addins.find(note.uri());
+    if(iter == m_note_addins.end()) {
+      return;
+    }
+
+    for(auto & addin : iter->second) {
+      addin.second->dispose(true);
+    }
+    m_note_addins.erase(iter);
+  }
+
   std::vector<NoteAddin*> AddinManager::get_note_addins(const NoteBase & note) const
   {
     std::vector<NoteAddin*> addins;
@@ -63,6 +63,8 @@ public:
     }
 
   void load_addins_for_note(NoteBase &);
+  // shuts down and destroys addins of the note, load_addins_for_note() creates them anew
+  void unload_addins_for_note(NoteBase &);
   std::vector<NoteAddin*> get_note_addins(const NoteBase &) const;
   ApplicationAddin *get_application_addin(const Glib::ustring & id) const;
   sync::SyncServiceAddin *get_sync_service_addin(const Glib::ustring & id) const;
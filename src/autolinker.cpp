@@ -0,0 +1,407 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <glibmm/unicode.h>
+
+#include "autolinker.hpp"
+#include "debug.hpp"
+#include "notemanagerbase.hpp"
+#include "searchindex.hpp"
+#include "utils.hpp"
+
+
+namespace gnote {
+
+namespace {
+
+const char *LINK_START = "<link:internal>";
+const char *LINK_END = "</link:internal>";
+const char *LINK_PREFIX = "link:";
+// linked notes are passed to main thread in groups of this size
+const std::size_t RESULT_BATCH = 64;
+
+
+bool is_word_char(gunichar c)
+{
+  return c != 0 && Glib::Unicode::isalnum(c);
+}
+
+// decodes one character at pos, which can be an entity, and moves past it
+bool decode_char(const std::string & raw, std::size_t & pos, gunichar & c)
+{
+  if(raw[pos] != '&') {
+    const char *start = raw.data() + pos;
+    c = g_utf8_get_char_validated(start, raw.size() - pos);
+    if(c == gunichar(-1) || c == gunichar(-2)) {
+      return false;
+    }
+    pos += g_utf8_next_char(start) - start;
+    return true;
+  }
+
+  std::size_t end = raw.find(';', pos);
+  if(end == std::string::npos) {
+    return false;
+  }
+  std::string entity(raw, pos + 1, end - pos - 1);
+  if(entity == "amp") {
+    c = '&';
+  }
+  else if(entity == "lt") {
+    c = '<';
+  }
+  else if(entity == "gt") {
+    c = '>';
+  }
+  else if(entity == "quot") {
+    c = '"';
+  }
+  else if(entity == "apos") {
+    c = '\'';
+  }
+  else if(entity.size() > 1 && entity[0] == '#') {
+    bool hex = entity[1] == 'x';
+    char *num_end = nullptr;
+    c = std::strtoul(entity.c_str() + (hex ? 2 : 1), &num_end, hex ? 16 : 10);
+    if(*num_end != 0) {
+      return false;
+    }
+  }
+  else {
+    return false;
+  }
+  pos = end + 1;
+  return true;
+}
+
+// first character of text at or after pos, 0 if there is none
+gunichar next_text_char(const std::string & raw, std::size_t pos)
+{
+  while(pos < raw.size()) {
+    if(raw[pos] == '<') {
+      pos = raw.find('>', pos);
+      if(pos == std::string::npos) {
+        return 0;
+      }
+      ++pos;
+      continue;
+    }
+
+    gunichar c;
+    return decode_char(raw, pos, c) ? c : 0;
+  }
+  return 0;
+}
+
+}
+
+
+bool AutoLinker::link_titles(Glib::ustring & xml, const TitleTrie & titles, const Glib::ustring & uri)
+{
+  const std::string & raw = xml.raw();
+  std::string linked;
+  std::size_t copied = 0;
+  int link_depth = 0;
+  gunichar prev_char = 0;
+  std::size_t pos = 0;
+  while(pos < raw.size()) {
+    if(raw[pos] == '<') {
+      std::size_t end = raw.find('>', pos);
+      // comments, CDATA and processing instructions are not written to notes
+      if(end == std::string::npos || pos + 1 == end || raw[pos + 1] == '!' || raw[pos + 1] == '?') {
+        return false;
+      }
+      bool closing = raw[pos + 1] == '/';
+      std::size_t name_start = pos + (closing ? 2 : 1);
+      if(raw.compare(name_start, std::strlen(LINK_PREFIX), LINK_PREFIX) == 0) {
+        if(closing) {
+          --link_depth;
+        }
+        else if(raw[end - 1] != '/') {
+          ++link_depth;
+        }
+      }
+      pos = end + 1;
+      continue;
+    }
+
+    std::size_t text_end = std::min(raw.find('<', pos), raw.size());
+    // characters and their offsets in raw, plus the end
+    std::vector<gunichar> chars;
+    std::vector<std::size_t> offsets;
+    Glib::ustring text;
+    while(pos < text_end) {
+      offsets.push_back(pos);
+      gunichar c;
+      if(!decode_char(raw, pos, c)) {
+        return false;
+      }
+      chars.push_back(c);
+      text += c;
+    }
+    offsets.push_back(pos);
+
+    // same as buffer highlighting: no links inside links, only whole words
+    if(link_depth == 0 && !chars.empty()) {
+      auto hits = titles.find_matches(text);
+      std::sort(hits.begin(), hits.end(), [](const TrieHit<Glib::ustring> & a, const TrieHit<Glib::ustring> & b) {
+        return a.start() < b.start() || (a.start() == b.start() && a.end() > b.end());
+      });
+      gunichar next_char = next_text_char(raw, text_end);
+      int linked_end = 0;
+      for(const auto & hit : hits) {
+        if(hit.start() < linked_end || hit.value() == uri) {
+          continue;
+        }
+        gunichar before = hit.start() > 0 ? chars[hit.start() - 1] : prev_char;
+        gunichar after = std::size_t(hit.end()) < chars.size() ? chars[hit.end()] : next_char;
+        if(is_word_char(before) || is_word_char(after)) {
+          continue;
+        }
+
+        std::size_t start_offset = offsets[hit.start()];
+        std::size_t end_offset = offsets[hit.end()];
+        linked.append(raw, copied, start_offset - copied);
+        linked += LINK_START;
+        linked.append(raw, start_offset, end_offset - start_offset);
+        linked += LINK_END;
+        copied = end_offset;
+        linked_end = hit.end();
+      }
+    }
+
+    if(!chars.empty()) {
+      prev_char = chars.back();
+    }
+  }
+
+  if(copied == 0) {
+    return false;
+  }
+  linked.append(raw, copied, std::string::npos);
+  xml = linked;
+  return true;
+}
+
+
+AutoLinker::AutoLinker(NoteManagerBase & manager, BufferHandler && buffer_handler)
+  : m_manager(manager)
+  , m_buffer_handler(std::move(buffer_handler))
+{
+  m_note_deleted_cid = m_manager.signal_note_deleted.connect(sigc::mem_fun(*this, &AutoLinker::on_note_deleted));
+  m_note_renamed_cid = m_manager.signal_note_renamed.connect(sigc::mem_fun(*this, &AutoLinker::on_note_renamed));
+}
+
+AutoLinker::~AutoLinker()
+{
+  m_note_deleted_cid.disconnect();
+  m_note_renamed_cid.disconnect();
+  cancel();
+}
+
+void AutoLinker::link(const std::vector<Glib::ustring> & uris)
+{
+  m_waiting.insert(m_waiting.end(), uris.begin(), uris.end());
+  if(!m_pass) {
+    start_pass();
+  }
+}
+
+void AutoLinker::cancel()
+{
+  stop_pass();
+  m_waiting.clear();
+}
+
+void AutoLinker::start_pass()
+{
+  auto pass = std::make_shared<Pass>();
+  std::vector<Glib::ustring> titles;
+  for(const auto & uri : m_waiting) {
+    auto note = m_manager.find_by_uri(uri);
+    if(!note || std::find(pass->uris.begin(), pass->uris.end(), uri) != pass->uris.end()) {
+      continue;
+    }
+    const Glib::ustring & title = note.value().get().get_title();
+    pass->titles.add_keyword(title, uri);
+    pass->uris.push_back(uri);
+    titles.push_back(title);
+  }
+  m_waiting.clear();
+  if(titles.empty()) {
+    return;
+  }
+  pass->titles.compute_failure_graph();
+
+  // notes, that don't have all words of any title, can't mention it
+  const SearchIndex & index = m_manager.search_index();
+  std::optional<SearchIndex::UriSet> candidates = SearchIndex::UriSet();
+  for(const auto & title : titles) {
+    auto title_candidates = index.find_candidates({title});
+    if(!title_candidates) {
+      candidates.reset();
+      break;
+    }
+    candidates->insert(title_candidates->begin(), title_candidates->end());
+  }
+
+  m_manager.for_each([this, &pass, &index, &candidates](NoteBase & note) {
+    if(candidates && index.is_indexed(note.uri()) && candidates->find(note.uri()) == candidates->end()) {
+      return;
+    }
+    if(m_buffer_handler(note)) {
+      return;
+    }
+
+    Job job;
+    job.uri = note.uri();
+    if(note.is_text_loaded()) {
+      job.xml = note.xml_content();
+    }
+    else {
+      job.file = note.file_path();
+    }
+    pass->jobs.push_back(std::move(job));
+  });
+  DBG_OUT_2("Linking %zu titles, %zu notes to check", titles.size(), pass->jobs.size());
+  if(pass->jobs.empty()) {
+    return;
+  }
+
+  m_pass = pass;
+  m_thread = std::thread([this, pass] { run(pass); });
+}
+
+void AutoLinker::run(const std::shared_ptr<Pass> & pass)
+{
+  // posted to main loop, so that results are never applied on this thread
+  auto results = std::make_shared<std::vector<Result>>();
+  auto post_results = [this, &pass, &results] {
+    utils::timeout_add_once(0, [this, pass, results] {
+      if(!pass->cancelled) {
+        apply(*pass, *results);
+      }
+    });
+    results = std::make_shared<std::vector<Result>>();
+  };
+
+  for(auto & job : pass->jobs) {
+    if(pass->cancelled) {
+      return;
+    }
+
+    Glib::ustring xml = job.file.empty() ? std::move(job.xml) : NoteArchiver::read_text(job.file);
+    Glib::ustring linked = xml;
+    if(link_titles(linked, pass->titles, job.uri)) {
+      results->push_back(Result{job.uri, std::move(xml), std::move(linked)});
+      if(results->size() >= RESULT_BATCH) {
+        post_results();
+      }
+    }
+  }
+
+  if(!results->empty()) {
+    post_results();
+  }
+  utils::timeout_add_once(0, [this, pass] {
+    if(!pass->cancelled) {
+      on_pass_finished();
+    }
+  });
+}
+
+void AutoLinker::apply(const Pass & pass, std::vector<Result> & results)
+{
+  for(auto & result : results) {
+    // saving can rename or delete notes, which restarts the pass
+    if(pass.cancelled) {
+      return;
+    }
+
+    m_manager.find_by_uri(result.uri, [this, &pass, &result](NoteBase & note) {
+      // the note got a buffer meanwhile
+      if(m_buffer_handler(note)) {
+        return;
+      }
+
+      if(note.xml_content() != result.xml) {
+        result.linked_xml = note.xml_content();
+        if(!link_titles(result.linked_xml, pass.titles, result.uri)) {
+          return;
+        }
+      }
+      note.set_xml_content(std::move(result.linked_xml));
+      note.queue_save(CONTENT_CHANGED);
+    });
+  }
+}
+
+void AutoLinker::on_pass_finished()
+{
+  m_thread.join();
+  m_pass.reset();
+  if(!m_waiting.empty()) {
+    start_pass();
+  }
+}
+
+void AutoLinker::stop_pass()
+{
+  if(!m_pass) {
+    return;
+  }
+
+  m_pass->cancelled = true;
+  if(m_thread.joinable()) {
+    m_thread.join();
+  }
+  m_pass.reset();
+}
+
+void AutoLinker::restart_pass(const Glib::ustring & changed_uri, bool deleted)
+{
+  if(!m_pass || std::find(m_pass->uris.begin(), m_pass->uris.end(), changed_uri) == m_pass->uris.end()) {
+    return;
+  }
+
+  auto uris = std::move(m_pass->uris);
+  stop_pass();
+  if(deleted) {
+    uris.erase(std::remove(uris.begin(), uris.end(), changed_uri), uris.end());
+  }
+  m_waiting.insert(m_waiting.begin(), uris.begin(), uris.end());
+  start_pass();
+}
+
+void AutoLinker::on_note_deleted(NoteBase & note)
+{
+  restart_pass(note.uri(), true);
+}
+
+void AutoLinker::on_note_renamed(const NoteBase & note, const Glib::ustring &)
+{
+  restart_pass(note.uri(), false);
+}
+
+}
@@ -0,0 +1,119 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _AUTOLINKER_HPP_
+#define _AUTOLINKER_HPP_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "notebase.hpp"
+#include "trie.hpp"
+
+
+namespace gnote {
+
+class NoteManagerBase;
+
+/**
+ * Links titles of added and renamed notes in the text of other notes.
+ *
+ * Notes, that can mention a title, are found using the search index, the text
+ * of the others is not looked at. Notes with a buffer are passed to the buffer
+ * handler on main thread. For the others the stored XML is matched against a
+ * trie of the titles on a worker thread, the linked XML is set on main thread,
+ * unless the note has changed meanwhile. Titles, that come while a pass is
+ * running, are linked by the next one.
+ */
+class AutoLinker
+{
+public:
+  // links titles in the note buffer and returns true, if the note has one
+  typedef std::function<bool(NoteBase&)> BufferHandler;
+  typedef TrieTree<Glib::ustring> TitleTrie;
+
+  // Wraps titles (lowercase, URI as value) found in text of note XML into
+  // internal links, except inside existing links, in other words and for the
+  // note with given URI. Returns false, if nothing was linked.
+  static bool link_titles(Glib::ustring & xml, const TitleTrie & titles, const Glib::ustring & uri);
+
+  AutoLinker(NoteManagerBase & manager, BufferHandler && buffer_handler);
+  ~AutoLinker();
+  // link titles of the notes with given URIs
+  void link(const std::vector<Glib::ustring> & uris);
+  // stop running pass and drop the waiting titles
+  void cancel();
+  bool is_running() const
+    {
+      return bool(m_pass);
+    }
+private:
+  struct Job
+  {
+    Glib::ustring uri;
+    // file to read the text from, if not loaded
+    Glib::ustring file;
+    Glib::ustring xml;
+  };
+  struct Result
+  {
+    Glib::ustring uri;
+    // XML, the result is based on
+    Glib::ustring xml;
+    Glib::ustring linked_xml;
+  };
+  struct Pass
+  {
+    Pass()
+      : titles(false)
+      , cancelled(false)
+      {}
+    std::vector<Glib::ustring> uris;
+    TitleTrie titles;
+    std::vector<Job> jobs;
+    std::atomic<bool> cancelled;
+  };
+
+  void start_pass();
+  // worker thread
+  void run(const std::shared_ptr<Pass> & pass);
+  void apply(const Pass & pass, std::vector<Result> & results);
+  void on_pass_finished();
+  void stop_pass();
+  // titles of the running pass are no longer valid, link again
+  void restart_pass(const Glib::ustring & changed_uri, bool deleted);
+  void on_note_deleted(NoteBase & note);
+  void on_note_renamed(const NoteBase & note, const Glib::ustring & old_title);
+
+  NoteManagerBase & m_manager;
+  BufferHandler m_buffer_handler;
+  std::shared_ptr<Pass> m_pass;
+  std::thread m_thread;
+  std::vector<Glib::ustring> m_waiting;
+  sigc::connection m_note_deleted_cid;
+  sigc::connection m_note_renamed_cid;
+};
+
+}
+
+#endif
@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2025 Aurimas Cernius
+ * Copyright (C) 2025-2026 Aurimas Cernius
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -30,6 +30,11 @@ void Monitor::wait(Lock &lock)
   m_cond.wait(lock.m_lock);
 }
 
+bool Monitor::wait_until(Lock &lock, std::chrono::steady_clock::time_point time)
+{
+  return m_cond.wait_until(lock.m_lock, time) == std::cv_status::no_timeout;
+}
+
 void Monitor::notify_one()
 {
   m_cond.notify_one();
@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2025 Aurimas Cernius
+ * Copyright (C) 2025-2026 Aurimas Cernius
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -20,6 +20,7 @@
 #ifndef _MONITOR_HPP_
 #define _MONITOR_HPP_
 
+#include <chrono>
 #include <condition_variable>
 
 
@@ -40,6 +41,8 @@ public:
   };
 
   void wait(Lock &lock);
+  // returns false on timeout
+  bool wait_until(Lock &lock, std::chrono::steady_clock::time_point time);
   void notify_one();
   void notify_all();
 private:
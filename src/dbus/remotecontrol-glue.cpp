@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2011,2017,2020,2022 Aurimas Cernius
+ * Copyright (C) 2011,2017,2020,2022,2026 Aurimas Cernius
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -55,6 +55,7 @@ RemoteControl_adaptor::RemoteControl_adaptor(const Glib::RefPtr<Gio::DBus::Conne
   m_stubs["GetNoteCreateDate"] = &RemoteControl_adaptor::GetNoteCreateDate_stub;
   m_stubs["GetNoteCreateDateUnix"] = &RemoteControl_adaptor::GetNoteCreateDateUnix_stub;
   m_stubs["GetNoteTitle"] = &RemoteControl_adaptor::GetNoteTitle_stub;
+  m_stubs["GetSyncStats"] = &RemoteControl_adaptor::GetSyncStats_stub;
   m_stubs["GetTagsForNote"] = &RemoteControl_adaptor::GetTagsForNote_stub;
   m_stubs["HideNote"] = &RemoteControl_adaptor::HideNote_stub;
   m_stubs["ListAllNotes"] = &RemoteControl_adaptor::ListAllNotes_stub;
@@ -238,6 +239,12 @@ Glib::VariantContainerBase RemoteControl_adaptor::GetNoteTitle_stub(const Glib::
 }
 
 
+Glib::VariantContainerBase RemoteControl_adaptor::GetSyncStats_stub(const Glib::VariantContainerBase &)
+{
+  return Glib::VariantContainerBase::create_tuple(Glib::Variant<std::map<Glib::ustring, gint64>>::create(GetSyncStats()));
+}
+
+
 Glib::VariantContainerBase RemoteControl_adaptor::GetTagsForNote_stub(const Glib::VariantContainerBase & parameters)
 {
   return stub_vectorstring_string(parameters, &RemoteControl_adaptor::GetTagsForNote);
@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2011,2017,2020 Aurimas Cernius
+ * Copyright (C) 2011,2017,2020,2026 Aurimas Cernius
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -18,6 +18,8 @@
  */
 
 
+#include <map>
+
 #include <giomm/dbusconnection.h>
 #include <giomm/dbusinterfacevtable.h>
 
@@ -52,6 +54,7 @@ public:
   virtual int32_t GetNoteCreateDate(const Glib::ustring& uri) = 0;
   virtual int64_t GetNoteCreateDateUnix(const Glib::ustring& uri) = 0;
   virtual Glib::ustring GetNoteTitle(const Glib::ustring& uri) = 0;
+  virtual std::map<Glib::ustring, gint64> GetSyncStats() = 0;
   virtual std::vector<Glib::ustring> GetTagsForNote(const Glib::ustring& uri) = 0;
   virtual bool HideNote(const Glib::ustring& uri) = 0;
   virtual std::vector<Glib::ustring> ListAllNotes() = 0;
@@ -94,6 +97,7 @@ private:
   Glib::VariantContainerBase GetNoteCreateDate_stub(const Glib::VariantContainerBase &);
   Glib::VariantContainerBase GetNoteCreateDateUnix_stub(const Glib::VariantContainerBase &);
   Glib::VariantContainerBase GetNoteTitle_stub(const Glib::VariantContainerBase &);
+  Glib::VariantContainerBase GetSyncStats_stub(const Glib::VariantContainerBase &);
   Glib::VariantContainerBase GetTagsForNote_stub(const Glib::VariantContainerBase &);
   Glib::VariantContainerBase HideNote_stub(const Glib::VariantContainerBase &);
   Glib::VariantContainerBase ListAllNotes_stub(const Glib::VariantContainerBase &);
@@ -28,6 +28,7 @@
 #include "notewindow.hpp"
 #include "remotecontrolproxy.hpp"
 #include "search.hpp"
+#include "synchronization/isyncmanager.hpp"
 #include "tag.hpp"
 #include "itagmanager.hpp"
 #include "dbus/remotecontrol.hpp"
@@ -237,6 +238,12 @@ namespace gnote {
   }
 
 
+  std::map<Glib::ustring, gint64> RemoteControl::GetSyncStats()
+  {
+    return m_gnote.sync_manager().last_sync_stats().to_map();
+  }
+
+
   std::vector<Glib::ustring> RemoteControl::GetTagsForNote(const Glib::ustring& uri)
   {
     std::vector<Glib::ustring> tags;
@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2011-2014,2017,2019-2020,2023 Aurimas Cernius
+ * Copyright (C) 2011-2014,2017,2019-2020,2023,2026 Aurimas Cernius
  * Copyright (C) 2009 Hubert Figuiere
  *
  * This program is free software: you can redistribute it and/or modify
@@ -62,6 +62,7 @@ public:
   virtual int32_t GetNoteCreateDate(const Glib::ustring& uri) override;
   virtual int64_t GetNoteCreateDateUnix(const Glib::ustring& uri) override;
   virtual Glib::ustring GetNoteTitle(const Glib::ustring& uri) override;
+  virtual std::map<Glib::ustring, gint64> GetSyncStats() override;
   virtual std::vector<Glib::ustring> GetTagsForNote(const Glib::ustring& uri) override;
   virtual bool HideNote(const Glib::ustring& uri) override;
   virtual std::vector<Glib::ustring> ListAllNotes() override;
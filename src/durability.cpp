@@ -0,0 +1,129 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+
+#include "debug.hpp"
+#include "durability.hpp"
+
+
+namespace gnote {
+
+namespace {
+
+std::atomic<guint64> s_fsync_count{0};
+std::atomic<guint64> s_fsync_failures{0};
+std::atomic<guint64> s_fsync_total_usec{0};
+std::atomic<guint64> s_fsync_max_usec{0};
+
+template <typename F>
+bool timed_sync(const F & sync)
+{
+  auto start = std::chrono::steady_clock::now();
+  bool ok = sync();
+  guint64 usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+  ++s_fsync_count;
+  if(!ok) {
+    ++s_fsync_failures;
+  }
+  s_fsync_total_usec += usec;
+  auto max = s_fsync_max_usec.load();
+  while(usec > max && !s_fsync_max_usec.compare_exchange_weak(max, usec)) {
+  }
+  return ok;
+}
+
+template <typename F>
+bool with_fd(const Glib::ustring & path, const F & func)
+{
+  int fd = g_open(path.c_str(), O_RDONLY, 0);
+  if(fd < 0) {
+    ERR_OUT("Failed to open %s for sync: %s", path.c_str(), std::strerror(errno));
+    return false;
+  }
+  bool ret = func(fd);
+  close(fd);
+  return ret;
+}
+
+}
+
+
+Durability durability_from_string(const Glib::ustring & value)
+{
+  if(value == "none") {
+    return Durability::NONE;
+  }
+  if(value == "file") {
+    return Durability::FILE;
+  }
+  return Durability::BATCH;
+}
+
+Glib::ustring durability_to_string(Durability durability)
+{
+  switch(durability) {
+  case Durability::NONE:
+    return "none";
+  case Durability::FILE:
+    return "file";
+  default:
+    return "batch";
+  }
+}
+
+FsyncStats fsync_stats()
+{
+  return FsyncStats{s_fsync_count.load(), s_fsync_failures.load(), s_fsync_total_usec.load(), s_fsync_max_usec.load()};
+}
+
+void reset_fsync_stats()
+{
+  s_fsync_count = 0;
+  s_fsync_failures = 0;
+  s_fsync_total_usec = 0;
+  s_fsync_max_usec = 0;
+}
+
+bool fsync_fd(int fd)
+{
+  return timed_sync([fd] {
+    if(fsync(fd) != 0) {
+      ERR_OUT("fsync failed: %s", std::strerror(errno));
+      return false;
+    }
+    return true;
+  });
+}
+
+bool fsync_path(const Glib::ustring & path)
+{
+  return with_fd(path, [](int fd) { return fsync_fd(fd); });
+}
+
+}
@@ -0,0 +1,68 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _DURABILITY_HPP_
+#define _DURABILITY_HPP_
+
+
+#include <glibmm/ustring.h>
+
+
+namespace gnote {
+
+/**
+ * How written files are flushed to disk.
+ *
+ * NONE leaves it to the operating system. FILE syncs every file before it is
+ * renamed into place and the directory after it. BATCH writes a group of files,
+ * syncs them all, renames them into place and syncs their directory once, which
+ * is much cheaper on network homes.
+ */
+enum class Durability
+{
+  NONE,
+  FILE,
+  BATCH
+};
+
+// "none", "file" or "batch", anything else is BATCH
+Durability durability_from_string(const Glib::ustring & value);
+Glib::ustring durability_to_string(Durability durability);
+
+struct FsyncStats
+{
+  guint64 count;
+  guint64 failures;
+  guint64 total_usec;
+  guint64 max_usec;
+};
+
+// counters for all syncs done via functions below, safe to use from any thread
+FsyncStats fsync_stats();
+void reset_fsync_stats();
+
+// false on failure, error is logged
+bool fsync_fd(int fd);
+// sync file or directory
+bool fsync_path(const Glib::ustring & path);
+
+}
+
+#endif
@@ -0,0 +1,167 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <cstring>
+
+#include "linkindex.hpp"
+#include "notemanagerbase.hpp"
+#include "utils.hpp"
+
+
+namespace gnote {
+
+namespace {
+
+const char *LINK_START = "<link:internal>";
+const char *LINK_END = "</link:internal>";
+
+const LinkIndex::StringSet EMPTY_SET;
+
+}
+
+
+LinkIndex::StringSet LinkIndex::extract_links(const Glib::ustring & xml)
+{
+  StringSet links;
+  const std::string & raw = xml.raw();
+  const std::size_t start_len = strlen(LINK_START);
+  std::size_t pos = 0;
+  while((pos = raw.find(LINK_START, pos)) != std::string::npos) {
+    pos += start_len;
+    std::size_t end = raw.find(LINK_END, pos);
+    if(end == std::string::npos) {
+      break;
+    }
+    links.insert(raw.substr(pos, end - pos));
+    pos = end;
+  }
+  return links;
+}
+
+LinkIndex::LinkIndex(NoteManagerBase & manager)
+  : m_manager(manager)
+  , m_built(false)
+{
+  m_manager.signal_note_added.connect(sigc::mem_fun(*this, &LinkIndex::on_note_changed));
+  m_manager.signal_note_saved.connect(sigc::mem_fun(*this, &LinkIndex::on_note_changed));
+  m_manager.signal_note_deleted.connect(sigc::mem_fun(*this, &LinkIndex::on_note_deleted));
+}
+
+const LinkIndex::StringSet & LinkIndex::linking_notes(const Glib::ustring & title)
+{
+  build();
+  refresh_invalidated();
+  auto iter = m_backlinks.find(utils::XmlEncoder::encode(title));
+  return iter != m_backlinks.end() ? iter->second : EMPTY_SET;
+}
+
+const LinkIndex::StringSet & LinkIndex::links(const Glib::ustring & uri)
+{
+  build();
+  refresh_invalidated();
+  auto iter = m_links.find(uri);
+  return iter != m_links.end() ? iter->second : EMPTY_SET;
+}
+
+void LinkIndex::build()
+{
+  if(m_built) {
+    return;
+  }
+
+  m_built = true;
+  m_manager.for_each([this](NoteBase & note) {
+    set_links(note.uri(), extract_links(note.xml_content()));
+  });
+}
+
+void LinkIndex::invalidate(const NoteBase & note)
+{
+  // until built nothing to update, build reads all notes anyway
+  if(m_built) {
+    m_invalidated.insert(note.uri());
+  }
+}
+
+void LinkIndex::refresh_invalidated()
+{
+  if(m_invalidated.empty()) {
+    return;
+  }
+
+  StringSet invalidated;
+  std::swap(invalidated, m_invalidated);
+  for(const auto & uri : invalidated) {
+    if(auto note = m_manager.find_by_uri(uri)) {
+      set_links(uri, extract_links(note.value().get().xml_content()));
+    }
+  }
+}
+
+void LinkIndex::on_note_changed(NoteBase & note)
+{
+  // until built nothing to update, build reads all notes anyway
+  if(m_built) {
+    m_invalidated.erase(note.uri());
+    set_links(note.uri(), extract_links(note.xml_content()));
+  }
+}
+
+void LinkIndex::on_note_deleted(NoteBase & note)
+{
+  if(m_built) {
+    m_invalidated.erase(note.uri());
+    remove_links(note.uri());
+  }
+}
+
+void LinkIndex::set_links(const Glib::ustring & uri, StringSet && links)
+{
+  remove_links(uri);
+  if(links.empty()) {
+    return;
+  }
+
+  for(const auto & title : links) {
+    m_backlinks[title].insert(uri);
+  }
+  m_links[uri] = std::move(links);
+}
+
+void LinkIndex::remove_links(const Glib::ustring & uri)
+{
+  auto iter = m_links.find(uri);
+  if(iter == m_links.end()) {
+    return;
+  }
+
+  for(const auto & title : iter->second) {
+    auto backlinks = m_backlinks.find(title);
+    if(backlinks != m_backlinks.end()) {
+      backlinks->second.erase(uri);
+      if(backlinks->second.empty()) {
+        m_backlinks.erase(backlinks);
+      }
+    }
+  }
+  m_links.erase(iter);
+}
+
+}
@@ -0,0 +1,83 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _LINKINDEX_HPP_
+#define _LINKINDEX_HPP_
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "notebase.hpp"
+#include "base/hash.hpp"
+
+
+namespace gnote {
+
+class NoteManagerBase;
+
+/**
+ * Graph of internal links between notes.
+ *
+ * For every note the titles it links to are kept, together with the reverse
+ * mapping from title to the notes linking to it. Links are taken from the note
+ * XML, when the note is saved. Notes with unsaved changes are invalidated and
+ * rescanned on the next lookup. Titles are kept XML encoded, as in the link tag.
+ * The graph is built on first use, which reads the text of all notes once.
+ */
+class LinkIndex
+{
+public:
+  typedef std::unordered_set<Glib::ustring, Hash<Glib::ustring>> StringSet;
+
+  // XML encoded titles of internal links in note XML
+  static StringSet extract_links(const Glib::ustring & xml);
+
+  explicit LinkIndex(NoteManagerBase & manager);
+
+  // URIs of notes, that link to the title
+  const StringSet & linking_notes(const Glib::ustring & title);
+  // XML encoded titles, the note links to
+  const StringSet & links(const Glib::ustring & uri);
+  // note content changed, but is not saved yet
+  void invalidate(const NoteBase & note);
+  bool is_built() const
+    {
+      return m_built;
+    }
+private:
+  void build();
+  void refresh_invalidated();
+  void on_note_changed(NoteBase & note);
+  void on_note_deleted(NoteBase & note);
+  void set_links(const Glib::ustring & uri, StringSet && links);
+  void remove_links(const Glib::ustring & uri);
+
+  NoteManagerBase & m_manager;
+  std::unordered_map<Glib::ustring, StringSet, Hash<Glib::ustring>> m_links;
+  std::unordered_map<Glib::ustring, StringSet, Hash<Glib::ustring>> m_backlinks;
+  // URIs of notes, that have to be rescanned before lookup
+  StringSet m_invalidated;
+  bool m_built;
+};
+
+}
+
+#endif
@@ -27,10 +27,12 @@
 #include <glibmm/i18n.h>
 #include <gtkmm/button.h>
 
+#include "addinmanager.hpp"
 #include "ignote.hpp"
 #include "mainwindow.hpp"
 #include "note.hpp"
 #include "notemanager.hpp"
+#include "notewriter.hpp"
 #include "noterenamedialog.hpp"
 #include "notetag.hpp"
 #include "notewindow.hpp"
@@ -162,25 +164,46 @@ namespace gnote {
   void NoteDataBufferSynchronizer::set_buffer(Glib::RefPtr<NoteBuffer> && b)
   {
     m_buffer = std::move(b);
-    m_buffer->signal_changed().connect(sigc::mem_fun(*this, &NoteDataBufferSynchronizer::buffer_changed));
-    m_buffer->signal_apply_tag()
-      .connect(sigc::mem_fun(*this, &NoteDataBufferSynchronizer::buffer_tag_applied));
-    m_buffer->signal_remove_tag()
-      .connect(sigc::mem_fun(*this, &NoteDataBufferSynchronizer::buffer_tag_removed));
-
+    m_xml_cache = std::make_unique<NoteBufferXmlCache>(m_buffer);
+    m_buffer_cids.push_back(m_buffer->signal_changed()
+      .connect(sigc::mem_fun(*this, &NoteDataBufferSynchronizer::buffer_changed)));
+    m_buffer_cids.push_back(m_buffer->signal_apply_tag()
+      .connect(sigc::mem_fun(*this, &NoteDataBufferSynchronizer::buffer_tag_applied)));
+    m_buffer_cids.push_back(m_buffer->signal_remove_tag()
+      .connect(sigc::mem_fun(*this, &NoteDataBufferSynchronizer::buffer_tag_removed)));
+
+    // buffer is the source of text from now on
+    pin_text();
     synchronize_buffer();
 
     invalidate_text();
   }
 
+  void NoteDataBufferSynchronizer::release_buffer()
+  {
+    if(!m_buffer) {
+      return;
+    }
+
+    synchronize_text();
+    for(auto & cid : m_buffer_cids) {
+      cid.disconnect();
+    }
+    m_buffer_cids.clear();
+    m_xml_cache.reset();
+    m_buffer.reset();
+  }
+
   const Glib::ustring & NoteDataBufferSynchronizer::text() const
   {
+    ensure_text_loaded();
     synchronize_text();
     return data().text();
   }
 
   void NoteDataBufferSynchronizer::set_text(Glib::ustring && t)
   {
+    detach_text_cache();
     data().text() = std::move(t);
     synchronize_buffer();
   }
@@ -198,7 +221,7 @@ namespace gnote {
   void NoteDataBufferSynchronizer::synchronize_text() const
   {
     if(is_text_invalid() && m_buffer) {
-      const_cast<NoteData&>(data()).text() = NoteBufferArchiver::serialize(m_buffer);
+      const_cast<NoteData&>(data()).text() = m_xml_cache->serialize();
     }
   }
 
@@ -208,6 +231,7 @@ namespace gnote {
       // Don't create Undo actions during load
       m_buffer->undoer().freeze_undo ();
 
+      m_xml_cache->clear();
       m_buffer->erase(m_buffer->begin(), m_buffer->end());
 
       // Load the stored xml text
@@ -254,6 +278,7 @@ namespace gnote {
     , m_is_deleting(false)
     , m_note_window_embedded(false)
     , m_focus_widget(NULL)
+    , m_buffer_last_used(0)
     , m_tag_table(NULL)
   {
     for(const auto & iter : m_data.data().tags()) {
@@ -322,9 +347,21 @@ namespace gnote {
   
   Note::Ptr Note::load(Glib::ustring && read_file, NoteManager & manager, IGnote & g)
   {
-    auto data = std::make_unique<NoteData>(url_from_path(read_file));
-    manager.note_archiver().read_file(read_file, *data);
-    return create_existing_note(std::move(data), std::move(read_file), manager, g);
+    NoteArchiver::ParsedNote parsed;
+    parsed.file = std::move(read_file);
+    NoteArchiver::parse_file(parsed, !manager.note_text_cache());
+    return load(std::move(parsed), manager, g);
+  }
+
+  Note::Ptr Note::load(NoteArchiver::ParsedNote && parsed, NoteManager & manager, IGnote & g)
+  {
+    manager.note_archiver().read_parsed(parsed);
+    bool has_text = parsed.has_text;
+    auto note = create_existing_note(std::move(parsed.data), std::move(parsed.file), manager, g);
+    if(!has_text) {
+      note->m_data.set_text_lazy(manager.note_text_cache(), note->file_path());
+    }
+    return note;
   }
 
   
@@ -343,18 +380,20 @@ namespace gnote {
 
     DBG_OUT_2("Saving '%s'...", m_data.data().title().c_str());
 
-    try {
-      manager().note_archiver().write_file(file_path(), m_data.synchronized_data());
-    } 
-    catch (const sharp::Exception & e) {
-      // Probably IOException or UnauthorizedAccessException?
-      ERR_OUT(_("Exception while saving note: %s"), e.what());
-      show_io_error_dialog(dynamic_cast<Gtk::Window*>(m_window->host()));
-    }
+    // serialize here, file is written on background thread
+    auto content = manager().note_archiver().write_string(m_data.synchronized_data());
+    static_cast<NoteManager&>(manager()).note_writer().write(file_path(), std::move(content));
 
     signal_saved(*this);
   }
 
+  void Note::on_save_failed()
+  {
+    // try again on next save
+    m_save_needed = true;
+    show_io_error_dialog(m_window ? dynamic_cast<Gtk::Window*>(m_window->host()) : nullptr);
+  }
+
   
   void Note::on_buffer_changed()
   {
@@ -455,6 +494,8 @@ namespace gnote {
 
       Glib::ustring old_title = std::move(m_data.data().title());
       m_data.data().title() = std::move(new_title);
+      // lookup by the new title works, while rename dialog is shown
+      manager().note_title_changed(*this);
 
       if (from_user_action) {
         process_rename_link_update(old_title);
@@ -622,23 +663,57 @@ namespace gnote {
 
   const Glib::RefPtr<NoteBuffer> & Note::get_buffer()
   {
+    m_buffer_last_used = g_get_monotonic_time();
     if(!m_buffer) {
       DBG_OUT_3("Creating buffer for %s", m_data.data().title().c_str());
       m_buffer = NoteBuffer::create(get_tag_table(), *this, m_gnote.preferences());
       m_data.set_buffer(Glib::RefPtr<NoteBuffer>(m_buffer));
 
-      m_buffer->signal_changed().connect(
-        sigc::mem_fun(*this, &Note::on_buffer_changed));
-      m_buffer->signal_apply_tag().connect(
-        sigc::mem_fun(*this, &Note::on_buffer_tag_applied));
-      m_buffer->signal_remove_tag().connect(
-        sigc::mem_fun(*this, &Note::on_buffer_tag_removed));
+      m_buffer_cids.push_back(m_buffer->signal_changed().connect(
+        sigc::mem_fun(*this, &Note::on_buffer_changed)));
+      m_buffer_cids.push_back(m_buffer->signal_apply_tag().connect(
+        sigc::mem_fun(*this, &Note::on_buffer_tag_applied)));
+      m_buffer_cids.push_back(m_buffer->signal_remove_tag().connect(
+        sigc::mem_fun(*this, &Note::on_buffer_tag_removed)));
       m_mark_set_conn = m_buffer->signal_mark_set().connect(
         sigc::mem_fun(*this, &Note::on_buffer_mark_set));
     }
     return m_buffer;
   }
 
+  bool Note::release_buffer()
+  {
+    // shown windows and addins connected on opening use the buffer,
+    // queued child widgets are anchored in it
+    if(!m_buffer || (m_window && m_window->host()) || m_save_needed || m_is_deleting || !m_child_widget_queue.empty()) {
+      return false;
+    }
+
+    DBG_OUT_3("Releasing buffer of %s", m_data.data().title().c_str());
+    for(auto & cid : m_buffer_cids) {
+      cid.disconnect();
+    }
+    m_buffer_cids.clear();
+    m_mark_set_conn.disconnect();
+    m_data.release_buffer();
+    if(m_window) {
+      // Closed window holds the buffer and addins are connected to both since
+      // the note was opened. Addins are shut down while both are still there
+      // and created anew, so that they start over, when the note is opened again.
+      auto & addin_manager = static_cast<NoteManager&>(manager()).get_addin_manager();
+      addin_manager.unload_addins_for_note(*this);
+      m_window.reset();
+      m_note_window_embedded = false;
+      m_focus_widget = nullptr;
+      m_buffer.reset();
+      addin_manager.load_addins_for_note(*this);
+    }
+    else {
+      m_buffer.reset();
+    }
+    return true;
+  }
+
 
   NoteWindow * Note::create_window()
   {
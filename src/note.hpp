@@ -25,6 +25,7 @@
 #define __NOTE_HPP_
 
 #include <queue>
+#include <vector>
 
 #include <gtkmm/textbuffer.h>
 
@@ -52,11 +53,13 @@ public:
 
   virtual const NoteData & synchronized_data() const override
     {
+      ensure_text_loaded();
       synchronize_text();
       return data();
     }
   virtual NoteData & synchronized_data() override
     {
+      ensure_text_loaded();
       synchronize_text();
       return data();
     }
@@ -65,6 +68,8 @@ public:
       return m_buffer;
     }
   void set_buffer(Glib::RefPtr<NoteBuffer> && b);
+  // text becomes the source again
+  void release_buffer();
   const Glib::ustring & text() const override;
   void set_text(Glib::ustring && t) override;
 
@@ -82,6 +87,8 @@ private:
                           const Gtk::TextBuffer::iterator &);
 
   Glib::RefPtr<NoteBuffer> m_buffer;
+  std::unique_ptr<NoteBufferXmlCache> m_xml_cache;
+  std::vector<sigc::connection> m_buffer_cids;
 };
 
 
@@ -102,7 +109,10 @@ public:
 
   virtual void delete_note() override;
   static Note::Ptr load(Glib::ustring &&, NoteManager &, IGnote &);
+  static Note::Ptr load(NoteArchiver::ParsedNote &&, NoteManager &, IGnote &);
   virtual void save() override;
+  // writing the file on background thread failed
+  void on_save_failed();
   virtual void queue_save(ChangeType c) override;
   void add_child_widget(Glib::RefPtr<Gtk::TextChildAnchor> && child_anchor, Gtk::Widget *widget);
 
@@ -119,6 +129,20 @@ public:
       return (bool)m_buffer;
     }
   const Glib::RefPtr<NoteBuffer> & get_buffer();
+  // does not count as buffer use, null if there is no buffer
+  const Glib::RefPtr<NoteBuffer> & existing_buffer() const
+    {
+      return m_buffer;
+    }
+  // monotonic time of the last get_buffer() call
+  gint64 buffer_last_used() const
+    {
+      return m_buffer_last_used;
+    }
+  // Frees the buffer, if the note window is not shown and nothing is left to save.
+  // Closed window is freed too and note addins are created anew.
+  // The buffer and the window are created again on next access.
+  bool release_buffer();
   bool has_window() const 
     { 
       return (m_window != NULL); 
@@ -192,12 +216,14 @@ private:
   Gtk::Widget               *m_focus_widget;
   std::unique_ptr<NoteWindow> m_window;
   Glib::RefPtr<NoteBuffer>   m_buffer;
+  gint64                     m_buffer_last_used;
   Glib::RefPtr<NoteTagTable> m_tag_table;
 
   std::queue<ChildWidgetData> m_child_widget_queue;
 
   sigc::signal<void(Note&)> m_signal_opened;
 
+  std::vector<sigc::connection> m_buffer_cids;
   sigc::connection m_mark_set_conn;
   sigc::connection m_mark_deleted_conn;
 };
@@ -44,18 +44,101 @@ namespace gnote {
 
 NoteDataBufferSynchronizerBase::~NoteDataBufferSynchronizerBase()
 {
+  detach_text_cache();
 }
 
 const Glib::ustring & NoteDataBufferSynchronizerBase::text() const
 {
+  ensure_text_loaded();
   return data().text();
 }
 
 void NoteDataBufferSynchronizerBase::set_text(Glib::ustring && t)
 {
+  detach_text_cache();
   data().text() = std::move(t);
 }
 
+void NoteDataBufferSynchronizerBase::set_text_lazy(const std::shared_ptr<NoteTextCache> & cache, const Glib::ustring & file)
+{
+  detach_text_cache();
+  Glib::ustring().swap(data().text());
+  m_text_cache = cache;
+  m_text_file = file;
+  m_text_loaded = false;
+}
+
+void NoteDataBufferSynchronizerBase::ensure_text_loaded() const
+{
+  if(!m_text_cache) {
+    return;
+  }
+
+  auto & self = const_cast<NoteDataBufferSynchronizerBase&>(*this);
+  if(m_text_loaded) {
+    m_text_cache->touch(self);
+  }
+  else {
+    m_text_cache->load(self);
+  }
+}
+
+void NoteDataBufferSynchronizerBase::pin_text()
+{
+  ensure_text_loaded();
+  detach_text_cache();
+}
+
+void NoteDataBufferSynchronizerBase::detach_text_cache()
+{
+  if(m_text_cache) {
+    m_text_cache->remove(*this);
+    m_text_cache.reset();
+    m_text_file.clear();
+    m_text_loaded = false;
+  }
+}
+
+
+void NoteTextCache::load(NoteDataBufferSynchronizerBase & note)
+{
+  DBG_OUT_3("Loading text of %s", note.m_text_file.c_str());
+  note.data().text() = NoteArchiver::read_text(note.m_text_file);
+  note.m_text_loaded = true;
+  m_loaded.push_front(&note);
+  m_positions[&note] = m_loaded.begin();
+  evict();
+}
+
+void NoteTextCache::touch(NoteDataBufferSynchronizerBase & note)
+{
+  auto pos = m_positions.find(&note);
+  if(pos != m_positions.end() && pos->second != m_loaded.begin()) {
+    m_loaded.splice(m_loaded.begin(), m_loaded, pos->second);
+  }
+}
+
+void NoteTextCache::remove(NoteDataBufferSynchronizerBase & note)
+{
+  auto pos = m_positions.find(&note);
+  if(pos != m_positions.end()) {
+    m_loaded.erase(pos->second);
+    m_positions.erase(pos);
+  }
+}
+
+void NoteTextCache::evict()
+{
+  // always keep the most recently loaded one
+  while(m_loaded.size() > std::max<std::size_t>(m_capacity, 1)) {
+    NoteDataBufferSynchronizerBase *note = m_loaded.back();
+    m_loaded.pop_back();
+    m_positions.erase(note);
+    Glib::ustring().swap(note->data().text());
+    note->m_text_loaded = false;
+  }
+}
+
 
 
 Glib::ustring NoteBase::url_from_path(const Glib::ustring & filepath)
@@ -153,6 +236,7 @@ void NoteBase::set_title(Glib::ustring && new_title, bool from_user_action)
   if(data_synchronizer().data().title() != new_title) {
     Glib::ustring old_title = std::move(data_synchronizer().data().title());
     data_synchronizer().data().title() = std::move(new_title);
+    m_manager.note_title_changed(*this);
 
     if(from_user_action) {
       process_rename_link_update(old_title);
@@ -178,6 +262,7 @@ void NoteBase::rename_without_link_update(Glib::ustring && newTitle)
 {
   if(data_synchronizer().data().title() != newTitle) {
     data_synchronizer().data().title() = std::move(newTitle);
+    m_manager.note_title_changed(*this);
 
     // HACK:
     signal_renamed(*this, data_synchronizer().data().title());
@@ -215,7 +300,7 @@ void NoteBase::set_change_type(ChangeType c)
 void NoteBase::save()
 {
   try {
-    m_manager.note_archiver().write_file(m_file_path, data_synchronizer().data());
+    m_manager.note_archiver().write_file(m_file_path, data_synchronizer().synchronized_data());
   } 
   catch (const sharp::Exception & e) {
     // Probably IOException or UnauthorizedAccessException?
@@ -456,17 +541,67 @@ void NoteArchiver::read_file(const Glib::ustring & file, NoteData & data)
   sharp::XmlReader xml(file);
   _read(xml, data, version);
   if(version != NoteArchiver::CURRENT_VERSION) {
-    try {
-      // Note has old format, so rewrite it.  No need
-      // to reread, since we are not adding anything.
-      DBG_OUT_1("Updating note XML from %s to newest format...", version.c_str());
-      write_file(file, data);
-    }
-    catch(sharp::Exception & e) {
-      // write failure, but not critical
-      ERR_OUT(_("Failed to update note format: %s"), e.what());
+    update_format(file, data, version);
+  }
+}
+
+bool NoteArchiver::read_file_header(const Glib::ustring & file, NoteData & data)
+{
+  Glib::ustring version;
+  sharp::XmlReader xml(file);
+  _read(xml, data, version, false);
+  return version == NoteArchiver::CURRENT_VERSION;
+}
+
+void NoteArchiver::parse_file(ParsedNote & note, bool with_text)
+{
+  note.data = std::make_unique<NoteData>(NoteBase::url_from_path(note.file));
+  note.tags.clear();
+  note.version.clear();
+  note.has_text = with_text;
+  sharp::XmlReader xml(note.file);
+  parse(xml, *note.data, note.version, note.tags, with_text);
+}
+
+void NoteArchiver::read_parsed(ParsedNote & note)
+{
+  bool old_format = note.version != NoteArchiver::CURRENT_VERSION;
+  if(old_format && !note.has_text) {
+    // note is going to be rewritten, so text is required
+    parse_file(note, true);
+  }
+
+  add_tags(*note.data, note.tags);
+  if(old_format) {
+    update_format(note.file, *note.data, note.version);
+  }
+}
+
+void NoteArchiver::update_format(const Glib::ustring & file, const NoteData & data, const Glib::ustring & version)
+{
+  try {
+    // Note has old format, so rewrite it.  No need
+    // to reread, since we are not adding anything.
+    DBG_OUT_1("Updating note XML from %s to newest format...", version.c_str());
+    write_file(file, data);
+  }
+  catch(sharp::Exception & e) {
+    // write failure, but not critical
+    ERR_OUT(_("Failed to update note format: %s"), e.what());
+  }
+}
+
+Glib::ustring NoteArchiver::read_text(const Glib::ustring & file)
+{
+  sharp::XmlReader xml(file);
+  while(xml.read()) {
+    if(xml.get_node_type() == XML_READER_TYPE_ELEMENT && xml.get_name() == "text") {
+      return xml.read_inner_xml();
     }
   }
+
+  ERR_OUT("Failed to read text of note %s", file.c_str());
+  return "";
 }
 
 void NoteArchiver::read(sharp::XmlReader & xml, NoteData & data)
@@ -476,11 +611,27 @@ void NoteArchiver::read(sharp::XmlReader & xml, NoteData & data)
 }
 
 
-void NoteArchiver::_read(sharp::XmlReader & xml, NoteData & data, Glib::ustring & version)
+void NoteArchiver::_read(sharp::XmlReader & xml, NoteData & data, Glib::ustring & version, bool with_text)
+{
+  std::vector<Glib::ustring> tags;
+  parse(xml, data, version, tags, with_text);
+  add_tags(data, tags);
+}
+
+void NoteArchiver::add_tags(NoteData & data, const std::vector<Glib::ustring> & tags)
+{
+  for(const Glib::ustring & tag_str : tags) {
+    Tag &tag = m_manager.tag_manager().get_or_create_tag(tag_str);
+    data.tags().insert(tag.normalized_name());
+  }
+}
+
+void NoteArchiver::parse(sharp::XmlReader & xml, NoteData & data, Glib::ustring & version, std::vector<Glib::ustring> & tags, bool with_text)
 {
   Glib::ustring name;
 
-  while(xml.read ()) {
+  bool has_node = xml.read();
+  while(has_node) {
     switch(xml.get_node_type()) {
     case XML_READER_TYPE_ELEMENT:
       name = xml.get_name();
@@ -492,6 +643,11 @@ void NoteArchiver::_read(sharp::XmlReader & xml, NoteData & data, Glib::ustring
         data.title() = xml.read_string();
       } 
       else if(name == "text") {
+        if(!with_text) {
+          // don't even walk the contents, it can be large
+          has_node = xml.skip();
+          continue;
+        }
         // <text> is just a wrapper around <note-content>
         // NOTE: Use .text here to avoid triggering a save.
         data.text() = xml.read_inner_xml();
@@ -522,10 +678,7 @@ void NoteArchiver::_read(sharp::XmlReader & xml, NoteData & data, Glib::ustring
 
         if(doc2) {
           std::vector<Glib::ustring> tag_strings = NoteBase::parse_tags(doc2->children);
-          for(const Glib::ustring & tag_str : tag_strings) {
-            Tag &tag = m_manager.tag_manager().get_or_create_tag(tag_str);
-            data.tags().insert(tag.normalized_name());
-          }
+          tags.insert(tags.end(), tag_strings.begin(), tag_strings.end());
           xmlFreeDoc(doc2);
         }
         else {
@@ -537,6 +690,8 @@ void NoteArchiver::_read(sharp::XmlReader & xml, NoteData & data, Glib::ustring
     default:
       break;
     }
+
+    has_node = xml.read();
   }
   xml.close ();
 }
@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2011-2014,2017,2019-2024 Aurimas Cernius
+ * Copyright (C) 2011-2014,2017,2019-2024,2026 Aurimas Cernius
  * Copyright (C) 2009 Hubert Figuiere
  *
  * This program is free software: you can redistribute it and/or modify
@@ -22,8 +22,11 @@
 #ifndef _NOTEBASE_HPP_
 #define _NOTEBASE_HPP_
 
+#include <list>
 #include <map>
+#include <memory>
 #include <optional>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -41,6 +44,7 @@
 namespace gnote {
 
 class NoteManagerBase;
+class NoteTextCache;
 
 
 class NoteData
@@ -161,6 +165,7 @@ class NoteDataBufferSynchronizerBase
 public:
   NoteDataBufferSynchronizerBase(std::unique_ptr<NoteData> && _data)
     : m_data(std::move(_data))
+    , m_text_loaded(false)
     {}
   virtual ~NoteDataBufferSynchronizerBase();
   const NoteData & data() const
@@ -173,16 +178,71 @@ public:
     }
   virtual const NoteData & synchronized_data() const
     {
+      ensure_text_loaded();
       return *m_data;
     }
   virtual NoteData & synchronized_data()
     {
+      ensure_text_loaded();
       return *m_data;
     }
   virtual const Glib::ustring & text() const;
   virtual void set_text(Glib::ustring && t);
+  // Text is not read yet, it will be read from file when first accessed
+  void set_text_lazy(const std::shared_ptr<NoteTextCache> & cache, const Glib::ustring & file);
+  bool is_text_loaded() const
+    {
+      return !m_text_cache || m_text_loaded;
+    }
+protected:
+  void ensure_text_loaded() const;
+  // Keep the text in memory, it is going to be changed
+  void pin_text();
+  void detach_text_cache();
 private:
+  friend class NoteTextCache;
+
   std::unique_ptr<NoteData> m_data;
+  std::shared_ptr<NoteTextCache> m_text_cache;
+  Glib::ustring m_text_file;
+  mutable bool m_text_loaded;
+};
+
+
+/**
+ * Keeps the texts of notes, that were loaded without them.
+ *
+ * Text is read from note file on first access. Only a limited number of
+ * unmodified texts is kept in memory, the least recently used ones are dropped
+ * and read again when needed. Once the text is modified, the note no longer
+ * uses the cache. Not thread safe, notes are only accessed on main thread.
+ */
+class NoteTextCache
+{
+public:
+  explicit NoteTextCache(std::size_t capacity)
+    : m_capacity(capacity)
+    {}
+  std::size_t capacity() const
+    {
+      return m_capacity;
+    }
+  std::size_t size() const
+    {
+      return m_loaded.size();
+    }
+  void load(NoteDataBufferSynchronizerBase & note);
+  void touch(NoteDataBufferSynchronizerBase & note);
+  void remove(NoteDataBufferSynchronizerBase & note);
+private:
+  typedef std::list<NoteDataBufferSynchronizerBase*> LoadedList;
+
+  void evict();
+
+  const std::size_t m_capacity;
+  // most recently used first
+  LoadedList m_loaded;
+  std::unordered_map<NoteDataBufferSynchronizerBase*, LoadedList::iterator> m_positions;
 };
 
 
@@ -238,6 +298,11 @@ public:
       return data_synchronizer().text();
     }
   virtual void set_xml_content(Glib::ustring && xml);
+  // xml_content() does not have to read the note file
+  bool is_text_loaded() const
+    {
+      return data_synchronizer().is_text_loaded();
+    }
   virtual Glib::ustring text_content();
   void load_foreign_note_xml(const Glib::ustring & foreignNoteXml, ChangeType changeType);
   std::vector<Tag::Ref> get_tags() const;
@@ -282,11 +347,31 @@ class NoteArchiver
 public:
   static const char *CURRENT_VERSION;
 
+  /** Note file parsed without touching the note manager */
+  struct ParsedNote
+  {
+    Glib::ustring file;
+    std::unique_ptr<NoteData> data;
+    // tags as found in the file, not created yet
+    std::vector<Glib::ustring> tags;
+    Glib::ustring version;
+    bool has_text = false;
+    Glib::ustring error;
+  };
+
+  static Glib::ustring read_text(const Glib::ustring & file);
+  // Parse the note file, can be called on any thread
+  static void parse_file(ParsedNote & note, bool with_text);
+
   explicit NoteArchiver(NoteManagerBase & manager)
     : m_manager(manager)
   {}
   void read_file(const Glib::ustring & file, NoteData & data);
+  // Read everything, except the text. Returns false, if note is in old format and has to be read fully.
+  bool read_file_header(const Glib::ustring & file, NoteData & data);
   void read(sharp::XmlReader & xml, NoteData & data);
+  // Complete reading of the note parsed by parse_file, main thread only
+  void read_parsed(ParsedNote & note);
   Glib::ustring write_string(const NoteData & data);
   void write_file(const Glib::ustring & write_file, const NoteData & data);
   void write(sharp::XmlWriter & xml, const NoteData & data);
@@ -294,8 +379,12 @@ public:
   Glib::ustring get_renamed_note_xml(const Glib::ustring &, const Glib::ustring &, const Glib::ustring &) const;
   Glib::ustring get_title_from_note_xml(const Glib::ustring & noteXml) const;
 protected:
-  void _read(sharp::XmlReader & xml, NoteData & data, Glib::ustring & version);
+  void _read(sharp::XmlReader & xml, NoteData & data, Glib::ustring & version, bool with_text = true);
 private:
+  static void parse(sharp::XmlReader & xml, NoteData & data, Glib::ustring & version, std::vector<Glib::ustring> & tags, bool with_text);
+  void add_tags(NoteData & data, const std::vector<Glib::ustring> & tags);
+  void update_format(const Glib::ustring & file, const NoteData & data, const Glib::ustring & version);
+
   NoteManagerBase & m_manager;
 };
 
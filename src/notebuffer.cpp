@@ -22,6 +22,7 @@
 
 #include <algorithm>
 #include <array>
+#include <stack>
 
 #include <glibmm/i18n.h>
 #include <glibmm/main.h>
@@ -911,10 +912,12 @@ namespace gnote {
 
     DepthNoteTag::Ptr tag = note_table->get_depth_tag(depth);
 
-    Glib::ustring bullet =
-      Glib::ustring(1, s_indent_bullets [depth % NUM_INDENT_BULLETS]) + " ";
+    iter = insert_with_tag (iter, get_bullet(depth), tag);
+  }
 
-    iter = insert_with_tag (iter, bullet, tag);
+  Glib::ustring NoteBuffer::get_bullet(int depth)
+  {
+    return Glib::ustring(1, s_indent_bullets [depth % NUM_INDENT_BULLETS]) + " ";
   }
 
   void NoteBuffer::remove_bullet(Gtk::TextIter & iter)
@@ -1017,7 +1020,7 @@ namespace gnote {
   }
 
 
-  DepthNoteTag::Ptr NoteBuffer::find_depth_tag(Gtk::TextIter & iter)
+  DepthNoteTag::Ptr NoteBuffer::find_depth_tag(const Gtk::TextIter & iter)
   {
     DepthNoteTag::Ptr depth_tag;
 
@@ -1041,6 +1044,15 @@ namespace gnote {
     move_mark(get_insert(), end());
   }
 
+  namespace {
+    // markup and multibyte characters take some more
+    std::size_t estimate_xml_size(std::size_t chars)
+    {
+      return chars + chars / 4 + 256;
+    }
+  }
+
+
   Glib::ustring NoteBufferArchiver::serialize(const Glib::RefPtr<Gtk::TextBuffer> & buffer)
   {
     return serialize(buffer, buffer->begin(), buffer->end());
@@ -1051,8 +1063,8 @@ namespace gnote {
                                             const Gtk::TextIter & start,
                                             const Gtk::TextIter & end)
   {
-    sharp::XmlWriter xml;
-    
+    sharp::XmlWriter xml(estimate_xml_size(end.get_offset() - start.get_offset()));
+
     serialize(buffer, start, end, xml);
     xml.close();
     Glib::ustring serializedBuffer = xml.to_string();
@@ -1086,235 +1098,601 @@ namespace gnote {
   }
 
   
-  // This is taken almost directly from GAIM.  There must be a
+  // Walks the buffer writing XML for it. Characters in the middle of a
+  // line between tag toggles are written out as a single run, the rest
+  // one character at a time.
+  // The latter is taken almost directly from GAIM.  There must be a
   // better way to do this...
-  void NoteBufferArchiver::serialize(const Glib::RefPtr<Gtk::TextBuffer> & buffer, 
-                                     const Gtk::TextIter & start,
-                                     const Gtk::TextIter & end, sharp::XmlWriter & xml)
+  class NoteBufferArchiver::Serializer
   {
-    std::stack<Glib::RefPtr<const Gtk::TextTag> > tag_stack;
-    std::stack<Glib::RefPtr<const Gtk::TextTag> > replay_stack;
-    std::stack<Glib::RefPtr<const Gtk::TextTag> > continue_stack;
+  public:
+    Serializer(const Glib::RefPtr<Gtk::TextBuffer> & buffer, sharp::XmlWriter & xml)
+      : m_buffer(buffer)
+      , m_xml(&xml)
+      , m_line_has_depth(false)
+      , m_prev_depth_line(-1)
+      , m_prev_depth(-1)
+      {}
 
-    Gtk::TextIter iter = start;
-    Gtk::TextIter next_iter = start;
-    next_iter.forward_char();
+    void set_writer(sharp::XmlWriter & xml)
+      {
+        m_xml = &xml;
+      }
+    // open tags, that are active at start, but not started by it
+    void start(const Gtk::TextIter & start);
+    // serialize characters from iter up to end or line end at most and
+    // move iter past them
+    void write_next(Gtk::TextIter & iter, const Gtk::TextIter & end);
+    // close all tags left open
+    void finish();
+    // whether serialization can be started anew at line start iter
+    bool is_clean(const Gtk::TextIter & iter) const
+      {
+        return m_tag_stack.empty() && m_continue_stack.empty() && m_prev_depth == -1
+          && !m_line_has_depth && !NoteBuffer::find_depth_tag(iter);
+      }
+  private:
+    static Gtk::TextIter plain_run_end(const Gtk::TextIter & iter, const Gtk::TextIter & end);
+    void write_char(Gtk::TextIter & iter);
+
+    const Glib::RefPtr<Gtk::TextBuffer> & m_buffer;
+    sharp::XmlWriter *m_xml;
+    std::stack<Glib::RefPtr<const Gtk::TextTag> > m_tag_stack;
+    std::stack<Glib::RefPtr<const Gtk::TextTag> > m_replay_stack;
+    std::stack<Glib::RefPtr<const Gtk::TextTag> > m_continue_stack;
+    bool m_line_has_depth;
+    int m_prev_depth_line;
+    int m_prev_depth;
+  };
 
-    bool line_has_depth = false;
-    int prev_depth_line = -1;
-    int prev_depth = -1;
-
-    xml.write_start_element ("", "note-content", "");
-    xml.write_attribute_string ("", "version", "", "0.1");
-    xml.write_attribute_string("xmlns",
-                               "link",
-                               "",
-                               "http://beatniksoftware.com/tomboy/link");
-    xml.write_attribute_string("xmlns",
-                               "size",
-                               "",
-                               "http://beatniksoftware.com/tomboy/size");
 
+  void NoteBufferArchiver::Serializer::start(const Gtk::TextIter & start)
+  {
     // Insert any active tags at start into tag_stack...
     for(const auto & start_tag : start.get_tags()) {
       if (!start.toggles_tag (start_tag)) {
-        tag_stack.push (start_tag);
-        write_tag (start_tag, xml, true);
+        m_tag_stack.push (start_tag);
+        write_tag (start_tag, *m_xml, true);
       }
     }
+  }
 
-    while ((iter != end) && iter.get_char()) {
-      DepthNoteTag::Ptr depth_tag = std::static_pointer_cast<NoteBuffer>(buffer)->find_depth_tag (iter);
 
-      // If we are at a character with a depth tag we are at the
-      // start of a bulleted line
-      if (depth_tag && iter.starts_line()) {
-        line_has_depth = true;
+  // Characters from iter to the returned one only need to be written out:
+  // they don't start or end lines or tags, the ones next to them don't end
+  // lines or tags either, and they are neither anchors nor line separators.
+  Gtk::TextIter NoteBufferArchiver::Serializer::plain_run_end(const Gtk::TextIter & iter,
+                                                             const Gtk::TextIter & end)
+  {
+    if (iter.get_line_offset() < 2 || iter.ends_line() || iter.toggles_tag(Glib::RefPtr<Gtk::TextTag>())) {
+      return iter;
+    }
 
-        if (iter.get_line() == prev_depth_line + 1) {
-          // Line part of existing list
+    Gtk::TextIter limit = iter;
+    limit.forward_to_line_end();
+    Gtk::TextIter toggle = iter;
+    toggle.forward_to_tag_toggle(Glib::RefPtr<Gtk::TextTag>());
+    if (toggle < limit) {
+      limit = toggle;
+    }
+    // the last character before toggle or line end is not plain
+    if (end < limit) {
+      limit = end;
+    }
+    else {
+      limit.backward_char();
+    }
+    return limit;
+  }
 
-          if (depth_tag->get_depth() == prev_depth) {
-            // Line same depth as previous
-            // Close previous <list-item>
-            xml.write_end_element ();
 
-          }
-          else if (depth_tag->get_depth() > prev_depth) {
-            // Line of greater depth
-            xml.write_start_element ("", "list", "");
+  void NoteBufferArchiver::Serializer::write_next(Gtk::TextIter & iter, const Gtk::TextIter & end)
+  {
+    Gtk::TextIter run_end = plain_run_end(iter, end);
+    if (run_end <= iter) {
+      write_char(iter);
+      return;
+    }
 
-            for (int i = prev_depth + 2; i <= depth_tag->get_depth(); i++) {
-              // Start a new nested list
-              xml.write_start_element ("", "list-item", "");
-              xml.write_start_element ("", "list", "");
-            }
-          } 
-          else {
-            // Line of lesser depth
-            // Close previous <list-item>
-            // and nested <list>s
-            xml.write_end_element ();
+    Glib::ustring text = iter.get_slice(run_end);
+    auto special = std::min(text.find(gunichar(0xFFFC)), text.find(gunichar(0x2028)));
+    if (special == 0) {
+      write_char(iter);
+      return;
+    }
+    if (special != Glib::ustring::npos) {
+      text.erase(special);
+      run_end = iter;
+      run_end.forward_chars(special);
+    }
 
-            for (int i = prev_depth; i > depth_tag->get_depth(); i--) {
-              // Close nested <list>
-              xml.write_end_element ();
-              // Close <list-item>
-              xml.write_end_element ();
-            }
-          }
-        } 
-        else {
-          // Start of new list
+    if (!NoteBuffer::find_depth_tag(iter)) {
+      m_xml->write_string(text);
+    }
+    iter = run_end;
+  }
+
+
+  void NoteBufferArchiver::Serializer::write_char(Gtk::TextIter & iter)
+  {
+    sharp::XmlWriter & xml = *m_xml;
+    Gtk::TextIter next_iter = iter;
+    next_iter.forward_char();
+
+    DepthNoteTag::Ptr depth_tag = NoteBuffer::find_depth_tag (iter);
+
+    // If we are at a character with a depth tag we are at the
+    // start of a bulleted line
+    if (depth_tag && iter.starts_line()) {
+      m_line_has_depth = true;
+
+      if (iter.get_line() == m_prev_depth_line + 1) {
+        // Line part of existing list
+
+        if (depth_tag->get_depth() == m_prev_depth) {
+          // Line same depth as previous
+          // Close previous <list-item>
+          xml.write_end_element ();
+
+        }
+        else if (depth_tag->get_depth() > m_prev_depth) {
+          // Line of greater depth
           xml.write_start_element ("", "list", "");
-          for (int i = 1; i <= depth_tag->get_depth(); i++) {
+
+          for (int i = m_prev_depth + 2; i <= depth_tag->get_depth(); i++) {
+            // Start a new nested list
             xml.write_start_element ("", "list-item", "");
             xml.write_start_element ("", "list", "");
           }
+        } 
+        else {
+          // Line of lesser depth
+          // Close previous <list-item>
+          // and nested <list>s
+          xml.write_end_element ();
+
+          for (int i = m_prev_depth; i > depth_tag->get_depth(); i--) {
+            // Close nested <list>
+            xml.write_end_element ();
+            // Close <list-item>
+            xml.write_end_element ();
+          }
+        }
+      } 
+      else {
+        // Start of new list
+        xml.write_start_element ("", "list", "");
+        for (int i = 1; i <= depth_tag->get_depth(); i++) {
+          xml.write_start_element ("", "list-item", "");
+          xml.write_start_element ("", "list", "");
         }
+      }
 
-        prev_depth = depth_tag->get_depth();
+      m_prev_depth = depth_tag->get_depth();
 
-        // Start a new <list-item>
-        write_tag (depth_tag, xml, true);
-      }
+      // Start a new <list-item>
+      write_tag (depth_tag, xml, true);
+    }
 
-      // Output any tags that begin at the current position
-      for(const auto& tag : iter.get_tags()) {
-        if(iter.starts_tag(tag)) {
-          if (!std::dynamic_pointer_cast<DepthNoteTag>(tag) && NoteTagTable::tag_is_serializable(tag)) {
-            write_tag (tag, xml, true);
-            tag_stack.push (tag);
-          }
+    // Output any tags that begin at the current position
+    for(const auto& tag : iter.get_tags()) {
+      if(iter.starts_tag(tag)) {
+        if (!std::dynamic_pointer_cast<DepthNoteTag>(tag) && NoteTagTable::tag_is_serializable(tag)) {
+          write_tag (tag, xml, true);
+          m_tag_stack.push (tag);
         }
       }
+    }
+
+    // Reopen tags that continued across indented lines
+    // or into or out of lines with a depth
+    while (!m_continue_stack.empty() &&
+           ((!depth_tag && iter.starts_line ()) || (iter.get_line_offset() == 1)))
+    {
+      Glib::RefPtr<const Gtk::TextTag> continue_tag = m_continue_stack.top();
+      m_continue_stack.pop();
 
-      // Reopen tags that continued across indented lines
-      // or into or out of lines with a depth
-      while (!continue_stack.empty() &&
-             ((!depth_tag && iter.starts_line ()) || (iter.get_line_offset() == 1)))
+      if (!tag_ends_here (continue_tag, iter, next_iter)
+          && iter.has_tag (continue_tag))
       {
-        Glib::RefPtr<const Gtk::TextTag> continue_tag = continue_stack.top();
-        continue_stack.pop();
+        write_tag (continue_tag, xml, true);
+        m_tag_stack.push (continue_tag);
+      }
+    }
 
-        if (!tag_ends_here (continue_tag, iter, next_iter)
-            && iter.has_tag (continue_tag))
-        {
-          write_tag (continue_tag, xml, true);
-          tag_stack.push (continue_tag);
+    // Hidden character representing an anchor
+    if (iter.get_char() == 0xFFFC) {
+      DBG_OUT_3("Got child anchor!!!");
+      if (iter.get_child_anchor()) {
+        const char * serialize = (const char*)(iter.get_child_anchor()->get_data(Glib::Quark("serialize")));
+        if (serialize)
+          xml.write_raw (serialize);
+      }
+      // Line Separator character
+    } 
+    else if (iter.get_char() == 0x2028) {
+      xml.write_char_entity (0x2028);
+    } 
+    else if (!depth_tag) {
+      xml.write_string (Glib::ustring(1, (gunichar)iter.get_char()));
+    }
+
+    bool end_of_depth_line = m_line_has_depth && next_iter.ends_line ();
+
+    bool at_empty_line = iter.ends_line () && iter.starts_line ();
+
+    // only matters at the end of line
+    bool next_line_has_depth = false;
+    if (next_iter.ends_line () || at_empty_line) {
+      Gtk::TextIter next_line = iter;
+      if (next_line.forward_line ()) {
+        next_line_has_depth = (bool)NoteBuffer::find_depth_tag (next_line);
+      }
+    }
+
+    if (end_of_depth_line ||
+        (next_line_has_depth && (next_iter.ends_line () || at_empty_line)))
+    {
+      // Close all tags in the tag_stack
+      while (!m_tag_stack.empty()) {
+        Glib::RefPtr<const Gtk::TextTag> existing_tag;
+        existing_tag = m_tag_stack.top();
+        m_tag_stack.pop ();
+
+        // Any tags which continue across the indented
+        // line are added to the continue_stack to be
+        // reopened at the start of the next <list-item>
+        if (!tag_ends_here (existing_tag, iter, next_iter)) {
+          m_continue_stack.push (existing_tag);
         }
+
+        write_tag (existing_tag, xml, false);
       }
+    } 
+    else {
+      for(const auto& tag : iter.get_tags()) {
+        if (tag_ends_here (tag, iter, next_iter) &&
+            NoteTagTable::tag_is_serializable(tag) && !std::dynamic_pointer_cast<DepthNoteTag>(tag))
+        {
+          while (!m_tag_stack.empty()) {
+            Glib::RefPtr<const Gtk::TextTag> existing_tag = m_tag_stack.top();
+            m_tag_stack.pop();
 
-      // Hidden character representing an anchor
-      if (iter.get_char() == 0xFFFC) {
-        DBG_OUT_3("Got child anchor!!!");
-        if (iter.get_child_anchor()) {
-          const char * serialize = (const char*)(iter.get_child_anchor()->get_data(Glib::Quark("serialize")));
-          if (serialize)
-            xml.write_raw (serialize);
+            if (!tag_ends_here (existing_tag, iter, next_iter)) {
+              m_replay_stack.push (existing_tag);
+            }
+
+            write_tag (existing_tag, xml, false);
+          }
+
+          // Replay the replay queue.
+          // Restart any tags that
+          // overlapped with the ended
+          // tag...
+          while (!m_replay_stack.empty()) {
+            Glib::RefPtr<const Gtk::TextTag> replay_tag = m_replay_stack.top();
+            m_replay_stack.pop();
+            m_tag_stack.push (replay_tag);
+
+            write_tag (replay_tag, xml, true);
+          }
         }
-        // Line Separator character
-      } 
-      else if (iter.get_char() == 0x2028) {
-        xml.write_char_entity (0x2028);
-      } 
-      else if (!depth_tag) {
-        xml.write_string (Glib::ustring(1, (gunichar)iter.get_char()));
       }
+    }
 
-      bool end_of_depth_line = line_has_depth && next_iter.ends_line ();
+    // At the end of the line record that it
+    // was the last line encountered with a depth
+    if (end_of_depth_line) {
+      m_line_has_depth = false;
+      m_prev_depth_line = iter.get_line();
+    }
 
-      bool next_line_has_depth = false;
-      if (iter.get_line() < buffer->get_line_count() - 1) {
-        Gtk::TextIter next_line = buffer->get_iter_at_line(iter.get_line()+1);
-        next_line_has_depth = (bool)std::static_pointer_cast<NoteBuffer>(buffer)->find_depth_tag (next_line);
+    // If we are at the end of a line with a depth and the
+    // next line does not have a depth line close all <list>
+    // and <list-item> tags that remain open
+    if (end_of_depth_line && !next_line_has_depth) {
+      for (int i = m_prev_depth; i > -1; i--) {
+        // Close <list>
+        xml.write_full_end_element ();
+        // Close <list-item>
+        xml.write_full_end_element ();
       }
 
-      bool at_empty_line = iter.ends_line () && iter.starts_line ();
+      m_prev_depth = -1;
+    }
 
-      if (end_of_depth_line ||
-          (next_line_has_depth && (next_iter.ends_line () || at_empty_line)))
-      {
-        // Close all tags in the tag_stack
-        while (!tag_stack.empty()) {
-          Glib::RefPtr<const Gtk::TextTag> existing_tag;
-          existing_tag = tag_stack.top();
-          tag_stack.pop ();
-
-          // Any tags which continue across the indented
-          // line are added to the continue_stack to be
-          // reopened at the start of the next <list-item>
-          if (!tag_ends_here (existing_tag, iter, next_iter)) {
-            continue_stack.push (existing_tag);
-          }
+    iter = next_iter;
+  }
+
+
+  void NoteBufferArchiver::Serializer::finish()
+  {
+    // Empty any trailing tags left in tag_stack..
+    while (!m_tag_stack.empty()) {
+      Glib::RefPtr<const Gtk::TextTag> tail_tag = m_tag_stack.top ();
+      m_tag_stack.pop();
+      write_tag (tail_tag, *m_xml, false);
+    }
+  }
+
+
+  void NoteBufferArchiver::write_content_start(sharp::XmlWriter & xml)
+  {
+    xml.write_start_element ("", "note-content", "");
+    xml.write_attribute_string ("", "version", "", "0.1");
+    xml.write_attribute_string("xmlns",
+                               "link",
+                               "",
+                               "http://beatniksoftware.com/tomboy/link");
+    xml.write_attribute_string("xmlns",
+                               "size",
+                               "",
+                               "http://beatniksoftware.com/tomboy/size");
+  }
+
+
+  void NoteBufferArchiver::serialize(const Glib::RefPtr<Gtk::TextBuffer> & buffer, 
+                                     const Gtk::TextIter & start,
+                                     const Gtk::TextIter & end, sharp::XmlWriter & xml)
+  {
+    write_content_start(xml);
 
-          write_tag (existing_tag, xml, false);
+    Serializer serializer(buffer, xml);
+    serializer.start(start);
+    Gtk::TextIter iter = start;
+    while ((iter != end) && iter.get_char()) {
+      serializer.write_next(iter, end);
+    }
+    serializer.finish();
+
+    xml.write_end_element (); // </note-content>
+  }
+
+
+  const int NoteBufferXmlCache::BLOCK_LINES = 16;
+
+  namespace {
+    // Element wrapping a block while it is serialized, so that text in it is
+    // escaped the same way as in note-content.
+    const char *const BLOCK_ELEMENT = "b";
+    const Glib::ustring::size_type BLOCK_ELEMENT_START_LENGTH = 3;  // <b>
+
+    class BlockWriter
+    {
+    public:
+      BlockWriter()
+        : m_xml(std::make_unique<sharp::XmlWriter>())
+        {
+          start();
         }
-      } 
-      else {
-        for(const auto& tag : iter.get_tags()) {
-          if (tag_ends_here (tag, iter, next_iter) &&
-              NoteTagTable::tag_is_serializable(tag) && !std::dynamic_pointer_cast<DepthNoteTag>(tag))
-          {
-            while (!tag_stack.empty()) {
-              Glib::RefPtr<const Gtk::TextTag> existing_tag = tag_stack.top();
-              tag_stack.pop();
 
-              if (!tag_ends_here (existing_tag, iter, next_iter)) {
-                replay_stack.push (existing_tag);
-              }
+      sharp::XmlWriter & xml()
+        {
+          return *m_xml;
+        }
 
-              write_tag (existing_tag, xml, false);
-            }
+      // returns XML written since the last call
+      Glib::ustring take()
+        {
+          m_xml->flush();
+          Glib::ustring block = m_xml->to_string().substr(BLOCK_ELEMENT_START_LENGTH);
+          m_xml = std::make_unique<sharp::XmlWriter>();
+          start();
+          return block;
+        }
+    private:
+      void start()
+        {
+          m_xml->write_start_element("", BLOCK_ELEMENT, "");
+          m_xml->write_raw("");
+        }
+
+      std::unique_ptr<sharp::XmlWriter> m_xml;
+    };
+  }
+
+
+  NoteBufferXmlCache::NoteBufferXmlCache(const Glib::RefPtr<Gtk::TextBuffer> & buffer)
+    : m_buffer(buffer)
+  {
+    // connect before default handlers, while the ranges are still valid
+    m_connections.push_back(m_buffer->signal_insert()
+      .connect(sigc::mem_fun(*this, &NoteBufferXmlCache::on_insert), false));
+    m_connections.push_back(m_buffer->signal_erase()
+      .connect(sigc::mem_fun(*this, &NoteBufferXmlCache::on_erase), false));
+    m_connections.push_back(m_buffer->signal_apply_tag()
+      .connect(sigc::mem_fun(*this, &NoteBufferXmlCache::on_tag_changed), false));
+    m_connections.push_back(m_buffer->signal_remove_tag()
+      .connect(sigc::mem_fun(*this, &NoteBufferXmlCache::on_tag_changed), false));
+    m_connections.push_back(m_buffer->signal_insert_child_anchor()
+      .connect(sigc::mem_fun(*this, &NoteBufferXmlCache::on_insert_anchor), false));
+    m_connections.push_back(m_buffer->signal_insert_paintable()
+      .connect(sigc::mem_fun(*this, &NoteBufferXmlCache::on_insert_paintable), false));
+  }
+
+
+  NoteBufferXmlCache::~NoteBufferXmlCache()
+  {
+    for(auto & connection : m_connections) {
+      connection.disconnect();
+    }
+    clear();
+  }
+
+
+  void NoteBufferXmlCache::clear()
+  {
+    for(auto & block : m_blocks) {
+      m_buffer->delete_mark(block.start);
+    }
+    m_blocks.clear();
+  }
+
+
+  Glib::ustring NoteBufferXmlCache::serialize()
+  {
+    if(m_buffer->size() == 0) {
+      clear();
+      return NoteBufferArchiver::serialize(m_buffer);
+    }
 
-            // Replay the replay queue.
-            // Restart any tags that
-            // overlapped with the ended
-            // tag...
-            while (!replay_stack.empty()) {
-              Glib::RefPtr<const Gtk::TextTag> replay_tag = replay_stack.top();
-              replay_stack.pop();
-              tag_stack.push (replay_tag);
+    // drop blocks that became empty
+    std::vector<Block> old_blocks;
+    std::vector<int> old_offsets;
+    old_blocks.reserve(m_blocks.size());
+    old_offsets.reserve(m_blocks.size());
+    for(auto & block : m_blocks) {
+      int offset = block.start->get_iter().get_offset();
+      if(!old_offsets.empty() && old_offsets.back() == offset) {
+        m_buffer->delete_mark(old_blocks.back().start);
+        old_blocks.pop_back();
+        old_offsets.pop_back();
+      }
+      old_blocks.push_back(std::move(block));
+      old_offsets.push_back(offset);
+    }
+    m_blocks.clear();
+    if(old_blocks.empty()) {
+      old_blocks.push_back(Block{m_buffer->create_mark(m_buffer->begin(), true), "", false});
+      old_offsets.push_back(0);
+    }
 
-              write_tag (replay_tag, xml, true);
+    sharp::XmlWriter xml(estimate_xml_size(m_buffer->size()));
+    NoteBufferArchiver::write_content_start(xml);
+    // close the start tag, blocks go inside it
+    xml.write_raw("");
+    bool has_content = false;
+    auto append = [this, &xml, &has_content](Block && block) {
+      if(!block.xml.empty()) {
+        xml.write_raw(block.xml);
+        has_content = true;
+      }
+      m_blocks.push_back(std::move(block));
+    };
+
+    std::size_t i = 0;
+    while(i < old_blocks.size()) {
+      if(old_blocks[i].valid) {
+        append(std::move(old_blocks[i++]));
+        continue;
+      }
+
+      // serialize until the start of a valid block, if the state allows to
+      // continue from there, splitting into new blocks on the way
+      BlockWriter writer;
+      NoteBufferArchiver::Serializer serializer(m_buffer, writer.xml());
+      Block block{old_blocks[i].start, "", true};
+      Gtk::TextIter iter = block.start->get_iter();
+      Gtk::TextIter end = m_buffer->end();
+      ++i;
+      int lines = 0;
+      while(iter != end) {
+        if(iter.starts_line()) {
+          if(lines > 0 && serializer.is_clean(iter)) {
+            int offset = iter.get_offset();
+            for(; i < old_blocks.size() && old_offsets[i] < offset; ++i) {
+              m_buffer->delete_mark(old_blocks[i].start);
+            }
+            bool at_valid = i < old_blocks.size() && old_offsets[i] == offset && old_blocks[i].valid;
+            if(at_valid || lines >= BLOCK_LINES) {
+              block.xml = writer.take();
+              serializer.set_writer(writer.xml());
+              append(std::move(block));
+              if(at_valid) {
+                break;
+              }
+              if(i < old_blocks.size() && old_offsets[i] == offset) {
+                block = Block{old_blocks[i++].start, "", true};
+              }
+              else {
+                block = Block{m_buffer->create_mark(iter, true), "", true};
+              }
+              lines = 0;
             }
           }
+          ++lines;
         }
+        serializer.write_next(iter, end);
       }
 
-      // At the end of the line record that it
-      // was the last line encountered with a depth
-      if (end_of_depth_line) {
-        line_has_depth = false;
-        prev_depth_line = iter.get_line();
+      if(iter == end) {
+        serializer.finish();
+        block.xml = writer.take();
+        append(std::move(block));
+        for(; i < old_blocks.size(); ++i) {
+          m_buffer->delete_mark(old_blocks[i].start);
+        }
       }
+    }
 
-      // If we are at the end of a line with a depth and the
-      // next line does not have a depth line close all <list>
-      // and <list-item> tags that remain open
-      if (end_of_depth_line && !next_line_has_depth) {
-        for (int i = prev_depth; i > -1; i--) {
-          // Close <list>
-          xml.write_full_end_element ();
-          // Close <list-item>
-          xml.write_full_end_element ();
-        }
+    if(!has_content) {
+      // start tag would be self-closing
+      return NoteBufferArchiver::serialize(m_buffer);
+    }
+    xml.write_end_element(); // </note-content>
+    xml.close();
+    return xml.to_string();
+  }
 
-        prev_depth = -1;
-      }
 
-      iter.forward_char();
-      next_iter.forward_char();
+  std::size_t NoteBufferXmlCache::block_at(int offset) const
+  {
+    // last block starting at or before offset
+    auto iter = std::upper_bound(m_blocks.begin(), m_blocks.end(), offset,
+      [](int off, const Block & block) {
+        return off < block.start->get_iter().get_offset();
+      });
+    return iter == m_blocks.begin() ? 0 : iter - m_blocks.begin() - 1;
+  }
+
+
+  void NoteBufferXmlCache::invalidate(int start, int end)
+  {
+    if(m_blocks.empty()) {
+      return;
     }
 
-    // Empty any trailing tags left in tag_stack..
-    while (!tag_stack.empty()) {
-      Glib::RefPtr<const Gtk::TextTag> tail_tag = tag_stack.top ();
-      tag_stack.pop();
-      write_tag (tail_tag, xml, false);
+    std::size_t first = block_at(start);
+    if(first > 0) {
+      --first;
     }
+    std::size_t last = block_at(end);
+    for(std::size_t i = first; i <= last; ++i) {
+      m_blocks[i].valid = false;
+    }
+  }
 
-    xml.write_end_element (); // </note-content>
+
+  void NoteBufferXmlCache::on_insert(const Gtk::TextIter & pos, const Glib::ustring &, int)
+  {
+    invalidate(pos.get_offset(), pos.get_offset());
+  }
+
+
+  void NoteBufferXmlCache::on_erase(const Gtk::TextIter & start, const Gtk::TextIter & end)
+  {
+    invalidate(start.get_offset(), end.get_offset());
+  }
+
+
+  void NoteBufferXmlCache::on_tag_changed(const Glib::RefPtr<Gtk::TextTag> & tag,
+                                          const Gtk::TextIter & start, const Gtk::TextIter & end)
+  {
+    if(NoteTagTable::tag_is_serializable(tag)) {
+      invalidate(start.get_offset(), end.get_offset());
+    }
+  }
+
+
+  void NoteBufferXmlCache::on_insert_anchor(const Gtk::TextIter & pos, const Glib::RefPtr<Gtk::TextChildAnchor> &)
+  {
+    invalidate(pos.get_offset(), pos.get_offset());
+  }
+
+
+  void NoteBufferXmlCache::on_insert_paintable(const Gtk::TextIter & pos, const Glib::RefPtr<Gdk::Paintable> &)
+  {
+    invalidate(pos.get_offset(), pos.get_offset());
   }
 
 
@@ -1334,16 +1712,30 @@ namespace gnote {
   {
     TagStart()
       : start(0)
+      , byte_start(0)
       {}
     int start;
+    std::size_t byte_start;
     Glib::RefPtr<Gtk::TextTag> tag;
   };
 
+  struct TagSpan
+  {
+    Glib::RefPtr<Gtk::TextTag> tag;
+    int start;
+    int end;
+  };
+
 
   void NoteBufferArchiver::deserialize(const Glib::RefPtr<Gtk::TextBuffer> & buffer, 
                                        const Gtk::TextIter & start,
                                        sharp::XmlReader & xml)
   {
+    if (buffer->size() == 0) {
+      load(buffer, xml);
+      return;
+    }
+
     int offset = start.get_offset();
     std::stack<TagStart> tag_stack;
     TagStart tag_start;
@@ -1477,4 +1869,156 @@ namespace gnote {
     }
   }
 
+
+  // Loads content into an empty buffer. Text and tag spans are collected
+  // first, then the text is inserted at once and the tags are applied in
+  // the order the elements were closed. The result is the same as from
+  // inserting text nodes and applying tags one by one, but insert handlers
+  // run once for the whole text instead of for every text node.
+  void NoteBufferArchiver::load(const Glib::RefPtr<Gtk::TextBuffer> & buffer, sharp::XmlReader & xml)
+  {
+    std::string text;
+    int offset = 0;
+    std::vector<TagSpan> spans;
+    std::stack<TagStart> tag_stack;
+    TagStart tag_start;
+
+    NoteTagTable::Ptr note_table = std::dynamic_pointer_cast<NoteTagTable>(buffer->get_tag_table());
+
+    int curr_depth = -1;
+
+    // A stack of boolean values which mark if a
+    // list-item contains content other than another list
+    std::deque<bool> list_stack;
+
+    try {
+      while (xml.read ()) {
+        switch (xml.get_node_type()) {
+        case XML_READER_TYPE_ELEMENT:
+          if (xml.get_name() == "note-content")
+            break;
+
+          tag_start = TagStart();
+          tag_start.start = offset;
+          tag_start.byte_start = text.size();
+
+          if (note_table &&
+              note_table->is_dynamic_tag_registered (xml.get_name())) {
+            tag_start.tag =
+              note_table->create_dynamic_tag (xml.get_name());
+          } 
+          else if (xml.get_name() == "list") {
+            curr_depth++;
+            // If we are inside a <list-item> mark off
+            // that we have encountered some content
+            if (!list_stack.empty()) {
+              list_stack.pop_front();
+              list_stack.push_front(true);
+            }
+            break;
+          } 
+          else if (xml.get_name() == "list-item") {
+            if (curr_depth >= 0) {
+              tag_start.tag = note_table->get_depth_tag(curr_depth);
+              list_stack.push_front (false);
+            } 
+            else {
+              ERR_OUT(_("</list> tag mismatch"));
+            }
+          } 
+          else {
+            tag_start.tag = buffer->get_tag_table()->lookup (xml.get_name());
+          }
+
+          if (auto tag = std::dynamic_pointer_cast<NoteTag>(tag_start.tag)) {
+            tag->read(xml, true);
+          }
+
+          if(!xml.is_empty_element()) {
+            tag_stack.push (tag_start);
+          }
+          break;
+        case XML_READER_TYPE_TEXT:
+        case XML_READER_TYPE_WHITESPACE:
+        case XML_READER_TYPE_SIGNIFICANT_WHITESPACE:
+          {
+            Glib::ustring value = xml.get_value();
+            text += value.raw();
+            offset += value.length();
+          }
+
+          // If we are inside a <list-item> mark off
+          // that we have encountered some content
+          if (!list_stack.empty()) {
+            list_stack.pop_front ();
+            list_stack.push_front (true);
+          }
+
+          break;
+        case XML_READER_TYPE_END_ELEMENT:
+          if (xml.get_name() == "note-content")
+            break;
+
+          if (xml.get_name() == "list") {
+            curr_depth--;
+            break;
+          }
+
+          tag_start = tag_stack.top();
+          tag_stack.pop();
+          if (tag_start.tag) {
+            if(auto tag = std::dynamic_pointer_cast<NoteTag>(tag_start.tag)) {
+              tag->read(xml, false);
+            }
+
+            // Insert a bullet if we have reached a closing
+            // <list-item> tag, but only if the <list-item>
+            // had content.
+            auto depth_tag = std::dynamic_pointer_cast<DepthNoteTag>(tag_start.tag);
+
+            if (depth_tag && list_stack.front ()) {
+              // Spans closed inside of this item are at the back, they
+              // move along with the text. Do not insert bullet if it's
+              // already there, this happens when using double identation.
+              int bullet_start = tag_start.start;
+              bool has_bullet = false;
+              for (auto span = spans.rbegin(); span != spans.rend() && span->end > bullet_start; ++span) {
+                has_bullet = has_bullet || (std::dynamic_pointer_cast<DepthNoteTag>(span->tag) && span->start <= bullet_start);
+              }
+              if (!has_bullet) {
+                Glib::ustring bullet = NoteBuffer::get_bullet(depth_tag->get_depth());
+                text.insert(tag_start.byte_start, bullet.raw());
+                for (auto span = spans.rbegin(); span != spans.rend() && span->end > bullet_start; ++span) {
+                  span->start += bullet.length();
+                  span->end += bullet.length();
+                }
+                spans.push_back(TagSpan{depth_tag, bullet_start, bullet_start + int(bullet.length())});
+                offset += bullet.length();
+              }
+              list_stack.pop_front();
+            } 
+            else if (!depth_tag) {
+              spans.push_back(TagSpan{tag_start.tag, tag_start.start, offset});
+            }
+          }
+          break;
+        default:
+          ERR_OUT("Unhandled element %d. Value: '%s'", xml.get_node_type(), xml.get_value().c_str());
+          break;
+        }
+      }
+    }
+    catch(const std::exception & e) {
+      ERR_OUT(_("Exception: %s"), e.what());
+    }
+
+    if (text.empty()) {
+      return;
+    }
+    buffer->insert(buffer->begin(), text);
+    for (const auto & span : spans) {
+      buffer->apply_tag(span.tag, buffer->get_iter_at_offset(span.start), buffer->get_iter_at_offset(span.end));
+    }
+  }
+
 }
@@ -112,8 +112,10 @@ public:
   void remove_bullet(Gtk::TextIter & iter);
   void increase_depth(Gtk::TextIter & start);
   void decrease_depth(Gtk::TextIter & start);
-  DepthNoteTag::Ptr find_depth_tag(Gtk::TextIter &);
+  static DepthNoteTag::Ptr find_depth_tag(const Gtk::TextIter &);
   static bool is_bullet(gunichar c);
+  // bullet text inserted at the start of list item
+  static Glib::ustring get_bullet(int depth);
   void select_note_body();
 protected: 
   NoteBuffer(const NoteTagTable::Ptr &, Note &, Preferences &);
@@ -175,7 +177,12 @@ public:
   static void deserialize(const Glib::RefPtr<Gtk::TextBuffer> & buffer, 
                           const Gtk::TextIter & iter, sharp::XmlReader & xml);
 private:
+  class Serializer;
 
+  static void load(const Glib::RefPtr<Gtk::TextBuffer> & buffer, sharp::XmlReader & xml);
+  friend class NoteBufferXmlCache;
+
+  static void write_content_start(sharp::XmlWriter & xml);
   static void write_tag(const Glib::RefPtr<const Gtk::TextTag> & tag, sharp::XmlWriter & xml, 
                         bool start);
   static bool tag_ends_here (const Glib::RefPtr<const Gtk::TextTag> & tag,
@@ -186,6 +193,51 @@ private:
 };
 
 
+/**
+ * Serializes a buffer reusing the XML of blocks, that were not changed since
+ * the last call.
+ *
+ * The buffer is split into blocks of lines at line starts, where no tags or
+ * lists are open, so the XML of blocks can be joined as is. Changes to the
+ * buffer invalidate the blocks they touch and the block before them, as the
+ * end of a line depends on whether the next line is a list item. Output is
+ * the same as of NoteBufferArchiver::serialize().
+ */
+class NoteBufferXmlCache
+{
+public:
+  static const int BLOCK_LINES;
+
+  explicit NoteBufferXmlCache(const Glib::RefPtr<Gtk::TextBuffer> & buffer);
+  ~NoteBufferXmlCache();
+  Glib::ustring serialize();
+  void clear();
+  std::size_t block_count() const
+    {
+      return m_blocks.size();
+    }
+private:
+  struct Block
+  {
+    Glib::RefPtr<Gtk::TextMark> start;
+    Glib::ustring xml;
+    bool valid;
+  };
+
+  void on_insert(const Gtk::TextIter & pos, const Glib::ustring & text, int);
+  void on_erase(const Gtk::TextIter & start, const Gtk::TextIter & end);
+  void on_tag_changed(const Glib::RefPtr<Gtk::TextTag> & tag, const Gtk::TextIter & start, const Gtk::TextIter & end);
+  void on_insert_anchor(const Gtk::TextIter & pos, const Glib::RefPtr<Gtk::TextChildAnchor> &);
+  void on_insert_paintable(const Gtk::TextIter & pos, const Glib::RefPtr<Gdk::Paintable> &);
+  void invalidate(int start, int end);
+  std::size_t block_at(int offset) const;
+
+  Glib::RefPtr<Gtk::TextBuffer> m_buffer;
+  std::vector<Block> m_blocks;
+  std::vector<sigc::connection> m_connections;
+};
+
+
 }
 
 #endif
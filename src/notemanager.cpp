@@ -30,9 +30,13 @@
 #include "debug.hpp"
 #include "noteeditor.hpp"
 #include "notemanager.hpp"
+#include "notewriter.hpp"
 #include "addinmanager.hpp"
+#include "durability.hpp"
 #include "ignote.hpp"
 #include "itagmanager.hpp"
+#include "linkindex.hpp"
+#include "searchindex.hpp"
 #include "sharp/directory.hpp"
 #include "sharp/dynamicmodule.hpp"
 
@@ -43,8 +47,14 @@ namespace gnote {
     , m_preferences(g.preferences())
     , m_notebook_manager(*this)
     , m_note_archiver(*this)
+    , m_note_writer(std::make_unique<NoteWriter>())
     , m_save_timeout(0)
+    , m_buffer_idle_timeout(0)
+    , m_buffer_release_timeout(0)
   {
+    m_note_writer->signal_write_failed.connect(sigc::mem_fun(*this, &NoteManager::on_note_write_failed));
+    // backup of deleted note has to have the latest content
+    signal_note_deleted.connect([this](NoteBase &) { m_note_writer->flush(); });
   }
 
 
@@ -56,6 +66,24 @@ namespace gnote {
     m_addin_mgr = create_addin_manager ();
     NoteTagTable::setup_instance(m_preferences);
 
+    // Only note metadata is loaded at startup, text is read when needed
+    int text_cache_size = m_preferences.note_text_cache_size();
+    if(text_cache_size > 0) {
+      m_text_cache = std::make_shared<NoteTextCache>(text_cache_size);
+    }
+    m_note_writer->durability(durability_from_string(m_preferences.note_write_durability()));
+
+    // Notes get buffers when edited without window, like when updating links
+    m_buffer_idle_timeout = m_preferences.note_buffer_idle_timeout();
+    if(m_buffer_idle_timeout > 0) {
+      auto release_callback = [](gpointer data) -> gboolean {
+        auto & manager = *static_cast<NoteManager*>(data);
+        manager.release_idle_buffers(gint64(manager.m_buffer_idle_timeout) * G_USEC_PER_SEC);
+        return TRUE;
+      };
+      m_buffer_release_timeout = g_timeout_add_seconds(m_buffer_idle_timeout, release_callback, this);
+    }
+
     if (is_first_run) {
       std::vector<ImportAddin*> l = m_addin_mgr->get_import_addins();
       bool has_imported = false;
@@ -101,6 +129,9 @@ namespace gnote {
 
   NoteManager::~NoteManager()
   {
+    if(m_buffer_release_timeout) {
+      g_source_remove(m_buffer_release_timeout);
+    }
   }
 
   std::unique_ptr<AddinManager> NoteManager::create_addin_manager()
@@ -169,18 +200,7 @@ namespace gnote {
   void NoteManager::load_notes()
   {
     std::vector<Glib::ustring> files = sharp::directory_get_files_with_ext(notes_dir(), ".note");
-
-    for(auto & file_path : files) {
-      try {
-        Note::Ptr note = Note::load(std::move(file_path), *this, gnote());
-        add_note(note);
-      } 
-      catch (const std::exception & e) {
-        /* TRANSLATORS: first %s is file, second is error */
-        ERR_OUT(_("Error parsing note XML, skipping \"%s\": %s"),
-                file_path.c_str(), e.what());
-      }
-    }
+    load_note_files(std::move(files), !m_text_cache);
     post_load();
     // Make sure that a Start Note Uri is set in the preferences, and
     // make sure that the Uri is valid to prevent bug #508982. This
@@ -244,6 +264,80 @@ namespace gnote {
     for(const NoteBase::Ptr & note : notesCopy) {
       note->save();
     }
+
+    DBG_OUT_2("Waiting for note files to be written...");
+    m_note_writer->flush();
+    save_caches();
+
+    auto stats = fsync_stats();
+    DBG_OUT_1("Note writes: %zu files in %zu batches, %" G_GUINT64_FORMAT " syncs (%" G_GUINT64_FORMAT " failed), "
+              "%" G_GUINT64_FORMAT " us total, %" G_GUINT64_FORMAT " us max",
+              m_note_writer->written_count(), m_note_writer->batch_count(),
+              stats.count, stats.failures, stats.total_usec, stats.max_usec);
+    log_resident_buffers();
+  }
+
+  void NoteManager::flush_saves()
+  {
+    m_note_writer->flush();
+  }
+
+  std::vector<NoteManager::ResidentBuffer> NoteManager::resident_buffers() const
+  {
+    std::vector<ResidentBuffer> buffers;
+    auto now = g_get_monotonic_time();
+    for(const auto & note : m_notes) {
+      auto & n = static_cast<const Note&>(*note);
+      if(const auto & buffer = n.existing_buffer()) {
+        buffers.push_back(ResidentBuffer{n.get_title(), buffer->get_char_count(), buffer->get_line_count(),
+                                         n.is_opened(), now - n.buffer_last_used()});
+      }
+    }
+    return buffers;
+  }
+
+  std::size_t NoteManager::release_idle_buffers(gint64 idle_usec)
+  {
+    auto used_before = g_get_monotonic_time() - idle_usec;
+    std::size_t released = 0;
+    for(const auto & note : m_notes) {
+      auto & n = static_cast<Note&>(*note);
+      if(n.has_buffer() && n.buffer_last_used() <= used_before && n.release_buffer()) {
+        ++released;
+      }
+    }
+
+    if(released) {
+      DBG_OUT_2("Released %zu idle note buffers", released);
+      log_resident_buffers();
+    }
+    return released;
+  }
+
+  void NoteManager::log_resident_buffers() const
+  {
+    auto buffers = resident_buffers();
+    std::size_t opened = 0;
+    std::size_t chars = 0;
+    for(const auto & buffer : buffers) {
+      opened += buffer.opened;
+      chars += buffer.chars;
+    }
+    DBG_OUT_1("Note buffers: %zu of %zu notes (%zu opened), %zu characters",
+              buffers.size(), m_notes.size(), opened, chars);
+    for(const auto & buffer : buffers) {
+      DBG_OUT_3("Note buffer '%s': %d characters, %d lines, %s, idle %" G_GINT64_FORMAT " s",
+                buffer.title.c_str(), buffer.chars, buffer.lines, buffer.opened ? "opened" : "not opened",
+                buffer.idle_usec / G_USEC_PER_SEC);
+    }
+  }
+
+  void NoteManager::on_note_write_failed(const Glib::ustring & file, const Glib::ustring & error)
+  {
+    ERR_OUT(_("Failed to write note file %s: %s"), file.c_str(), error.c_str());
+    find_by_uri(NoteBase::url_from_path(file), [](NoteBase & note) {
+      static_cast<Note&>(note).on_save_failed();
+    });
   }
 
   NoteBase::Ptr NoteManager::note_load(Glib::ustring && file_name)
@@ -251,6 +345,11 @@ namespace gnote {
     return Note::load(std::move(file_name), *this, gnote());
   }
 
+  NoteBase::Ptr NoteManager::note_load(NoteArchiver::ParsedNote && parsed)
+  {
+    return Note::load(std::move(parsed), *this, gnote());
+  }
+
 
   Note & NoteManager::create_note(Glib::ustring && title, Glib::ustring && body, Glib::ustring && guid)
   {
@@ -347,6 +446,8 @@ namespace gnote {
 
   void NoteManager::queue_save(NoteBase & note)
   {
+    search_index().invalidate(note);
+    link_index().invalidate(note);
     const auto & uri = note.uri();
     for(const auto & to_save : m_queued_saves) {
       if(to_save == uri) {
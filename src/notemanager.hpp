@@ -32,6 +32,7 @@
 namespace gnote {
 
   class AddinManager;
+  class NoteWriter;
 
   class NoteManager 
     : public NoteManagerBase
@@ -68,6 +69,31 @@ namespace gnote {
 
     void queue_save(NoteBase & note);
     void save_notes();
+    // note files are written on background thread
+    NoteWriter & note_writer()
+      {
+        return *m_note_writer;
+      }
+    virtual void flush_saves() override;
+    // null, if note texts are loaded with notes
+    const std::shared_ptr<NoteTextCache> & note_text_cache() const
+      {
+        return m_text_cache;
+      }
+
+    // buffer of a note, for memory accounting
+    struct ResidentBuffer
+    {
+      Glib::ustring title;
+      int chars;
+      int lines;
+      bool opened;
+      gint64 idle_usec;
+    };
+    std::vector<ResidentBuffer> resident_buffers() const;
+    // releases buffers of notes without window, not used for idle_usec,
+    // returns the number of released buffers
+    std::size_t release_idle_buffers(gint64 idle_usec);
 
     ChangedHandler signal_note_buffer_changed;
 
@@ -80,11 +106,14 @@ namespace gnote {
     Note & create_new_note(Glib::ustring && title, Glib::ustring && xml_content, Glib::ustring && guid) override;
     virtual NoteBase::Ptr note_create_new(Glib::ustring && title, Glib::ustring && file_name) override;
     NoteBase::Ptr note_load(Glib::ustring && file_name) override;
+    NoteBase::Ptr note_load(NoteArchiver::ParsedNote && parsed) override;
   private:
     std::unique_ptr<AddinManager> create_addin_manager();
     void create_start_notes();
     void load_notes();
     void on_exiting_event();
+    void on_note_write_failed(const Glib::ustring & file, const Glib::ustring & error);
+    void log_resident_buffers() const;
     bool open_or_create_link(const NoteEditor &, const Gtk::TextIter &,const Gtk::TextIter &);
     bool on_link_tag_activated(const NoteEditor &, const Gtk::TextIter &, const Gtk::TextIter &);
 
@@ -93,10 +122,15 @@ namespace gnote {
     std::unique_ptr<AddinManager> m_addin_mgr;
     NoteArchiver m_note_archiver;
     TagManager m_tag_manager;
+    std::shared_ptr<NoteTextCache> m_text_cache;
+    std::unique_ptr<NoteWriter> m_note_writer;
 
     // Notes to save, URIs
     std::vector<Glib::ustring> m_queued_saves;
     guint m_save_timeout;
+    // seconds, 0 keeps buffers
+    int m_buffer_idle_timeout;
+    guint m_buffer_release_timeout;
   };
 
 
@@ -19,13 +19,21 @@
  */
 
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 #include <glib/gstdio.h>
 #include <glibmm/i18n.h>
 #include <glibmm/miscutils.h>
+#include <libxml/parser.h>
 
 #include "debug.hpp"
 #include "ignote.hpp"
+#include "linkindex.hpp"
 #include "notemanagerbase.hpp"
+#include "notesnapshot.hpp"
+#include "searchindex.hpp"
 #include "utils.hpp"
 #include "trie.hpp"
 #include "notebooks/notebookmanager.hpp"
@@ -38,6 +46,13 @@
 
 namespace gnote {
 
+namespace {
+
+// don't start threads for a few notes
+const std::size_t MIN_FILES_PER_LOAD_THREAD = 32;
+
+}
+
 class TrieController
 {
 public:
@@ -45,6 +60,8 @@ public:
 
   void add_note(const NoteBase::Ptr & note);
   void update();
+  // rebuild once for all titles added or changed during batch
+  void on_batch_change_finished();
   TrieTree<Glib::ustring> & title_trie() const
     {
       return *m_title_trie;
@@ -53,9 +70,11 @@ private:
   void on_note_added(NoteBase & added);
   void on_note_deleted(NoteBase & deleted);
   void on_note_renamed(const NoteBase & renamed, const Glib::ustring & old_title);
+  void remove_title(const Glib::ustring & title, const Glib::ustring & uri);
 
   NoteManagerBase & m_manager;
   std::unique_ptr<TrieTree<Glib::ustring>> m_title_trie;
+  bool m_stale;
 };
 
 
@@ -85,6 +104,7 @@ Glib::ustring NoteManagerBase::sanitize_xml_content(const Glib::ustring & xml_co
 
 NoteManagerBase::NoteManagerBase(IGnote & g)
   : m_gnote(g)
+  , m_batch_depth(0)
 {
 }
 
@@ -128,6 +148,9 @@ bool NoteManagerBase::init(const Glib::ustring & directory, const Glib::ustring
   }
 
   m_trie_controller = create_trie_controller();
+  m_search_index = std::make_unique<SearchIndex>(*this);
+  m_link_index = std::make_unique<LinkIndex>(*this);
+  m_snapshot = std::make_unique<NoteSnapshot>(*this);
   return is_first_run;
 }
 
@@ -167,6 +190,39 @@ void NoteManagerBase::post_load()
 {
   // Update the trie so addins can access it, if they want.
   m_trie_controller->update ();
+
+  // Bring the search index up to date, only changed notes have to be reindexed
+  auto index_file = search_index_file();
+  m_search_index->load(index_file);
+  m_search_index->update();
+  if(m_search_index->is_modified()) {
+    m_search_index->save(index_file);
+  }
+}
+
+Glib::ustring NoteManagerBase::cache_dir() const
+{
+  return IGnote::cache_dir();
+}
+
+Glib::ustring NoteManagerBase::search_index_file() const
+{
+  return Glib::build_filename(cache_dir(), "search-index");
+}
+
+Glib::ustring NoteManagerBase::snapshot_file() const
+{
+  return Glib::build_filename(cache_dir(), "note-snapshot");
+}
+
+void NoteManagerBase::save_caches()
+{
+  if(m_search_index && m_search_index->is_modified()) {
+    m_search_index->save(search_index_file());
+  }
+  if(m_snapshot && m_snapshot->is_modified()) {
+    m_snapshot->save(snapshot_file());
+  }
 }
 
 size_t NoteManagerBase::trie_max_length()
@@ -179,31 +235,178 @@ TrieHit<Glib::ustring>::List NoteManagerBase::find_trie_matches(const Glib::ustr
   return m_trie_controller->title_trie().find_matches(match);
 }
 
+void NoteManagerBase::begin_batch_change()
+{
+  ++m_batch_depth;
+}
+
+void NoteManagerBase::end_batch_change()
+{
+  if(m_batch_depth == 0) {
+    ERR_OUT("end_batch_change called without begin_batch_change");
+    return;
+  }
+  if(--m_batch_depth > 0) {
+    return;
+  }
+
+  // listeners may look up titles, so trie goes first
+  if(m_trie_controller) {
+    m_trie_controller->on_batch_change_finished();
+  }
+  signal_batch_change_finished();
+}
+
 std::vector<NoteBase::Ref> NoteManagerBase::get_notes_linking_to(const Glib::ustring & title) const
 {
-  Glib::ustring tag = "<link:internal>" + utils::XmlEncoder::encode(title) + "</link:internal>";
   std::vector<NoteBase::Ref> result;
-  for(const NoteBase::Ptr & note : m_notes) {
-    if(note->get_title() != title) {
-      if(note->get_complete_note_xml().find(tag) != Glib::ustring::npos) {
-        result.push_back(*note);
+  for(const auto & uri : m_link_index->linking_notes(title)) {
+    if(auto note = find_by_uri(uri)) {
+      if(note.value().get().get_title() != title) {
+        result.push_back(note.value());
       }
     }
   }
   return result;
 }
 
+void NoteManagerBase::flush_saves()
+{
+  // notes are saved synchronously
+}
+
+void NoteManagerBase::load_note_files(std::vector<Glib::ustring> && files, bool with_text, unsigned threads)
+{
+  // Without text everything needed is in the snapshot, only files changed since it was written are parsed
+  const NoteSnapshot *snapshot = nullptr;
+  std::vector<std::optional<NoteSnapshot::FileStamp>> stamps;
+  std::vector<char> from_snapshot;
+  if(!with_text && m_snapshot) {
+    m_snapshot->load(snapshot_file());
+    m_snapshot->retain(files);
+    snapshot = m_snapshot.get();
+    stamps.resize(files.size());
+    from_snapshot.resize(files.size(), false);
+  }
+
+  std::vector<NoteArchiver::ParsedNote> parsed(files.size());
+  for(std::size_t i = 0; i < files.size(); ++i) {
+    parsed[i].file = std::move(files[i]);
+  }
+
+  // Parsing is independent for every file, results are stored by index,
+  // so the outcome doesn't depend on how the work is split among threads
+  std::atomic<std::size_t> next_file(0);
+  auto parse = [&parsed, &next_file, &stamps, &from_snapshot, snapshot, with_text]() {
+    for(std::size_t i = next_file++; i < parsed.size(); i = next_file++) {
+      try {
+        if(snapshot) {
+          // stamp is taken before parsing, so a file changed meanwhile is parsed again next time
+          stamps[i] = NoteSnapshot::file_stamp(parsed[i].file);
+          if(stamps[i] && snapshot->read(*stamps[i], parsed[i])) {
+            from_snapshot[i] = true;
+            continue;
+          }
+        }
+        NoteArchiver::parse_file(parsed[i], with_text);
+      }
+      catch(const std::exception & e) {
+        parsed[i].error = e.what();
+      }
+    }
+  };
+
+  if(threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = std::min<std::size_t>(threads, std::max<std::size_t>(1, parsed.size() / MIN_FILES_PER_LOAD_THREAD));
+  DBG_OUT_1("Loading %u notes using %u threads", unsigned(parsed.size()), threads);
+
+  xmlInitParser();
+  std::vector<std::thread> workers;
+  for(unsigned i = 1; i < threads; ++i) {
+    workers.emplace_back(parse);
+  }
+  parse();
+  for(auto & worker : workers) {
+    worker.join();
+  }
+
+  for(std::size_t i = 0; i < parsed.size(); ++i) {
+    auto & note = parsed[i];
+    if(note.error.empty()) {
+      try {
+        // notes in old format get rewritten when loaded, so their stamp is outdated
+        if(snapshot && !from_snapshot[i] && stamps[i] && note.version == NoteArchiver::CURRENT_VERSION) {
+          m_snapshot->update(note, *stamps[i]);
+        }
+        add_note(note_load(std::move(note)));
+        continue;
+      }
+      catch(const std::exception & e) {
+        note.error = e.what();
+      }
+    }
+
+    /* TRANSLATORS: first %s is file, second is error */
+    ERR_OUT(_("Error parsing note XML, skipping \"%s\": %s"),
+            note.file.c_str(), note.error.c_str());
+  }
+
+  if(snapshot && m_snapshot->is_modified()) {
+    m_snapshot->save(snapshot_file());
+  }
+}
+
 void NoteManagerBase::add_note(NoteBase::Ptr note)
 {
   if(note) {
     note->signal_renamed.connect(sigc::mem_fun(*this, &NoteManagerBase::on_note_rename));
     note->signal_saved.connect(sigc::mem_fun(*this, &NoteManagerBase::on_note_save));
+    index_note(*note);
     m_notes.insert(std::move(note));
   }
 }
 
+void NoteManagerBase::index_note(NoteBase & note)
+{
+  Glib::ustring key = note.get_title().lowercase();
+  m_notes_by_title[key].push_back(&note);
+  m_note_title_keys[&note] = std::move(key);
+  m_notes_by_uri[note.uri()] = &note;
+}
+
+void NoteManagerBase::unindex_note(const NoteBase & note)
+{
+  auto key = m_note_title_keys.find(&note);
+  if(key != m_note_title_keys.end()) {
+    auto notes = m_notes_by_title.find(key->second);
+    if(notes != m_notes_by_title.end()) {
+      auto & list = notes->second;
+      list.erase(std::remove(list.begin(), list.end(), &note), list.end());
+      if(list.empty()) {
+        m_notes_by_title.erase(notes);
+      }
+    }
+    m_note_title_keys.erase(key);
+  }
+  m_notes_by_uri.erase(note.uri());
+}
+
+void NoteManagerBase::note_title_changed(const NoteBase & note)
+{
+  auto renamed = m_notes_by_uri.find(note.uri());
+  if(renamed != m_notes_by_uri.end()) {
+    NoteBase & indexed = *renamed->second;
+    unindex_note(indexed);
+    index_note(indexed);
+  }
+}
+
 void NoteManagerBase::on_note_rename(const NoteBase & note, const Glib::ustring & old_title)
 {
+  // index has to be up to date for handlers
+  note_title_changed(note);
   signal_note_renamed(note, old_title);
 }
 
@@ -214,9 +417,14 @@ void NoteManagerBase::on_note_save(NoteBase & note)
 
 NoteBase::ORef NoteManagerBase::find(const Glib::ustring & linked_title) const
 {
-  for(const NoteBase::Ptr & note : m_notes) {
-    if(note->get_title().lowercase() == linked_title.lowercase()) {
-      return std::ref(*note);
+  Glib::ustring key = linked_title.lowercase();
+  auto notes = m_notes_by_title.find(key);
+  if(notes != m_notes_by_title.end()) {
+    for(NoteBase *note : notes->second) {
+      // title might be set in note data directly, without reindexing
+      if(note->get_title().lowercase() == key) {
+        return std::ref(*note);
+      }
     }
   }
   return NoteBase::ORef();
@@ -224,10 +432,9 @@ NoteBase::ORef NoteManagerBase::find(const Glib::ustring & linked_title) const
 
 NoteBase::ORef NoteManagerBase::find_by_uri(const Glib::ustring & uri) const
 {
-  for(const NoteBase::Ptr & note : m_notes) {
-    if (note->uri() == uri) {
-      return std::ref(*note);
-    }
+  auto note = m_notes_by_uri.find(uri);
+  if(note != m_notes_by_uri.end()) {
+    return std::ref(*note->second);
   }
   return NoteBase::ORef();
 }
@@ -333,6 +540,7 @@ NoteBase & NoteManagerBase::create_new_note(Glib::ustring && title, Glib::ustrin
   new_note->signal_renamed.connect(sigc::mem_fun(*this, &NoteManagerBase::on_note_rename));
   new_note->signal_saved.connect(sigc::mem_fun(*this, &NoteManagerBase::on_note_save));
 
+  index_note(*new_note);
   m_notes.insert(new_note);
 
   signal_note_added(*new_note);
@@ -431,12 +639,11 @@ void NoteManagerBase::delete_note(NoteBase & note)
   DBG_OUT_1("Deleting note '%s'.", note.get_title().c_str());
   NoteBase::Ptr cached_ref;  // prevent note from being destroyed
 
-  for(auto iter = m_notes.begin(); iter != m_notes.end(); ++iter) {
-    if(iter->get() == &note) {
-      cached_ref = *iter;
-      m_notes.erase(iter);
-      break;
-    }
+  auto iter = m_notes.find(note.shared_from_this());
+  if(iter != m_notes.end()) {
+    cached_ref = *iter;
+    m_notes.erase(iter);
+    unindex_note(note);
   }
   DBG_ASSERT(cached_ref != nullptr, "Deleting note that is not present");
   note.delete_note();
@@ -488,6 +695,7 @@ NoteBase::ORef NoteManagerBase::import_note(const Glib::ustring & file_path)
       }
     }
     add_note(note);
+    m_search_index->add_note(*note);
     return *note;
   }
   catch(...)
@@ -516,6 +724,7 @@ std::size_t NoteManagerBase::NoteHash::operator()(const NoteBase::Ptr & note) co
 
 TrieController::TrieController(NoteManagerBase & manager)
   : m_manager(manager)
+  , m_stale(false)
 {
   m_manager.signal_note_deleted.connect(sigc::mem_fun(*this, &TrieController::on_note_deleted));
   m_manager.signal_note_added.connect(sigc::mem_fun(*this, &TrieController::on_note_added));
@@ -526,23 +735,41 @@ TrieController::TrieController(NoteManagerBase & manager)
 
 void TrieController::on_note_added(NoteBase & note)
 {
+  if(m_manager.in_batch_change()) {
+    m_stale = true;
+    return;
+  }
   add_note(note.shared_from_this());
 }
 
-void TrieController::on_note_deleted(NoteBase &)
+void TrieController::on_note_deleted(NoteBase & note)
 {
-  update();
+  remove_title(note.get_title(), note.uri());
 }
 
-void TrieController::on_note_renamed(const NoteBase &, const Glib::ustring &)
+void TrieController::on_note_renamed(const NoteBase & note, const Glib::ustring & old_title)
 {
-  update();
+  if(m_manager.in_batch_change()) {
+    m_stale = true;
+    return;
+  }
+  remove_title(old_title, note.uri());
+  m_title_trie->insert_keyword(note.get_title(), note.uri());
+}
+
+void TrieController::remove_title(const Glib::ustring & title, const Glib::ustring & uri)
+{
+  if(m_title_trie->remove_keyword(title, uri)) {
+    // another note might have the same title
+    if(auto other = m_manager.find(title)) {
+      m_title_trie->insert_keyword(other.value().get().get_title(), other.value().get().uri());
+    }
+  }
 }
 
 void TrieController::add_note(const NoteBase::Ptr & note)
 {
-  m_title_trie->add_keyword(note->get_title(), note->uri());
-  m_title_trie->compute_failure_graph();
+  m_title_trie->insert_keyword(note->get_title(), note->uri());
 }
 
 void TrieController::update()
@@ -553,6 +780,14 @@ void TrieController::update()
     m_title_trie->add_keyword(note.get_title(), note.uri());
   });
   m_title_trie->compute_failure_graph();
+  m_stale = false;
+}
+
+void TrieController::on_batch_change_finished()
+{
+  if(m_stale) {
+    update();
+  }
 }
 
 
@@ -22,6 +22,7 @@
 #ifndef _NOTEMANAGERBASE_HPP_
 #define _NOTEMANAGERBASE_HPP_
 
+#include <unordered_map>
 #include <unordered_set>
 
 #include "itagmanager.hpp"
@@ -38,6 +39,9 @@ class NotebookManager;
 }
 
 class IGnote;
+class LinkIndex;
+class NoteSnapshot;
+class SearchIndex;
 class TrieController;
 
 class NoteManagerBase
@@ -60,6 +64,14 @@ public:
   virtual notebooks::NotebookManager & notebook_manager() = 0;
   size_t trie_max_length();
   TrieHit<Glib::ustring>::List find_trie_matches(const Glib::ustring &);
+  SearchIndex & search_index()
+    {
+      return *m_search_index;
+    }
+  LinkIndex & link_index()
+    {
+      return *m_link_index;
+    }
 
   virtual NoteArchiver & note_archiver() = 0;
   virtual const ITagManager & tag_manager() const = 0;
@@ -75,6 +87,8 @@ public:
     }
   NoteBase::ORef find(const Glib::ustring &) const;
   NoteBase::ORef find_by_uri(const Glib::ustring &) const;
+  // title of the note is changed, rename signal may follow later
+  void note_title_changed(const NoteBase & note);
   template <typename F>
   bool find_by_uri(const Glib::ustring & uri, const F & func) const
     {
@@ -85,6 +99,8 @@ public:
       return false;
     }
   std::vector<NoteBase::Ref> get_notes_linking_to(const Glib::ustring & title) const;
+  // wait until saved notes are written to disk, can be called from any thread
+  virtual void flush_saves();
   NoteBase & create();
   NoteBase & create(Glib::ustring && title);
   NoteBase & create(Glib::ustring && title, Glib::ustring && xml_content);
@@ -135,15 +151,47 @@ public:
       }
     }
 
+  // Many notes are about to be added or changed, listeners can postpone
+  // expensive work until signal_batch_change_finished. Can be nested.
+  void begin_batch_change();
+  void end_batch_change();
+  bool in_batch_change() const
+    {
+      return m_batch_depth > 0;
+    }
+
+  class BatchChange
+  {
+  public:
+    explicit BatchChange(NoteManagerBase & manager)
+      : m_manager(manager)
+      {
+        m_manager.begin_batch_change();
+      }
+    ~BatchChange()
+      {
+        m_manager.end_batch_change();
+      }
+    BatchChange(const BatchChange&) = delete;
+    BatchChange & operator=(const BatchChange&) = delete;
+  private:
+    NoteManagerBase & m_manager;
+  };
+
   ChangedHandler signal_note_deleted;
   ChangedHandler signal_note_added;
   NoteBase::RenamedHandler signal_note_renamed;
   NoteBase::SavedHandler signal_note_saved;
+  sigc::signal<void()> signal_batch_change_finished;
 protected:
   static void delete_old_backups(const Glib::ustring &backup, const Glib::DateTime &keep_since);
 
   bool init(const Glib::ustring & directory, const Glib::ustring & backup);
   virtual void post_load();
+  // directory for data, that can be regenerated from notes
+  virtual Glib::ustring cache_dir() const;
+  // save search index and note snapshot, if modified
+  void save_caches();
   virtual void migrate_notes(const Glib::ustring & old_note_dir);
   /** add the note to the manager and setup signals */
   void add_note(NoteBase::Ptr);
@@ -156,6 +204,9 @@ protected:
   Glib::ustring make_new_file_name() const;
   Glib::ustring make_new_file_name(const Glib::ustring & guid) const;
   virtual NoteBase::Ptr note_load(Glib::ustring && file_name) = 0;
+  virtual NoteBase::Ptr note_load(NoteArchiver::ParsedNote && parsed) = 0;
+  // Parse note files on worker threads and add the notes in the order of files
+  void load_note_files(std::vector<Glib::ustring> && files, bool with_text, unsigned threads = 0);
 
   struct NoteHash
   {
@@ -170,11 +221,24 @@ private:
   void create_notes_dir() const;
   bool create_directory(const Glib::ustring & directory) const;
   std::unique_ptr<TrieController> create_trie_controller();
+  void index_note(NoteBase & note);
+  void unindex_note(const NoteBase & note);
+  Glib::ustring search_index_file() const;
+  Glib::ustring snapshot_file() const;
 
   IGnote & m_gnote;
   std::unique_ptr<TrieController> m_trie_controller;
+  std::unique_ptr<SearchIndex> m_search_index;
+  std::unique_ptr<LinkIndex> m_link_index;
+  std::unique_ptr<NoteSnapshot> m_snapshot;
+  // lowercase title to notes, updated on rename, so lookup checks the current title
+  std::unordered_map<Glib::ustring, std::vector<NoteBase*>, Hash<Glib::ustring>> m_notes_by_title;
+  // key in m_notes_by_title for every note, old title in rename signal is not reliable
+  std::unordered_map<const NoteBase*, Glib::ustring> m_note_title_keys;
+  std::unordered_map<Glib::ustring, NoteBase*, Hash<Glib::ustring>> m_notes_by_uri;
   Glib::ustring m_notes_dir;
   bool m_read_only;
+  unsigned m_batch_depth;
 };
 
 }
@@ -0,0 +1,370 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <cstring>
+#include <fstream>
+#include <unordered_set>
+
+#include <glib/gstdio.h>
+#include <glibmm/miscutils.h>
+
+#include "debug.hpp"
+#include "itagmanager.hpp"
+#include "notemanagerbase.hpp"
+#include "notesnapshot.hpp"
+#include "utils.hpp"
+#include "sharp/exception.hpp"
+#include "sharp/files.hpp"
+#include "sharp/xmlconvert.hpp"
+
+
+namespace gnote {
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = {'G', 'N', 'O', 'T', 'E', 'S', 'N', 'P'};
+const guint32 SNAPSHOT_VERSION = 1;
+// detects snapshots from machines with different byte order
+const guint32 BYTE_ORDER_MARK = 0x01020304;
+
+
+class SnapshotReader
+{
+public:
+  SnapshotReader(const char *data, std::size_t size)
+    : m_pos(data)
+    , m_end(data + size)
+    {}
+
+  template <typename T>
+  T read()
+    {
+      T value;
+      read_bytes(&value, sizeof(T));
+      return value;
+    }
+
+  Glib::ustring read_string()
+    {
+      auto length = read<guint32>();
+      if(std::size_t(m_end - m_pos) < length) {
+        throw std::runtime_error("Unexpected end of snapshot");
+      }
+      if(!g_utf8_validate(m_pos, length, nullptr)) {
+        throw std::runtime_error("Invalid string in snapshot");
+      }
+      std::string str(m_pos, length);
+      m_pos += length;
+      return str;
+    }
+
+  void read_bytes(void *dest, std::size_t count)
+    {
+      if(std::size_t(m_end - m_pos) < count) {
+        throw std::runtime_error("Unexpected end of snapshot");
+      }
+      std::memcpy(dest, m_pos, count);
+      m_pos += count;
+    }
+
+  bool at_end() const
+    {
+      return m_pos == m_end;
+    }
+private:
+  const char *m_pos;
+  const char *m_end;
+};
+
+
+class SnapshotWriter
+{
+public:
+  template <typename T>
+  void write(T value)
+    {
+      m_buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+  void write_string(const Glib::ustring & str)
+    {
+      write<guint32>(str.bytes());
+      m_buffer.append(str.raw());
+    }
+
+  void write_bytes(const char *bytes, std::size_t count)
+    {
+      m_buffer.append(bytes, count);
+    }
+
+  const std::string & buffer() const
+    {
+      return m_buffer;
+    }
+private:
+  std::string m_buffer;
+};
+
+
+Glib::ustring date_to_string(const Glib::DateTime & date)
+{
+  return date ? sharp::XmlConvert::to_string(date) : Glib::ustring();
+}
+
+}
+
+
+std::optional<NoteSnapshot::FileStamp> NoteSnapshot::file_stamp(const Glib::ustring & file)
+{
+  GStatBuf st;
+  if(g_stat(file.c_str(), &st) != 0) {
+    return std::optional<FileStamp>();
+  }
+
+  return FileStamp{st.st_mtim.tv_sec, st.st_mtim.tv_nsec, st.st_size, st.st_ino};
+}
+
+
+NoteSnapshot::NoteSnapshot(NoteManagerBase & manager)
+  : m_manager(manager)
+  , m_modified(false)
+{
+  m_manager.signal_note_saved.connect([this](NoteBase & note) { update(note); });
+  m_manager.signal_note_deleted.connect([this](NoteBase & note) { remove(note.file_path()); });
+}
+
+bool NoteSnapshot::load(const Glib::ustring & file)
+{
+  m_records.clear();
+  m_modified = false;
+
+  GError *error = nullptr;
+  GMappedFile *mapped = g_mapped_file_new(file.c_str(), FALSE, &error);
+  if(!mapped) {
+    DBG_OUT_1("No note snapshot %s: %s", file.c_str(), error->message);
+    g_error_free(error);
+    return false;
+  }
+
+  bool ret = false;
+  try {
+    SnapshotReader reader(g_mapped_file_get_contents(mapped), g_mapped_file_get_length(mapped));
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    reader.read_bytes(magic, sizeof(magic));
+    if(std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0
+       || reader.read<guint32>() != SNAPSHOT_VERSION
+       || reader.read<guint32>() != BYTE_ORDER_MARK) {
+      throw std::runtime_error("Unsupported snapshot format");
+    }
+    if(reader.read_string() != m_manager.notes_dir()) {
+      throw std::runtime_error("Snapshot is for different note directory");
+    }
+
+    auto count = reader.read<guint32>();
+    m_records.reserve(count);
+    for(guint32 i = 0; i < count; ++i) {
+      auto name = reader.read_string();
+      Record record;
+      record.stamp.mtime_sec = reader.read<gint64>();
+      record.stamp.mtime_nsec = reader.read<gint64>();
+      record.stamp.size = reader.read<gint64>();
+      record.stamp.inode = reader.read<guint64>();
+      record.title = reader.read_string();
+      record.create_date = reader.read_string();
+      record.change_date = reader.read_string();
+      record.metadata_change_date = reader.read_string();
+      record.cursor_position = reader.read<gint32>();
+      record.selection_bound_position = reader.read<gint32>();
+      record.width = reader.read<gint32>();
+      record.height = reader.read<gint32>();
+      auto tag_count = reader.read<guint32>();
+      for(guint32 t = 0; t < tag_count; ++t) {
+        record.tags.push_back(reader.read_string());
+      }
+      record.restamp = false;
+      m_records.emplace(std::move(name), std::move(record));
+    }
+
+    if(!reader.at_end()) {
+      throw std::runtime_error("Trailing data in snapshot");
+    }
+    ret = true;
+  }
+  catch(std::exception & e) {
+    ERR_OUT("Ignoring note snapshot %s: %s", file.c_str(), e.what());
+    m_records.clear();
+  }
+
+  g_mapped_file_unref(mapped);
+  return ret;
+}
+
+void NoteSnapshot::save(const Glib::ustring & file)
+{
+  for(auto iter = m_records.begin(); iter != m_records.end();) {
+    if(!iter->second.restamp) {
+      ++iter;
+    }
+    else if(auto stamp = file_stamp(Glib::build_filename(m_manager.notes_dir(), iter->first))) {
+      iter->second.stamp = *stamp;
+      iter->second.restamp = false;
+      ++iter;
+    }
+    else {
+      iter = m_records.erase(iter);
+    }
+  }
+
+  SnapshotWriter writer;
+  writer.write_bytes(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  writer.write<guint32>(SNAPSHOT_VERSION);
+  writer.write<guint32>(BYTE_ORDER_MARK);
+  writer.write_string(m_manager.notes_dir());
+  writer.write<guint32>(m_records.size());
+  for(const auto & rec : m_records) {
+    const Record & record = rec.second;
+    writer.write_string(rec.first);
+    writer.write<gint64>(record.stamp.mtime_sec);
+    writer.write<gint64>(record.stamp.mtime_nsec);
+    writer.write<gint64>(record.stamp.size);
+    writer.write<guint64>(record.stamp.inode);
+    writer.write_string(record.title);
+    writer.write_string(record.create_date);
+    writer.write_string(record.change_date);
+    writer.write_string(record.metadata_change_date);
+    writer.write<gint32>(record.cursor_position);
+    writer.write<gint32>(record.selection_bound_position);
+    writer.write<gint32>(record.width);
+    writer.write<gint32>(record.height);
+    writer.write<guint32>(record.tags.size());
+    for(const auto & tag : record.tags) {
+      writer.write_string(tag);
+    }
+  }
+
+  try {
+    auto dir = Glib::path_get_dirname(file);
+    g_mkdir_with_parents(dir.c_str(), S_IRWXU);
+
+    Glib::ustring tmp_file = file + ".tmp";
+    {
+      std::ofstream out(tmp_file, std::ios::binary);
+      out.write(writer.buffer().data(), writer.buffer().size());
+      if(!out.good()) {
+        throw sharp::Exception("Failed to write file: " + tmp_file);
+      }
+    }
+
+    utils::replace_file_with_temp(file, tmp_file);
+    m_modified = false;
+  }
+  catch(std::exception & e) {
+    ERR_OUT("Failed to save note snapshot %s: %s", file.c_str(), e.what());
+  }
+}
+
+bool NoteSnapshot::read(const FileStamp & stamp, NoteArchiver::ParsedNote & note) const
+{
+  auto rec = m_records.find(sharp::file_filename(note.file));
+  if(rec == m_records.end() || rec->second.restamp || !(rec->second.stamp == stamp)) {
+    return false;
+  }
+
+  const Record & record = rec->second;
+  note.data = std::make_unique<NoteData>(NoteBase::url_from_path(note.file));
+  NoteData & data = *note.data;
+  data.title() = record.title;
+  data.create_date() = sharp::XmlConvert::to_date_time(record.create_date);
+  data.set_change_date(sharp::XmlConvert::to_date_time(record.change_date));
+  data.metadata_change_date() = sharp::XmlConvert::to_date_time(record.metadata_change_date);
+  data.set_cursor_position(record.cursor_position);
+  data.set_selection_bound_position(record.selection_bound_position);
+  data.width() = record.width;
+  data.height() = record.height;
+  note.tags = record.tags;
+  note.version = NoteArchiver::CURRENT_VERSION;
+  note.has_text = false;
+  return true;
+}
+
+void NoteSnapshot::update(const NoteBase & note)
+{
+  // note was just saved, so the text is in memory, synchronized data is cheap
+  const NoteData & data = note.data();
+  std::vector<Glib::ustring> tags;
+  for(const auto & normalized : data.tags()) {
+    if(auto tag = m_manager.tag_manager().get_tag(normalized)) {
+      tags.push_back(tag.value().get().name());
+    }
+  }
+
+  // file is written on background thread, so the stamp is not known yet
+  store(note.file_path(), FileStamp{0, 0, 0, 0}, data, std::move(tags)).restamp = true;
+}
+
+void NoteSnapshot::update(const NoteArchiver::ParsedNote & note, const FileStamp & stamp)
+{
+  store(note.file, stamp, *note.data, std::vector<Glib::ustring>(note.tags));
+}
+
+NoteSnapshot::Record & NoteSnapshot::store(const Glib::ustring & file, const FileStamp & stamp, const NoteData & data, std::vector<Glib::ustring> && tags)
+{
+  Record record;
+  record.stamp = stamp;
+  record.title = data.title();
+  record.create_date = date_to_string(data.create_date());
+  record.change_date = date_to_string(data.change_date());
+  record.metadata_change_date = date_to_string(data.metadata_change_date());
+  record.cursor_position = data.cursor_position();
+  record.selection_bound_position = data.selection_bound_position();
+  record.width = data.width();
+  record.height = data.height();
+  record.tags = std::move(tags);
+  record.restamp = false;
+  m_modified = true;
+  return m_records[sharp::file_filename(file)] = std::move(record);
+}
+
+void NoteSnapshot::remove(const Glib::ustring & file)
+{
+  if(m_records.erase(sharp::file_filename(file))) {
+    m_modified = true;
+  }
+}
+
+void NoteSnapshot::retain(const std::vector<Glib::ustring> & files)
+{
+  std::unordered_set<Glib::ustring, Hash<Glib::ustring>> names;
+  for(const auto & file : files) {
+    names.insert(sharp::file_filename(file));
+  }
+
+  for(auto iter = m_records.begin(); iter != m_records.end();) {
+    if(names.find(iter->first) == names.end()) {
+      iter = m_records.erase(iter);
+      m_modified = true;
+    }
+    else {
+      ++iter;
+    }
+  }
+}
+
+}
@@ -0,0 +1,107 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _NOTESNAPSHOT_HPP_
+#define _NOTESNAPSHOT_HPP_
+
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "notebase.hpp"
+
+
+namespace gnote {
+
+/**
+ * Snapshot of note metadata, so that note files don't have to be parsed at startup.
+ *
+ * For every note file it holds the file stamp (modification time, size and
+ * inode) and everything, except the text, that is in the file. Record is only
+ * used, if the file still has the same stamp, otherwise the file is parsed.
+ * Snapshot is stored in binary format and is read via memory mapping.
+ */
+class NoteSnapshot
+{
+public:
+  struct FileStamp
+  {
+    gint64 mtime_sec;
+    gint64 mtime_nsec;
+    gint64 size;
+    guint64 inode;
+
+    bool operator==(const FileStamp & other) const
+      {
+        return mtime_sec == other.mtime_sec && mtime_nsec == other.mtime_nsec && size == other.size && inode == other.inode;
+      }
+  };
+
+  static std::optional<FileStamp> file_stamp(const Glib::ustring & file);
+
+  explicit NoteSnapshot(NoteManagerBase & manager);
+
+  // false, if snapshot is missing, corrupt or for a different note directory
+  bool load(const Glib::ustring & file);
+  void save(const Glib::ustring & file);
+  // fill in the note from snapshot, if the record is up to date with the stamp
+  bool read(const FileStamp & stamp, NoteArchiver::ParsedNote & note) const;
+  // file might not be written yet, stamp is taken when snapshot is saved
+  void update(const NoteBase & note);
+  void update(const NoteArchiver::ParsedNote & note, const FileStamp & stamp);
+  void remove(const Glib::ustring & file);
+  // drop records for files that are not in the list
+  void retain(const std::vector<Glib::ustring> & files);
+  std::size_t size() const
+    {
+      return m_records.size();
+    }
+  bool is_modified() const
+    {
+      return m_modified;
+    }
+private:
+  struct Record
+  {
+    FileStamp stamp;
+    Glib::ustring title;
+    Glib::ustring create_date;
+    Glib::ustring change_date;
+    Glib::ustring metadata_change_date;
+    gint32 cursor_position;
+    gint32 selection_bound_position;
+    gint32 width;
+    gint32 height;
+    std::vector<Glib::ustring> tags;
+    // stamp has to be taken from the file before saving
+    bool restamp;
+  };
+
+  Record & store(const Glib::ustring & file, const FileStamp & stamp, const NoteData & data, std::vector<Glib::ustring> && tags);
+
+  NoteManagerBase & m_manager;
+  // file name (without directory) to record
+  std::unordered_map<Glib::ustring, Record, Hash<Glib::ustring>> m_records;
+  bool m_modified;
+};
+
+}
+
+#endif
@@ -0,0 +1,279 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+#include <glibmm/i18n.h>
+#include <glibmm/miscutils.h>
+
+#include "debug.hpp"
+#include "notewriter.hpp"
+#include "utils.hpp"
+#include "sharp/exception.hpp"
+
+
+namespace gnote {
+
+NoteWriter::NoteWriter(std::size_t max_pending)
+  : m_max_pending(std::max<std::size_t>(max_pending, 1))
+  , m_written_count(0)
+  , m_batch_count(0)
+  , m_durability(Durability::BATCH)
+  , m_stop(false)
+  , m_self(std::make_shared<NoteWriter*>(this))
+{
+  m_thread = std::thread([this] { writer_thread(); });
+}
+
+NoteWriter::~NoteWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_stop = true;
+  }
+  m_queued.notify_all();
+  m_thread.join();
+}
+
+void NoteWriter::write(const Glib::ustring & file, Glib::ustring && content)
+{
+  std::unique_lock<std::mutex> lock(m_lock);
+  auto pending = m_pending.find(file);
+  if(pending != m_pending.end()) {
+    // not written yet, only the latest content matters
+    pending->second = std::move(content);
+    return;
+  }
+
+  m_written.wait(lock, [this] { return m_pending.size() < m_max_pending; });
+  m_pending.emplace(file, std::move(content));
+  m_order.push_back(file);
+  lock.unlock();
+  m_queued.notify_one();
+}
+
+void NoteWriter::flush()
+{
+  std::unique_lock<std::mutex> lock(m_lock);
+  m_written.wait(lock, [this] { return m_pending.empty() && m_in_progress.empty(); });
+}
+
+bool NoteWriter::is_pending(const Glib::ustring & file) const
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  return m_pending.find(file) != m_pending.end() || m_in_progress.find(file) != m_in_progress.end();
+}
+
+void NoteWriter::durability(Durability durability)
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_durability = durability;
+}
+
+Durability NoteWriter::durability() const
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  return m_durability;
+}
+
+std::size_t NoteWriter::written_count() const
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  return m_written_count;
+}
+
+std::size_t NoteWriter::batch_count() const
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  return m_batch_count;
+}
+
+void NoteWriter::writer_thread()
+{
+  std::vector<std::pair<Glib::ustring, Glib::ustring>> batch;
+  std::unique_lock<std::mutex> lock(m_lock);
+  while(true) {
+    m_queued.wait(lock, [this] { return m_stop || !m_order.empty(); });
+    if(m_order.empty()) {
+      // stopped and everything is written
+      break;
+    }
+
+    while(!m_order.empty() && batch.size() < BATCH_SIZE) {
+      auto file = std::move(m_order.front());
+      m_order.pop_front();
+      auto pending = m_pending.find(file);
+      batch.emplace_back(std::move(file), std::move(pending->second));
+      m_pending.erase(pending);
+      m_in_progress.insert(batch.back().first);
+    }
+
+    auto durability = m_durability;
+    lock.unlock();
+    write_batch(batch, durability);
+    lock.lock();
+
+    m_in_progress.clear();
+    m_written_count += batch.size();
+    ++m_batch_count;
+    batch.clear();
+    m_written.notify_all();
+  }
+}
+
+void NoteWriter::write_batch(const std::vector<std::pair<Glib::ustring, Glib::ustring>> & batch, Durability durability)
+{
+  if(durability != Durability::BATCH) {
+    for(const auto & item : batch) {
+      try {
+        write_file(item.first, item.second, durability);
+      }
+      catch(const std::exception & e) {
+        report_failure(item.first, e.what());
+      }
+    }
+    return;
+  }
+
+  // All files are written first and only then synced, so that file system can flush them together.
+  // No note is replaced before data of its new content is on disk.
+  std::vector<std::pair<const Glib::ustring*, int>> written;
+  written.reserve(batch.size());
+  for(const auto & item : batch) {
+    try {
+      written.emplace_back(&item.first, write_tmp_file(item.first + ".tmp", item.second));
+    }
+    catch(const std::exception & e) {
+      report_failure(item.first, e.what());
+    }
+  }
+
+  std::vector<const Glib::ustring*> synced;
+  synced.reserve(written.size());
+  for(const auto & item : written) {
+    try {
+      close_tmp_file(item.second, *item.first + ".tmp", true);
+      synced.push_back(item.first);
+    }
+    catch(const std::exception & e) {
+      report_failure(*item.first, e.what());
+    }
+  }
+
+  std::unordered_set<Glib::ustring, Hash<Glib::ustring>> written_dirs;
+  for(const auto file : synced) {
+    try {
+      replace_file(*file + ".tmp", *file);
+      written_dirs.insert(Glib::path_get_dirname(*file));
+    }
+    catch(const std::exception & e) {
+      report_failure(*file, e.what());
+    }
+  }
+
+  // one sync makes all renames in the directory durable
+  for(const auto & dir : written_dirs) {
+    fsync_path(dir);
+  }
+}
+
+void NoteWriter::report_failure(const Glib::ustring & file, const Glib::ustring & error)
+{
+  ERR_OUT(_("Exception while saving note: %s"), error.c_str());
+  // always queued to main loop, writer might be gone by the time it runs
+  std::weak_ptr<NoteWriter*> self = m_self;
+  utils::timeout_add_once(0, [self, file, error] {
+    if(auto writer = self.lock()) {
+      (*writer)->signal_write_failed(file, error);
+    }
+  });
+}
+
+void NoteWriter::write_file(const Glib::ustring & file, const Glib::ustring & content, Durability durability)
+{
+  Glib::ustring tmp_file = file + ".tmp";
+  int fd = write_tmp_file(tmp_file, content);
+  close_tmp_file(fd, tmp_file, durability == Durability::FILE);
+  replace_file(tmp_file, file);
+  if(durability == Durability::FILE) {
+    fsync_path(Glib::path_get_dirname(file));
+  }
+}
+
+int NoteWriter::write_tmp_file(const Glib::ustring & tmp_file, const Glib::ustring & content)
+{
+  int fd = g_open(tmp_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if(fd < 0) {
+    throw sharp::Exception(Glib::ustring::compose("Failed to create %1: %2", tmp_file, Glib::ustring(std::strerror(errno))));
+  }
+
+  const char *data = content.data();
+  std::size_t remaining = content.bytes();
+  while(remaining > 0) {
+    auto written = ::write(fd, data, remaining);
+    if(written < 0 && errno == EINTR) {
+      continue;
+    }
+    if(written <= 0) {
+      int err = errno;
+      close(fd);
+      g_unlink(tmp_file.c_str());
+      throw sharp::Exception(Glib::ustring::compose("Failed to write %1: %2", tmp_file, Glib::ustring(std::strerror(err))));
+    }
+    data += written;
+    remaining -= written;
+  }
+  return fd;
+}
+
+void NoteWriter::close_tmp_file(int fd, const Glib::ustring & tmp_file, bool sync)
+{
+  bool ok = true;
+  int err = 0;
+  if(sync) {
+    ok = fsync_fd(fd);
+    err = errno;
+  }
+  if(close(fd) != 0 && ok) {
+    ok = false;
+    err = errno;
+  }
+  if(!ok) {
+    g_unlink(tmp_file.c_str());
+    throw sharp::Exception(Glib::ustring::compose("Failed to write %1: %2", tmp_file, Glib::ustring(std::strerror(err))));
+  }
+}
+
+void NoteWriter::replace_file(const Glib::ustring & tmp_file, const Glib::ustring & file)
+{
+  // rename replaces the note atomically, so readers on main thread never miss it
+  if(g_rename(tmp_file.c_str(), file.c_str()) != 0) {
+    int err = errno;
+    g_unlink(tmp_file.c_str());
+    throw sharp::Exception(Glib::ustring::compose("Failed to rename %1: %2", tmp_file, Glib::ustring(std::strerror(err))));
+  }
+}
+
+}
@@ -0,0 +1,106 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _NOTEWRITER_HPP_
+#define _NOTEWRITER_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <glibmm/ustring.h>
+#include <sigc++/signal.h>
+
+#include "durability.hpp"
+#include "base/hash.hpp"
+
+
+namespace gnote {
+
+/**
+ * Writes serialized notes to disk on a background thread.
+ *
+ * Notes are serialized on the main thread and only the resulting content is
+ * handed over, so the writer thread never touches the notes. Content queued for
+ * a file, that is not written yet, replaces the previous one. Queued files are
+ * written in batches, each to a temporary file, that is then renamed over the
+ * note. When too many files are queued, write() blocks until the writer thread
+ * catches up. Files are synced to disk according to durability setting.
+ */
+class NoteWriter
+{
+public:
+  static constexpr std::size_t DEFAULT_MAX_PENDING = 64;
+  static constexpr std::size_t BATCH_SIZE = 16;
+
+  explicit NoteWriter(std::size_t max_pending = DEFAULT_MAX_PENDING);
+  // writes all queued files
+  ~NoteWriter();
+
+  void write(const Glib::ustring & file, Glib::ustring && content);
+  // wait until all queued files are written, can be called from any thread
+  void flush();
+  bool is_pending(const Glib::ustring & file) const;
+  // applies starting with the next batch
+  void durability(Durability durability);
+  Durability durability() const;
+  std::size_t written_count() const;
+  std::size_t batch_count() const;
+
+  // emitted on main thread with file name and error message
+  sigc::signal<void(const Glib::ustring &, const Glib::ustring &)> signal_write_failed;
+private:
+  void writer_thread();
+  void write_batch(const std::vector<std::pair<Glib::ustring, Glib::ustring>> & batch, Durability durability);
+  void report_failure(const Glib::ustring & file, const Glib::ustring & error);
+  static void write_file(const Glib::ustring & file, const Glib::ustring & content, Durability durability);
+  // returns open descriptor of fully written file
+  static int write_tmp_file(const Glib::ustring & tmp_file, const Glib::ustring & content);
+  static void close_tmp_file(int fd, const Glib::ustring & tmp_file, bool sync);
+  static void replace_file(const Glib::ustring & tmp_file, const Glib::ustring & file);
+
+  const std::size_t m_max_pending;
+  mutable std::mutex m_lock;
+  // signaled when files are queued or writer is stopped
+  std::condition_variable m_queued;
+  // signaled when a batch is written
+  std::condition_variable m_written;
+  // files in the order they were queued, content is in m_pending
+  std::deque<Glib::ustring> m_order;
+  std::unordered_map<Glib::ustring, Glib::ustring, Hash<Glib::ustring>> m_pending;
+  // files of the batch being written
+  std::unordered_set<Glib::ustring, Hash<Glib::ustring>> m_in_progress;
+  std::size_t m_written_count;
+  std::size_t m_batch_count;
+  Durability m_durability;
+  bool m_stop;
+  // failure notifications hold a weak reference, so they are dropped once writer is destroyed
+  std::shared_ptr<NoteWriter*> m_self;
+  std::thread m_thread;
+};
+
+}
+
+#endif
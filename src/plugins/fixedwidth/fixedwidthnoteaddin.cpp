@@ -47,24 +47,27 @@ namespace fixedwidth {
 
 
 
+  Glib::RefPtr<Gtk::TextTag> FixedWidthNoteAddin::s_tag;
+  unsigned FixedWidthNoteAddin::s_instances = 0;
+
   void FixedWidthNoteAddin::initialize()
   {
+    ++s_instances;
     // If a tag of this name already exists, don't install.
     auto tag_table = get_note().get_tag_table();
     if(!tag_table->lookup("monospace")) {
-      auto tag = Glib::make_refptr_for_instance(new FixedWidthTag);
-      m_tag = tag;
-      tag_table->add(std::move(tag));
-  }
+      s_tag = Glib::make_refptr_for_instance(new FixedWidthTag);
+      tag_table->add(s_tag);
+    }
   }
 
 
   void FixedWidthNoteAddin::shutdown()
   {
-    // Remove the tag only if we installed it.
-    if(m_tag) {
-      get_note().get_tag_table()->remove(m_tag);
-      m_tag.reset();
+    // Remove the tag only if we installed it and no other note uses it.
+    if(--s_instances == 0 && s_tag) {
+      get_note().get_tag_table()->remove(s_tag);
+      s_tag.reset();
     }
   }
 
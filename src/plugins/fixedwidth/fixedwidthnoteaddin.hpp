@@ -65,7 +65,10 @@ namespace fixedwidth {
     void on_menu_item_state_changed(const Glib::VariantBase & state);
     void add_menu_item(gnote::NoteTextMenu & menu);
 
-    Glib::RefPtr<Gtk::TextTag> m_tag;
+    // the tag table is shared by all notes, the installed tag is removed
+    // when the addin of the last note is shut down
+    static Glib::RefPtr<Gtk::TextTag> s_tag;
+    static unsigned s_instances;
     sigc::connection           m_menu_item_cid;
   };
 
@@ -44,23 +44,27 @@ namespace underline {
 
 
 
+  Glib::RefPtr<Gtk::TextTag> UnderlineNoteAddin::s_tag;
+  unsigned UnderlineNoteAddin::s_instances = 0;
+
   void UnderlineNoteAddin::initialize()
   {
+    ++s_instances;
     // If a tag of this name already exists, don't install.
     auto & tag_table = get_note().get_tag_table();
     if(!tag_table->lookup("underline")) {
-      m_tag = Glib::make_refptr_for_instance(new UnderlineTag());
-      tag_table->add(m_tag);
+      s_tag = Glib::make_refptr_for_instance(new UnderlineTag());
+      tag_table->add(s_tag);
     }
   }
 
 
   void UnderlineNoteAddin::shutdown()
   {
-    // Remove the tag only if we installed it.
-    if(m_tag) {
-      get_note().get_tag_table()->remove(m_tag);
-      m_tag.reset();
+    // Remove the tag only if we installed it and no other note uses it.
+    if(--s_instances == 0 && s_tag) {
+      get_note().get_tag_table()->remove(s_tag);
+      s_tag.reset();
     }
   }
 
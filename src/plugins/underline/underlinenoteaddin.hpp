@@ -62,7 +62,10 @@ namespace underline {
     void on_underline_clicked(const Glib::VariantBase & state);
     void on_underline_pressed();
 
-    Glib::RefPtr<Gtk::TextTag> m_tag;
+    // the tag table is shared by all notes, the installed tag is removed
+    // when the addin of the last note is shut down
+    static Glib::RefPtr<Gtk::TextTag> s_tag;
+    static unsigned s_instances;
     sigc::connection           m_on_underline_clicked_cid;
   };
 
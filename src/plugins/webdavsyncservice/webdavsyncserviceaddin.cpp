@@ -54,7 +54,10 @@ class WebDavSyncServer
 public:
   static std::unique_ptr<WebDavSyncServer> create(Glib::RefPtr<Gio::File> && path, Preferences & prefs)
     {
-      return std::make_unique<WebDavSyncServer>(std::move(path), prefs.sync_client_id());
+      auto server = std::make_unique<WebDavSyncServer>(std::move(path), prefs.sync_client_id());
+      server->durability(gnote::durability_from_string(prefs.note_write_durability()));
+      server->pack_revisions(prefs.sync_pack_revisions());
+      return server;
     }
 
   WebDavSyncServer(Glib::RefPtr<Gio::File> && local_sync_path, const Glib::ustring & client_id)
@@ -75,7 +78,7 @@ protected:
 
   virtual std::optional<unsigned> max_concurrent_transfers() const
     {
-      return 4;
+      return 16;
     }
 };
 
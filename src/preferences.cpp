@@ -98,6 +98,9 @@ const Glib::ustring SEARCH_SORTING = "search-sorting";
 const Glib::ustring USE_CLIENT_SIDE_DECORATIONS = "use-client-side-decorations";
 const Glib::ustring COLOR_SCHEME = "color-scheme";
 const Glib::ustring EDITOR_TAB_WIDTH = "editor-tab-width";
+const Glib::ustring NOTE_TEXT_CACHE_SIZE = "note-text-cache-size";
+const Glib::ustring NOTE_BUFFER_IDLE_TIMEOUT = "note-buffer-idle-timeout";
+const Glib::ustring NOTE_WRITE_DURABILITY = "note-write-durability";
 
 const Glib::ustring DESKTOP_GNOME_CLOCK_FORMAT = "clock-format";
 const Glib::ustring DESKTOP_GNOME_FONT = "document-font-name";
@@ -107,6 +110,7 @@ const Glib::ustring SYNC_LOCAL_PATH = "sync-local-path";
 const Glib::ustring SYNC_SELECTED_SERVICE_ADDIN = "sync-selected-service-addin";
 const Glib::ustring SYNC_CONFIGURED_CONFLICT_BEHAVIOR = "sync-conflict-behavior";
 const Glib::ustring SYNC_AUTOSYNC_TIMEOUT = "autosync-timeout";
+const Glib::ustring SYNC_PACK_REVISIONS = "pack-revisions";
 
 const Glib::ustring SYNC_FUSE_MOUNT_TIMEOUT = "sync-fuse-mount-timeout-ms";
 const Glib::ustring SYNC_FUSE_WDFS_ACCEPT_SSLCERT = "accept-sslcert";
@@ -166,12 +170,16 @@ namespace gnote {
   DEFINE_GETTER_SETTER_STRING(m_schema_gnote, search_sorting, SEARCH_SORTING)
   DEFINE_GETTER_SETTER_STRING(m_schema_gnote, use_client_side_decorations, USE_CLIENT_SIDE_DECORATIONS)
   DEFINE_CACHING_SETTER_STRING(m_schema_gnote, color_scheme, COLOR_SCHEME)
+  DEFINE_GETTER_SETTER_INT(m_schema_gnote, note_text_cache_size, NOTE_TEXT_CACHE_SIZE)
+  DEFINE_GETTER_SETTER_INT(m_schema_gnote, note_buffer_idle_timeout, NOTE_BUFFER_IDLE_TIMEOUT)
+  DEFINE_GETTER_SETTER_STRING(m_schema_gnote, note_write_durability, NOTE_WRITE_DURABILITY)
 
   DEFINE_GETTER_STRING(m_schema_sync, sync_client_id, SYNC_CLIENT_ID)
   DEFINE_GETTER_SETTER_STRING(m_schema_sync, sync_local_path, SYNC_LOCAL_PATH)
   DEFINE_CACHING_SETTER_STRING(m_schema_sync, sync_selected_service_addin, SYNC_SELECTED_SERVICE_ADDIN)
   DEFINE_GETTER_SETTER_INT(m_schema_sync, sync_configured_conflict_behavior, SYNC_CONFIGURED_CONFLICT_BEHAVIOR)
   DEFINE_CACHING_SETTER_INT(m_schema_sync, sync_autosync_timeout, SYNC_AUTOSYNC_TIMEOUT)
+  DEFINE_GETTER_SETTER_BOOL(m_schema_sync, sync_pack_revisions, SYNC_PACK_REVISIONS)
 
   DEFINE_GETTER_SETTER_INT(m_schema_sync_wdfs, sync_fuse_mount_timeout, SYNC_FUSE_MOUNT_TIMEOUT)
   DEFINE_GETTER_SETTER_BOOL(m_schema_sync_wdfs, sync_fuse_wdfs_accept_sllcert, SYNC_FUSE_WDFS_ACCEPT_SSLCERT)
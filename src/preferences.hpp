@@ -82,6 +82,9 @@ namespace gnote {
     GNOTE_PREFERENCES_SETTING_STRING(use_client_side_decorations)
     GNOTE_PREFERENCES_CACHING_SETTING(color_scheme, const Glib::ustring&)
     GNOTE_PREFERENCES_CACHING_SETTING(editor_tab_width, unsigned);
+    GNOTE_PREFERENCES_SETTING_INT(note_text_cache_size)
+    GNOTE_PREFERENCES_SETTING_INT(note_buffer_idle_timeout)
+    GNOTE_PREFERENCES_SETTING_STRING(note_write_durability)
 
     GNOTE_PREFERENCES_CACHING_SETTING_RO(desktop_gnome_clock_format, const Glib::ustring &)
 
@@ -91,6 +94,7 @@ namespace gnote {
     GNOTE_PREFERENCES_CACHING_SETTING(sync_selected_service_addin, const Glib::ustring &)
     GNOTE_PREFERENCES_SETTING_INT(sync_configured_conflict_behavior)
     GNOTE_PREFERENCES_CACHING_SETTING(sync_autosync_timeout, int)
+    GNOTE_PREFERENCES_SETTING_BOOL(sync_pack_revisions)
 
     GNOTE_PREFERENCES_SETTING_INT(sync_fuse_mount_timeout)
     GNOTE_PREFERENCES_SETTING_BOOL(sync_fuse_wdfs_accept_sllcert)
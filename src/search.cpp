@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2011,2013-2014,2017,2019,2023-2024 Aurimas Cernius
+ * Copyright (C) 2011,2013-2014,2017,2019,2023-2024,2026 Aurimas Cernius
  * Copyright (C) 2009 Hubert Figuiere
  *
  * This program is free software: you can redistribute it and/or modify
@@ -24,6 +24,7 @@
 #include "sharp/string.hpp"
 #include "notemanagerbase.hpp"
 #include "search.hpp"
+#include "searchindex.hpp"
 #include "utils.hpp"
 
 namespace gnote {
@@ -50,11 +51,15 @@ namespace gnote {
     std::vector<Glib::ustring> encoded_words;
     Search::split_watching_quotes(encoded_words, utils::XmlEncoder::encode(search_text));
     Results temp_matches;
+
+    // Notes, that have no chance to match, are not looked into
+    const SearchIndex & index = m_manager.search_index();
+    auto candidates = index.find_candidates(words);
       
       // Skip over notes that are template notes
     auto &template_tag = m_manager.tag_manager().get_or_create_system_tag(ITagManager::TEMPLATE_NOTE_SYSTEM_TAG);
 
-    m_manager.for_each([this, &temp_matches, template_tag, selected_notebook, case_sensitive, words=std::move(words), encoded_words=std::move(encoded_words)](NoteBase & note) {
+    m_manager.for_each([this, &temp_matches, template_tag, selected_notebook, case_sensitive, &index, &candidates, words=std::move(words), encoded_words=std::move(encoded_words)](NoteBase & note) {
       // Skip template notes
       if(note.contains_tag(template_tag)) {
         return;
@@ -73,6 +78,9 @@ namespace gnote {
       if(0 < find_match_count_in_note(note.get_title(), words, case_sensitive)) {
         temp_matches.insert(std::make_pair(INT_MAX, std::ref(note)));
       }
+      else if(candidates && index.is_indexed(note.uri()) && candidates->find(note.uri()) == candidates->end()) {
+        return;
+      }
       else if(check_note_has_match(note, encoded_words, case_sensitive)) {
         int match_count = find_match_count_in_note(note.text_content(), words, case_sensitive);
         if (match_count > 0) {
@@ -0,0 +1,424 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include <glib/gstdio.h>
+#include <glibmm/miscutils.h>
+#include <glibmm/unicode.h>
+
+#include "debug.hpp"
+#include "notemanagerbase.hpp"
+#include "searchindex.hpp"
+#include "utils.hpp"
+#include "sharp/files.hpp"
+#include "sharp/xmlconvert.hpp"
+
+
+namespace gnote {
+
+namespace {
+
+const char *INDEX_FILE_HEADER = "gnote-search-index 2";
+
+guint32 trigram(const std::string & term, std::size_t pos)
+{
+  return (guint32(guchar(term[pos])) << 16) | (guint32(guchar(term[pos + 1])) << 8) | guchar(term[pos + 2]);
+}
+
+}
+
+
+std::vector<std::string> SearchIndex::split_terms(const Glib::ustring & text)
+{
+  std::vector<std::string> terms;
+  std::string term;
+  for(gunichar c : text) {
+    if(Glib::Unicode::isalnum(c)) {
+      char buf[6];
+      gunichar lower = Glib::Unicode::tolower(c);
+      // Glib::ustring::lowercase() is context and locale sensitive for these
+      if(lower == 0x03C2) {  // final sigma
+        lower = 0x03C3;
+      }
+      else if(lower == 0x0131) {  // dotless i
+        lower = 'i';
+      }
+      int len = g_unichar_to_utf8(lower, buf);
+      term.append(buf, len);
+    }
+    else if(!term.empty()) {
+      terms.push_back(term);
+      term.clear();
+    }
+  }
+
+  if(!term.empty()) {
+    terms.push_back(std::move(term));
+  }
+
+  return terms;
+}
+
+
+SearchIndex::SearchIndex(NoteManagerBase & manager)
+  : m_manager(manager)
+  , m_modified(false)
+{
+  m_manager.signal_note_added.connect(sigc::mem_fun(*this, &SearchIndex::on_note_added));
+  m_manager.signal_note_saved.connect(sigc::mem_fun(*this, &SearchIndex::on_note_saved));
+  m_manager.signal_note_deleted.connect(sigc::mem_fun(*this, &SearchIndex::on_note_deleted));
+}
+
+bool SearchIndex::load(const Glib::ustring & file)
+{
+  if(file.empty()) {
+    return false;
+  }
+
+  std::ifstream fin(file);
+  if(!fin.is_open()) {
+    return false;
+  }
+
+  std::string line;
+  if(!std::getline(fin, line) || line != INDEX_FILE_HEADER) {
+    DBG_OUT_1("Search index %s has unknown format, ignoring", file.c_str());
+    return false;
+  }
+  if(!std::getline(fin, line) || line != m_manager.notes_dir().raw()) {
+    DBG_OUT_1("Search index %s is for different note directory, ignoring", file.c_str());
+    return false;
+  }
+
+  clear();
+  try {
+    // one note per line: <uri>\t<stamp>\t<term> ...
+    while(std::getline(fin, line)) {
+      auto uri_end = line.find('\t');
+      auto stamp_end = uri_end == std::string::npos ? uri_end : line.find('\t', uri_end + 1);
+      if(stamp_end == std::string::npos) {
+        throw std::runtime_error("Malformed note entry");
+      }
+
+      std::unordered_set<std::string> terms;
+      std::istringstream term_stream(line.substr(stamp_end + 1));
+      std::string term;
+      while(term_stream >> term) {
+        terms.insert(std::move(term));
+      }
+
+      add_document(line.substr(0, uri_end), line.substr(uri_end + 1, stamp_end - uri_end - 1), terms);
+    }
+  }
+  catch(std::exception & e) {
+    ERR_OUT("Failed to load search index %s: %s", file.c_str(), e.what());
+    clear();
+    return false;
+  }
+
+  m_modified = false;
+  return true;
+}
+
+void SearchIndex::save(const Glib::ustring & file)
+{
+  if(file.empty()) {
+    return;
+  }
+
+  try {
+    auto dir = Glib::path_get_dirname(file);
+    g_mkdir_with_parents(dir.c_str(), S_IRWXU);
+
+    Glib::ustring tmp_file = file + ".tmp";
+    {
+      std::ofstream fout(tmp_file);
+      if(!fout.is_open()) {
+        throw sharp::Exception("Failed to open file: " + tmp_file);
+      }
+
+      fout << INDEX_FILE_HEADER << '\n' << m_manager.notes_dir().raw() << '\n';
+      for(const auto & doc : m_documents) {
+        if(m_invalidated.find(doc.first) != m_invalidated.end()) {
+          // stamp will not match on load and the note will get reindexed
+          continue;
+        }
+        fout << doc.first.raw() << '\t' << doc.second.stamp.raw() << '\t';
+        for(const auto & term : doc.second.terms) {
+          fout << term << ' ';
+        }
+        fout << '\n';
+      }
+
+      if(!fout.good()) {
+        throw sharp::Exception("Failed to write to file");
+      }
+    }
+
+    utils::replace_file_with_temp(file, tmp_file);
+    m_modified = false;
+  }
+  catch(std::exception & e) {
+    ERR_OUT("Failed to save search index %s: %s", file.c_str(), e.what());
+  }
+}
+
+void SearchIndex::update()
+{
+  UriSet present;
+  m_manager.for_each([this, &present](NoteBase & note) {
+    present.insert(note.uri());
+    auto doc = m_documents.find(note.uri());
+    if(doc == m_documents.end() || doc->second.stamp != note_stamp(note)) {
+      add_note(note);
+    }
+  });
+
+  std::vector<Glib::ustring> removed;
+  for(const auto & doc : m_documents) {
+    if(present.find(doc.first) == present.end()) {
+      removed.push_back(doc.first);
+    }
+  }
+  for(const auto & uri : removed) {
+    remove_note(uri);
+  }
+}
+
+void SearchIndex::add_note(NoteBase & note)
+{
+  auto text_terms = split_terms(note.text_content());
+  std::unordered_set<std::string> terms(std::make_move_iterator(text_terms.begin()), std::make_move_iterator(text_terms.end()));
+
+  auto uri = note.uri();
+  remove_note(uri);
+  add_document(uri, note_stamp(note), terms);
+}
+
+void SearchIndex::remove_note(const Glib::ustring & uri)
+{
+  m_invalidated.erase(uri);
+  auto doc = m_documents.find(uri);
+  if(doc == m_documents.end()) {
+    return;
+  }
+
+  remove_postings(doc->second);
+  m_document_uris[doc->second.id].clear();
+  m_free_ids.push_back(doc->second.id);
+  m_documents.erase(doc);
+  m_modified = true;
+}
+
+void SearchIndex::invalidate(const NoteBase & note)
+{
+  m_invalidated.insert(note.uri());
+}
+
+bool SearchIndex::is_indexed(const Glib::ustring & uri) const
+{
+  return m_documents.find(uri) != m_documents.end() && m_invalidated.find(uri) == m_invalidated.end();
+}
+
+template <typename F>
+void SearchIndex::for_each_term_containing(const std::string & term, const F & func) const
+{
+  if(term.size() < 3) {
+    // too short for trigrams, these match lots of terms anyway
+    for(const auto & postings : m_postings) {
+      if(postings.first.find(term) != std::string::npos) {
+        func(postings.second);
+      }
+    }
+    return;
+  }
+
+  // every term containing the query one has all of its trigrams, check those having the rarest one
+  const TermSet *rarest = nullptr;
+  for(std::size_t pos = 0; pos + 3 <= term.size(); ++pos) {
+    auto terms = m_trigrams.find(trigram(term, pos));
+    if(terms == m_trigrams.end()) {
+      return;
+    }
+    if(!rarest || terms->second.size() < rarest->size()) {
+      rarest = &terms->second;
+    }
+  }
+
+  for(const auto *postings : *rarest) {
+    if(postings->first.find(term) != std::string::npos) {
+      func(postings->second);
+    }
+  }
+}
+
+std::optional<SearchIndex::UriSet> SearchIndex::find_candidates(const std::vector<Glib::ustring> & words) const
+{
+  std::optional<std::unordered_set<unsigned>> documents;
+  for(const auto & word : words) {
+    for(const auto & term : split_terms(word)) {
+      // search is done by substring, so any indexed term containing the query one matches
+      std::unordered_set<unsigned> term_documents;
+      for_each_term_containing(term, [&term_documents](const PostingList & postings) {
+        term_documents.insert(postings.begin(), postings.end());
+      });
+
+      if(documents) {
+        for(auto iter = documents->begin(); iter != documents->end();) {
+          if(term_documents.find(*iter) == term_documents.end()) {
+            iter = documents->erase(iter);
+          }
+          else {
+            ++iter;
+          }
+        }
+      }
+      else {
+        documents = std::move(term_documents);
+      }
+
+      if(documents->empty()) {
+        return UriSet();
+      }
+    }
+  }
+
+  if(!documents) {
+    // no words to look for in the index
+    return std::optional<UriSet>();
+  }
+
+  UriSet uris;
+  for(auto id : *documents) {
+    uris.insert(m_document_uris[id]);
+  }
+  return uris;
+}
+
+Glib::ustring SearchIndex::note_stamp(const NoteBase & note)
+{
+  // don't look into the text, it might not be loaded
+  const auto & change_date = note.change_date();
+  const auto & metadata_change_date = note.metadata_change_date();
+  return Glib::ustring::compose("%1/%2",
+    change_date ? sharp::XmlConvert::to_string(change_date) : Glib::ustring(),
+    metadata_change_date ? sharp::XmlConvert::to_string(metadata_change_date) : Glib::ustring());
+}
+
+void SearchIndex::on_note_added(NoteBase & note)
+{
+  add_note(note);
+}
+
+void SearchIndex::on_note_saved(NoteBase & note)
+{
+  add_note(note);
+}
+
+void SearchIndex::on_note_deleted(NoteBase & note)
+{
+  remove_note(note.uri());
+}
+
+void SearchIndex::add_document(const Glib::ustring & uri, Glib::ustring && stamp, const std::unordered_set<std::string> & terms)
+{
+  unsigned id;
+  if(m_free_ids.empty()) {
+    id = m_document_uris.size();
+    m_document_uris.push_back(uri);
+  }
+  else {
+    id = m_free_ids.back();
+    m_free_ids.pop_back();
+    m_document_uris[id] = uri;
+  }
+
+  Document doc{id, std::move(stamp), {}};
+  doc.terms.reserve(terms.size());
+  for(const auto & term : terms) {
+    auto inserted = m_postings.try_emplace(term);
+    if(inserted.second) {
+      add_trigrams(*inserted.first);
+    }
+    auto & postings = inserted.first->second;
+    postings.insert(std::lower_bound(postings.begin(), postings.end(), id), id);
+    doc.terms.push_back(term);
+  }
+
+  m_documents.emplace(uri, std::move(doc));
+  m_modified = true;
+}
+
+void SearchIndex::remove_postings(const Document & doc)
+{
+  for(const auto & term : doc.terms) {
+    auto postings = m_postings.find(term);
+    if(postings == m_postings.end()) {
+      continue;
+    }
+
+    auto & list = postings->second;
+    auto pos = std::lower_bound(list.begin(), list.end(), doc.id);
+    if(pos != list.end() && *pos == doc.id) {
+      list.erase(pos);
+    }
+    if(list.empty()) {
+      remove_trigrams(*postings);
+      m_postings.erase(postings);
+    }
+  }
+}
+
+void SearchIndex::add_trigrams(const PostingMap::value_type & term)
+{
+  for(std::size_t pos = 0; pos + 3 <= term.first.size(); ++pos) {
+    m_trigrams[trigram(term.first, pos)].insert(&term);
+  }
+}
+
+void SearchIndex::remove_trigrams(const PostingMap::value_type & term)
+{
+  for(std::size_t pos = 0; pos + 3 <= term.first.size(); ++pos) {
+    auto terms = m_trigrams.find(trigram(term.first, pos));
+    if(terms != m_trigrams.end()) {
+      terms->second.erase(&term);
+      if(terms->second.empty()) {
+        m_trigrams.erase(terms);
+      }
+    }
+  }
+}
+
+void SearchIndex::clear()
+{
+  m_trigrams.clear();
+  m_postings.clear();
+  m_documents.clear();
+  m_document_uris.clear();
+  m_free_ids.clear();
+  m_invalidated.clear();
+  m_modified = false;
+}
+
+}
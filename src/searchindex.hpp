@@ -0,0 +1,117 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _SEARCHINDEX_HPP_
+#define _SEARCHINDEX_HPP_
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "notebase.hpp"
+#include "base/hash.hpp"
+
+
+namespace gnote {
+
+class NoteManagerBase;
+
+/**
+ * Inverted index of words in note text.
+ *
+ * Every word (a run of alphanumeric characters, lower-cased) maps to the notes
+ * containing it. Search matches substrings, so the index is used to narrow down
+ * the notes that can match, the counting is still done on note text. Indexed words are also kept by their trigrams, so
+ * that words containing a query one are found without scanning all of them.
+ * The index is kept up to date from note manager signals and can be persisted,
+ * so that it doesn't have to be rebuilt on startup.
+ */
+class SearchIndex
+{
+public:
+  typedef std::unordered_set<Glib::ustring, Hash<Glib::ustring>> UriSet;
+
+  static std::vector<std::string> split_terms(const Glib::ustring & text);
+
+  explicit SearchIndex(NoteManagerBase & manager);
+
+  bool load(const Glib::ustring & file);
+  void save(const Glib::ustring & file);
+  // bring the index in line with notes in manager
+  void update();
+  void add_note(NoteBase & note);
+  void remove_note(const Glib::ustring & uri);
+  // note has unsaved changes, index is not reliable for it until saved
+  void invalidate(const NoteBase & note);
+  bool is_indexed(const Glib::ustring & uri) const;
+
+  // URIs of notes, that can contain all the words; empty optional, if index can't tell
+  std::optional<UriSet> find_candidates(const std::vector<Glib::ustring> & words) const;
+  std::size_t note_count() const
+    {
+      return m_documents.size();
+    }
+  bool is_modified() const
+    {
+      return m_modified;
+    }
+private:
+  // sorted ids of documents
+  typedef std::vector<unsigned> PostingList;
+  typedef std::unordered_map<std::string, PostingList> PostingMap;
+  // elements of PostingMap, their addresses are stable
+  typedef std::unordered_set<const PostingMap::value_type*> TermSet;
+
+  struct Document
+  {
+    unsigned id;
+    Glib::ustring stamp;
+    std::vector<std::string> terms;
+  };
+
+  static Glib::ustring note_stamp(const NoteBase & note);
+
+  void on_note_added(NoteBase & note);
+  void on_note_saved(NoteBase & note);
+  void on_note_deleted(NoteBase & note);
+  void add_document(const Glib::ustring & uri, Glib::ustring && stamp, const std::unordered_set<std::string> & terms);
+  void remove_postings(const Document & document);
+  void add_trigrams(const PostingMap::value_type & term);
+  void remove_trigrams(const PostingMap::value_type & term);
+  template <typename F>
+  void for_each_term_containing(const std::string & term, const F & func) const;
+  void clear();
+
+  NoteManagerBase & m_manager;
+  PostingMap m_postings;
+  // terms by every 3 byte substring of them, terms shorter than that are not here
+  std::unordered_map<guint32, TermSet> m_trigrams;
+  std::unordered_map<Glib::ustring, Document, Hash<Glib::ustring>> m_documents;
+  std::vector<Glib::ustring> m_document_uris;
+  std::vector<unsigned> m_free_ids;
+  UriSet m_invalidated;
+  bool m_modified;
+};
+
+}
+
+#endif
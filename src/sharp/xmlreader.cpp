@@ -119,6 +119,15 @@ namespace sharp {
     return (res > 0);
   }
 
+  bool XmlReader::skip()
+  {
+    if(m_error) {
+      return false;
+    }
+    int res = xmlTextReaderNext(m_reader);
+    return (res > 0);
+  }
+
   xmlReaderTypes XmlReader::get_node_type()
   {
     int type = xmlTextReaderNodeType(m_reader);
@@ -57,6 +57,10 @@ public:
    *  return false if it couldn't be read. (either end or error)
    */
   bool read();
+  /** skip the children of current node and move to the next one
+   *  return false if it couldn't be read. (either end or error)
+   */
+  bool skip();
 
   xmlReaderTypes get_node_type();
   
@@ -52,6 +52,12 @@ namespace sharp {
     m_writer = xmlNewTextWriterMemory(m_buf, 0);
   }
 
+  XmlWriter::XmlWriter(std::size_t size)
+  {
+    m_buf = xmlBufferCreateSize(size);
+    m_writer = xmlNewTextWriterMemory(m_buf, 0);
+  }
+
   XmlWriter::XmlWriter(const Glib::ustring & filename)
     : m_buf(NULL)
   {
@@ -200,6 +206,12 @@ namespace sharp {
   }
 
 
+  int XmlWriter::flush()
+  {
+    return xmlTextWriterFlush(m_writer);
+  }
+
+
   Glib::ustring XmlWriter::to_string()
   {
     if(!m_buf) {
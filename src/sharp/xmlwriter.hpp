@@ -51,6 +51,8 @@ namespace sharp {
   {
   public:
     XmlWriter();
+    // memory writer with room for size bytes of output
+    explicit XmlWriter(std::size_t size);
     XmlWriter(const Glib::ustring & filename);
     XmlWriter(xmlDocPtr doc);
     ~XmlWriter();
@@ -68,6 +70,8 @@ namespace sharp {
     int write_string(const Glib::ustring & );
 
     int close();
+    // writes out pending output without ending the document
+    int flush();
     Glib::ustring to_string();
 
   private:
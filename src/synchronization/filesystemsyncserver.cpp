@@ -19,10 +19,14 @@
 
 
 #include <algorithm>
+#include <future>
 #include <stdexcept>
+#include <unordered_set>
 
+#include <glibmm/fileutils.h>
 #include <glibmm/i18n.h>
 #include <glibmm/miscutils.h>
+#include <glibmm/stringutils.h>
 
 #include "debug.hpp"
 #include "filesystemsyncserver.hpp"
@@ -73,6 +77,45 @@ void create_file(Gio::File &file, const Glib::ustring &content)
   stream->close();
 }
 
+void create_binary_file(Gio::File &file, const std::string &content)
+{
+  auto stream = file.create_file();
+  gsize written;
+  stream->write_all(content, written);
+  stream->close();
+}
+
+std::string read_binary_file(Gio::File &file)
+{
+  char *contents = nullptr;
+  gsize length = 0;
+  file.load_contents(contents, length);
+  std::string ret(contents, length);
+  g_free(contents);
+  return ret;
+}
+
+// revision directories and their parents are named by numbers
+std::optional<int> dir_number(const Glib::RefPtr<Gio::File> &dir)
+{
+  auto name = dir->get_basename();
+  if(name.empty() || name.size() > 9 || name.find_first_not_of("0123456789") != std::string::npos) {
+    return std::nullopt;
+  }
+  return std::stoi(name);
+}
+
+bool is_empty_dir(Gio::File &dir)
+{
+  return !dir.enumerate_children()->next_file();
+}
+
+bool is_revision_file(const std::string &name)
+{
+  return name == "manifest.xml" || name == "notebooks" || name == gnote::sync::RevisionPackWriter::FILE_NAME
+    || Glib::str_has_suffix(name, ".note");
+}
+
 struct NoteUpload
   : gnote::sync::FileTransfer
 {
@@ -87,12 +130,6 @@ struct NoteUpload
 struct NoteDownload
   : gnote::sync::FileTransfer
 {
-  explicit NoteDownload(const Glib::ustring &note_id)
-    : FileTransfer({}, {})
-    , revision(-1)
-    , note_id(note_id)
-  {}
-
   NoteDownload(const Glib::RefPtr<Gio::File> &src, const Glib::RefPtr<Gio::File> &dest, int revision, Glib::ustring &&note_id, Glib::ustring &&result_path)
     : FileTransfer(src, dest)
     , revision(revision)
@@ -105,27 +142,7 @@ struct NoteDownload
   const Glib::ustring result_path;
 };
 
-class NoteDownloadHash
-{
-public:
-  std::size_t operator()(const NoteDownload & d) const noexcept
-  {
-    return m_hash(d.note_id);
-  }
-private:
-  gnote::Hash<Glib::ustring> m_hash;
-};
-
-class NoteDownloadIdEqual
-{
-public:
-  bool operator()(const NoteDownload &x, const NoteDownload &y) const noexcept
-  {
-    return x.note_id == y.note_id;
-  }
-};
-
-typedef std::unordered_set<NoteDownload, NoteDownloadHash, NoteDownloadIdEqual> NoteDownloadSet;
+typedef std::vector<NoteDownload> NoteDownloadBatch;
 
 }
 
@@ -133,19 +150,31 @@ typedef std::unordered_set<NoteDownload, NoteDownloadHash, NoteDownloadIdEqual>
 namespace gnote {
 namespace sync {
 
+const char *const FileSystemSyncServer::REVISION_STAMP = "revision";
+
+
 std::unique_ptr<SyncServer> FileSystemSyncServer::create(Glib::RefPtr<Gio::File> && path, Preferences & prefs)
 {
-  return std::make_unique<FileSystemSyncServer>(std::move(path), prefs.sync_client_id());
+  auto server = std::make_unique<FileSystemSyncServer>(std::move(path), prefs.sync_client_id());
+  server->durability(durability_from_string(prefs.note_write_durability()));
+  server->pack_revisions(prefs.sync_pack_revisions());
+  return server;
 }
 
 
 FileSystemSyncServer::FileSystemSyncServer(Glib::RefPtr<Gio::File> && path, const Glib::ustring & client_id)
-  : m_server_path(std::move(path))
+  : m_notebooks_updated(false)
+  , m_manifest_load_usec(0)
+  , m_bytes_downloaded(0)
+  , m_bytes_uploaded(0)
+  , m_server_path(std::move(path))
   , m_cache_path(Glib::build_filename(Glib::get_tmp_dir(), Glib::get_user_name(), "gnote"))
   , m_lock_path(m_server_path->get_child("lock"))
   , m_manifest(m_server_path->get_child("manifest.xml"))
   , m_new_revision(-1)
   , m_sync_lock(client_id)
+  , m_durability(Durability::NONE)
+  , m_pack_revisions(false)
 {
   if(!sharp::directory_exists(m_server_path)) {
     throw std::invalid_argument(("Directory not found: " + m_server_path->get_uri()).c_str());
@@ -164,17 +193,25 @@ void FileSystemSyncServer::mkdir_p(const Glib::RefPtr<Gio::File> & path)
 }
 
 
-void FileSystemSyncServer::upload_notes(const std::vector<NoteBase::Ref> & notes)
+void FileSystemSyncServer::upload_notes(const std::vector<NoteBase::Ref> & notes, const std::vector<Glib::ustring> & content_hashes)
 {
   mkdir_p(m_new_revision_path);
   DBG_OUT_1("UploadNotes: notes.Count = %d", int(notes.size()));
   m_updated_notes.reserve(notes.size());
+  if(m_pack_revisions) {
+    upload_notes_packed(notes, content_hashes);
+    return;
+  }
+
   std::vector<NoteUpload> uploads;
-  for(NoteBase &iter : notes) {
-    auto file_path = iter.file_path();
+  guint64 upload_bytes = 0;
+  for(std::size_t i = 0; i < notes.size(); ++i) {
+    auto file_path = notes[i].get().file_path();
     auto local_note = Gio::File::create_for_path(file_path);
+    upload_bytes += local_note->query_info(G_FILE_ATTRIBUTE_STANDARD_SIZE)->get_size();
     auto server_note = m_new_revision_path->get_child(sharp::file_filename(file_path));
     uploads.emplace_back(local_note, server_note, sharp::file_basename(file_path));
+    m_note_hashes[uploads.back().result_path] = content_hashes[i];
   }
 
   const auto failures = transfer_files(uploads);
@@ -182,6 +219,7 @@ void FileSystemSyncServer::upload_notes(const std::vector<NoteBase::Ref> & notes
     throw GnoteSyncException(Glib::ustring::compose(ngettext("Failed to upload %1 note", "Failed to upload %1 notes", failures), failures));
   }
   else {
+    m_bytes_uploaded += upload_bytes;
     for(auto &upload : uploads) {
       m_updated_notes.emplace_back(std::move(upload.result_path));
     }
@@ -189,12 +227,45 @@ void FileSystemSyncServer::upload_notes(const std::vector<NoteBase::Ref> & notes
 }
 
 
+void FileSystemSyncServer::upload_notes_packed(const std::vector<NoteBase::Ref> & notes, const std::vector<Glib::ustring> & content_hashes)
+{
+  RevisionPackWriter pack;
+  std::vector<Glib::ustring> note_ids;
+  note_ids.reserve(notes.size());
+  for(std::size_t i = 0; i < notes.size(); ++i) {
+    const NoteBase &note = notes[i];
+    auto note_id = sharp::file_basename(note.file_path());
+    m_packed_notes[note_id] = pack.add(note_id, sharp::file_read_all_text(note.file_path()));
+    m_note_hashes[note_id] = content_hashes[i];
+    note_ids.emplace_back(std::move(note_id));
+  }
+
+  try {
+    auto pack_file = m_new_revision_path->get_child(RevisionPackWriter::FILE_NAME);
+    auto pack_data = pack.finish();
+    create_binary_file(*pack_file, pack_data);
+    m_bytes_uploaded += pack_data.size();
+  }
+  catch(std::exception & e) {
+    ERR_OUT(_("Failed to upload revision pack: %s"), e.what());
+    m_packed_notes.clear();
+    m_note_hashes.clear();
+    throw GnoteSyncException(Glib::ustring::compose(ngettext("Failed to upload %1 note", "Failed to upload %1 notes", notes.size()), notes.size()));
+  }
+
+  for(auto & note_id : note_ids) {
+    m_updated_notes.emplace_back(std::move(note_id));
+  }
+}
+
+
 void FileSystemSyncServer::upload_notebooks(const std::vector<notebooks::NotebookData> &notebooks)
 {
   mkdir_p(m_new_revision_path);
   auto serialized = notebooks::NotebookSerializer::serialize(notebooks);
   auto file = m_new_revision_path->get_child("notebooks");
   create_file(*file, serialized);
+  m_bytes_uploaded += serialized.bytes();
   m_notebooks_updated = true;
 }
 
@@ -210,11 +281,11 @@ std::vector<Glib::ustring> FileSystemSyncServer::get_all_note_uuids()
   std::vector<Glib::ustring> noteUUIDs;
 
   if(m_manifest.is_loaded()) {
-    xmlNodePtr root_node = xmlDocGetRootElement(&m_manifest.xml_doc());
-    sharp::XmlNodeSet noteIds = sharp::xml_node_xpath_find(root_node, "//note/@id");
-    DBG_OUT_1("get_all_note_uuids has %d notes", int(noteIds.size()));
-    for(sharp::XmlNodeSet::iterator iter = noteIds.begin(); iter != noteIds.end(); ++iter) {
-      noteUUIDs.push_back(sharp::xml_node_content(*iter));
+    auto & notes = m_manifest.notes();
+    DBG_OUT_1("get_all_note_uuids has %d notes", int(notes.size()));
+    noteUUIDs.reserve(notes.size());
+    for(const auto & note : notes) {
+      noteUUIDs.push_back(note.first);
     }
   }
 
@@ -222,16 +293,34 @@ std::vector<Glib::ustring> FileSystemSyncServer::get_all_note_uuids()
 }
 
 
+void FileSystemSyncServer::collect_stats(SyncStats & stats)
+{
+  // manifest is loaded while acquiring the lock
+  stats.move_phase_time(SyncStats::LOCK_WAIT, SyncStats::MANIFEST_LOAD, m_manifest_load_usec);
+  stats.bytes_downloaded += m_bytes_downloaded;
+  stats.bytes_uploaded += m_bytes_uploaded;
+}
+
+
 bool FileSystemSyncServer::updates_available_since(int revision)
 {
+  if(!m_manifest.is_loaded()) {
+    if(auto stamp = read_revision_stamp()) {
+      return stamp.value() > revision;
+    }
+    // server written by a client, that doesn't maintain the stamp
+    if(!m_manifest.load()) {
+      return false;
+    }
+  }
+
   return latest_revision() > revision;
 }
 
 
-SyncServer::NoteUpdatesMap FileSystemSyncServer::get_note_updates_since(int revision)
+void FileSystemSyncServer::get_note_updates_since(int revision, std::size_t batch_size, const NoteUpdatesSlot & consumer)
 {
-  SyncServer::NoteUpdatesMap noteUpdates;
-
+  batch_size = std::max<std::size_t>(batch_size, 1);
   Glib::ustring temp_path = Glib::build_filename(m_cache_path, "sync_temp");
   if(!sharp::directory_exists(temp_path)) {
     sharp::directory_create(temp_path);
@@ -247,43 +336,125 @@ SyncServer::NoteUpdatesMap FileSystemSyncServer::get_note_updates_since(int revi
     catch(...) {}
   }
 
-  NoteDownloadSet downloads;
+  std::vector<NoteDownloadBatch> downloads;
+  PackedNotes packed;
   if(m_manifest.is_loaded()) {
-    xmlNodePtr root_node = xmlDocGetRootElement(&m_manifest.xml_doc());
-
-    Glib::ustring xpath = Glib::ustring::compose("//note[@rev > %1]", revision);
-    sharp::XmlNodeSet noteNodes = sharp::xml_node_xpath_find(root_node, xpath.c_str());
-    DBG_OUT_2("get_note_updates_since xpath returned %d nodes", int(noteNodes.size()));
-    if(noteNodes.size() > 0) {
-      for(auto & node : noteNodes) {
-        Glib::ustring note_id = sharp::xml_node_content(sharp::xml_node_xpath_find_single_node(node, "@id"));
-        int rev = str_to_int(sharp::xml_node_content(sharp::xml_node_xpath_find_single_node(node, "@rev")));
-        if(downloads.find(NoteDownload(note_id)) == downloads.end()) {
-          auto rev_dir = get_revision_dir_path(rev);
-          auto server_note = rev_dir->get_child(note_id + ".note");
-          // Copy the file from the server to the temp directory
-          Glib::ustring note_temp_path = Glib::build_filename(temp_path, note_id + ".note");
-          auto dest = Gio::File::create_for_path(note_temp_path);
-          downloads.emplace(server_note, dest, rev, std::move(note_id), std::move(note_temp_path));
+    // manifest has every note once, no need to check for duplicates
+    auto notes = m_manifest.notes_since(revision);
+    DBG_OUT_2("get_note_updates_since found %d notes", int(notes.size()));
+    for(const ManifestNote *note : notes) {
+      if(note->pack) {
+        packed[note->rev].emplace_back(note->id, *note->pack);
+      }
+      else {
+        auto rev_dir = get_revision_dir_path(note->rev);
+        auto server_note = rev_dir->get_child(note->id + ".note");
+        // Copy the file from the server to the temp directory
+        Glib::ustring note_temp_path = Glib::build_filename(temp_path, note->id + ".note");
+        auto dest = Gio::File::create_for_path(note_temp_path);
+        if(downloads.empty() || downloads.back().size() >= batch_size) {
+          downloads.emplace_back();
+          downloads.back().reserve(batch_size);
         }
+        downloads.back().emplace_back(server_note, dest, note->rev, Glib::ustring(note->id), std::move(note_temp_path));
       }
     }
   }
 
-  const auto failures = transfer_files(downloads);
+  // next batch is downloaded, while consumer handles the current one
+  std::future<unsigned> next_download;
+  auto start_download = [this, &downloads, &next_download](std::size_t batch) {
+    if(batch < downloads.size()) {
+      next_download = std::async(std::launch::async, [this, &downloads, batch]() { return transfer_files(downloads[batch]); });
+    }
+  };
+
+  start_download(0);
+  for(std::size_t batch = 0; batch < downloads.size(); ++batch) {
+    const auto failures = next_download.get();
+    if(failures > 0) {
+      throw GnoteSyncException(Glib::ustring::compose(ngettext("Failed to download %1 note update", "Failed to download %1 note updates", failures), failures));
+    }
+    start_download(batch + 1);
+
+    NoteUpdatesMap updates;
+    for(const auto &downloaded : downloads[batch]) {
+      Glib::ustring note_xml = sharp::file_read_all_text(downloaded.result_path);
+      m_bytes_downloaded += note_xml.bytes();
+      NoteUpdate update(note_xml, Glib::ustring(), downloaded.note_id, downloaded.revision);
+      set_content_hash(update);
+      updates.insert(std::make_pair(downloaded.note_id, std::move(update)));
+      sharp::file_delete(downloaded.result_path);
+    }
+    consumer(std::move(updates));
+  }
+
+  download_packed_notes(packed, temp_path, batch_size, consumer);
+}
+
+
+void FileSystemSyncServer::set_content_hash(NoteUpdate & update)
+{
+  if(auto note = m_manifest.find_note(update.m_uuid)) {
+    update.m_content_hash = note->content_hash;
+  }
+}
+
 
+void FileSystemSyncServer::download_packed_notes(const PackedNotes & packed, const Glib::ustring & temp_path, std::size_t batch_size, const NoteUpdatesSlot & consumer)
+{
+  if(packed.empty()) {
+    return;
+  }
+
+  // one download per revision, no matter how many notes it has
+  std::vector<FileTransfer> downloads;
+  std::vector<Glib::ustring> pack_paths;
+  for(const auto & rev : packed) {
+    auto server_pack = get_revision_dir_path(rev.first)->get_child(RevisionPackWriter::FILE_NAME);
+    pack_paths.push_back(Glib::build_filename(temp_path, Glib::ustring::compose("%1.pack", rev.first)));
+    downloads.emplace_back(server_pack, Gio::File::create_for_path(pack_paths.back()));
+  }
+
+  const auto failures = transfer_files(downloads);
   if(failures > 0) {
     throw GnoteSyncException(Glib::ustring::compose(ngettext("Failed to download %1 note update", "Failed to download %1 note updates", failures), failures));
   }
 
-  for(const auto &downloaded : downloads) {
-    Glib::ustring note_xml = sharp::file_read_all_text(downloaded.result_path);
-    NoteUpdate update(note_xml, Glib::ustring(), downloaded.note_id, downloaded.revision);
-    noteUpdates.insert(std::make_pair(downloaded.note_id, update));
-  }
+  auto pack_path = pack_paths.begin();
+  for(const auto & rev : packed) {
+    auto read_failed = [&rev](const std::exception & e) {
+      ERR_OUT(_("Failed to read revision pack %d: %s"), rev.first, e.what());
+      return GnoteSyncException(Glib::ustring::compose(ngettext("Failed to download %1 note update", "Failed to download %1 note updates", rev.second.size()), rev.second.size()));
+    };
+
+    // notes are inflated one batch at a time
+    std::unique_ptr<RevisionPackReader> pack;
+    try {
+      auto pack_data = Glib::file_get_contents(*pack_path);
+      m_bytes_downloaded += pack_data.size();
+      pack = std::make_unique<RevisionPackReader>(std::move(pack_data));
+      sharp::file_delete(*pack_path++);
+    }
+    catch(std::exception & e) {
+      throw read_failed(e);
+    }
 
-  DBG_OUT_2("get_note_updates_since (%d) returning: %d", revision, int(noteUpdates.size()));
-  return noteUpdates;
+    for(auto note = rev.second.begin(); note != rev.second.end();) {
+      NoteUpdatesMap updates;
+      try {
+        for(; note != rev.second.end() && updates.size() < batch_size; ++note) {
+          NoteUpdate update(pack->read(note->second), Glib::ustring(), note->first, rev.first);
+          set_content_hash(update);
+          updates.insert(std::make_pair(note->first, std::move(update)));
+        }
+      }
+      catch(std::exception & e) {
+        throw read_failed(e);
+      }
+      consumer(std::move(updates));
+    }
+  }
 }
 
 
@@ -296,6 +467,7 @@ notebooks::NotebookSerializer::Notebooks FileSystemSyncServer::get_notebooks()
     auto serialized_file = path->get_child("notebooks");
     if(serialized_file->query_exists()) {
       auto content = sharp::file_read_all_text(*serialized_file);
+      m_bytes_downloaded += content.bytes();
       notebooks = notebooks::NotebookSerializer::deserialize(content);
     }
   }
@@ -332,12 +504,18 @@ bool FileSystemSyncServer::begin_sync_transaction()
 
   m_updated_notes.clear();
   m_deleted_notes.clear();
+  m_packed_notes.clear();
+  m_note_hashes.clear();
+  m_bytes_downloaded = 0;
+  m_bytes_uploaded = 0;
+  const auto manifest_load_start = g_get_monotonic_time();
   if(m_manifest.load()) {
     m_new_revision = latest_revision() + 1;
   }
   else {
     m_new_revision = 0;
   }
+  m_manifest_load_usec = g_get_monotonic_time() - manifest_load_start;
   m_new_revision_path = get_revision_dir_path(m_new_revision);
   m_notebooks_updated = false;
 
@@ -354,64 +532,53 @@ bool FileSystemSyncServer::commit_sync_transaction()
     auto manifest_file = m_new_revision_path->get_child("manifest.xml");
     mkdir_p(m_new_revision_path);
 
-    std::map<Glib::ustring, Glib::ustring> notes;
-    if(m_manifest.is_loaded()) {
-      xmlNodePtr root_node = xmlDocGetRootElement(&m_manifest.xml_doc());
-      sharp::XmlNodeSet noteNodes = sharp::xml_node_xpath_find(root_node, "//note");
-      for(sharp::XmlNodeSet::iterator iter = noteNodes.begin(); iter != noteNodes.end(); ++iter) {
-        Glib::ustring note_id = sharp::xml_node_get_attribute(*iter, "id");
-        Glib::ustring rev = sharp::xml_node_get_attribute(*iter, "rev");
-        notes[note_id] = rev;
-      }
-    }
+    // notes, that don't keep their current manifest entry
+    std::unordered_set<Glib::ustring, Hash<Glib::ustring>> changed_notes(m_deleted_notes.begin(), m_deleted_notes.end());
+    changed_notes.insert(m_updated_notes.begin(), m_updated_notes.end());
 
     // Write out the new manifest file
     Glib::ustring manifest_content;
     {
-      sharp::XmlWriter xml;
-      xml.write_start_document();
-      xml.write_start_element("", "sync", "");
-      xml.write_attribute_string("", "revision", "", TO_STRING(m_new_revision));
-      xml.write_attribute_string("", "server-id", "", m_server_id);
-
-      for(std::map<Glib::ustring, Glib::ustring>::iterator iter = notes.begin(); iter != notes.end(); ++iter) {
-        // Don't write out deleted notes
-        if(std::find(m_deleted_notes.begin(), m_deleted_notes.end(), iter->first) != m_deleted_notes.end()) {
-          continue;
-        }
-
-        // Skip updated notes, we'll update them in a sec
-        if(std::find(m_updated_notes.begin(), m_updated_notes.end(), iter->first) != m_updated_notes.end()) {
-          continue;
+      ManifestWriter xml(m_new_revision, m_server_id);
+      if(m_manifest.is_loaded()) {
+        for(const ManifestNote *note : m_manifest.notes_since(-1)) {
+          // Don't write out deleted notes, updated ones are written below
+          if(changed_notes.find(note->id) == changed_notes.end()) {
+            xml.write_note(*note);
+          }
         }
-
-        xml.write_start_element("", "note", "");
-        xml.write_attribute_string("", "id", "", iter->first);
-        xml.write_attribute_string("", "rev", "", iter->second);
-        xml.write_end_element();
       }
 
       // Write out all the updated notes
       for(auto & note : m_updated_notes) {
-        xml.write_start_element("", "note", "");
-        xml.write_attribute_string("", "id", "", note);
-        xml.write_attribute_string("", "rev", "", TO_STRING(m_new_revision));
-        xml.write_end_element();
+        std::optional<RevisionPackEntry> pack;
+        auto packed = m_packed_notes.find(note);
+        if(packed != m_packed_notes.end()) {
+          pack = packed->second;
+        }
+        Glib::ustring content_hash;
+        auto hash = m_note_hashes.find(note);
+        if(hash != m_note_hashes.end()) {
+          content_hash = hash->second;
+        }
+        xml.write_note(note, m_new_revision, pack, content_hash);
       }
 
-      xml.write_end_element();
-      xml.write_end_document();
-      xml.close();
-      Glib::ustring xml_content = xml.to_string();
+      Glib::ustring xml_content = xml.finish();
 
       if(manifest_file->query_exists()) {
         manifest_file->remove();
       }
       create_file(*manifest_file, xml_content);
+      m_bytes_uploaded += xml_content.bytes();
       manifest_content = std::move(xml_content);
     }
 
+    // new revision has to be on disk, before manifest refers to it
+    sync_new_revision();
     m_manifest.write_new(manifest_content);
+    sync_manifest();
+    write_revision_stamp();
 
     try {
       auto old_manifest_file = get_revision_dir_path(m_new_revision - 1)->get_child("manifest.xml");
@@ -421,8 +588,7 @@ bool FileSystemSyncServer::commit_sync_transaction()
         std::vector<Glib::RefPtr<Gio::File>> files = sharp::directory_get_files(old_manifest_file->get_parent());
         for(auto file : files) {
           Glib::ustring fileGuid = file->get_basename();
-          if(std::find(m_deleted_notes.begin(), m_deleted_notes.end(), fileGuid) != m_deleted_notes.end()
-             || std::find(m_updated_notes.begin(), m_updated_notes.end(), fileGuid) != m_updated_notes.end()) {
+          if(changed_notes.find(fileGuid) != changed_notes.end()) {
             file->remove();
           }
           // TODO: Need to check *all* revision dirs, not just previous (duh)
@@ -455,6 +621,141 @@ bool FileSystemSyncServer::cancel_sync_transaction()
 }
 
 
+std::optional<FileSystemSyncServer::CompactionReport> FileSystemSyncServer::compact(bool fold_history)
+{
+  if(!begin_sync_transaction()) {
+    return std::nullopt;
+  }
+
+  CompactionReport report;
+  try {
+    if(m_manifest.is_loaded()) {
+      if(fold_history) {
+        fold_into_baseline();
+        report.baseline_revision = latest_revision();
+      }
+      collect_garbage(report);
+    }
+  }
+  catch(...) {
+    cancel_sync_transaction();
+    throw;
+  }
+
+  cancel_sync_transaction();
+  DBG_OUT_1("Compaction removed %u files and %u directories, reclaimed %" G_GUINT64_FORMAT " bytes",
+            report.removed_files, report.removed_dirs, report.reclaimed_bytes);
+  return report;
+}
+
+
+void FileSystemSyncServer::fold_into_baseline()
+{
+  mkdir_p(m_new_revision_path);
+  auto notes = m_manifest.notes_since(-1);
+
+  std::vector<FileTransfer> copies;
+  std::map<int, std::vector<const ManifestNote*>> packed;
+  for(const ManifestNote *note : notes) {
+    if(note->pack) {
+      packed[note->rev].push_back(note);
+    }
+    else {
+      auto file_name = note->id + ".note";
+      copies.emplace_back(get_revision_dir_path(note->rev)->get_child(file_name), m_new_revision_path->get_child(file_name));
+    }
+  }
+  const auto failures = transfer_files(copies);
+  if(failures > 0) {
+    throw GnoteSyncException(Glib::ustring::compose(ngettext("Failed to copy %1 note", "Failed to copy %1 notes", failures), failures));
+  }
+
+  // notes keep their format, packed ones go to a single new pack
+  std::unordered_map<Glib::ustring, RevisionPackEntry, Hash<Glib::ustring>> pack_entries;
+  if(!packed.empty()) {
+    RevisionPackWriter pack;
+    for(const auto & rev : packed) {
+      RevisionPackReader reader(read_binary_file(*get_revision_dir_path(rev.first)->get_child(RevisionPackWriter::FILE_NAME)));
+      for(const ManifestNote *note : rev.second) {
+        pack_entries[note->id] = pack.add(note->id, reader.read(*note->pack));
+      }
+    }
+    create_binary_file(*m_new_revision_path->get_child(RevisionPackWriter::FILE_NAME), pack.finish());
+  }
+
+  // notebooks are only read from the latest revision
+  auto notebooks = get_revision_dir_path(latest_revision())->get_child("notebooks");
+  if(notebooks->query_exists()) {
+    notebooks->copy(m_new_revision_path->get_child("notebooks"));
+  }
+
+  ManifestWriter xml(m_new_revision, m_manifest.server_id());
+  for(const ManifestNote *note : notes) {
+    std::optional<RevisionPackEntry> pack;
+    auto entry = pack_entries.find(note->id);
+    if(entry != pack_entries.end()) {
+      pack = entry->second;
+    }
+    xml.write_note(note->id, m_new_revision, pack, note->content_hash);
+  }
+  Glib::ustring manifest_content = xml.finish();
+  create_file(*m_new_revision_path->get_child("manifest.xml"), manifest_content);
+
+  sync_new_revision();
+  m_manifest.write_new(manifest_content);
+  sync_manifest();
+  write_revision_stamp();
+}
+
+
+void FileSystemSyncServer::collect_garbage(CompactionReport & report)
+{
+  const int latest = latest_revision();
+  // files referenced by manifest in every revision
+  std::unordered_map<int, std::unordered_set<Glib::ustring, Hash<Glib::ustring>>> live_files;
+  for(const auto & note : m_manifest.notes()) {
+    live_files[note.second.rev].insert(note.second.pack ? Glib::ustring(RevisionPackWriter::FILE_NAME) : note.first + ".note");
+  }
+
+  for(const auto & group_dir : sharp::directory_get_directories(m_server_path)) {
+    if(!dir_number(group_dir)) {
+      continue;
+    }
+
+    for(const auto & rev_dir : sharp::directory_get_directories(group_dir)) {
+      auto rev = dir_number(rev_dir);
+      // latest revision is kept whole, newer ones are leftovers of failed syncs
+      if(!rev || rev.value() == latest) {
+        continue;
+      }
+
+      auto live = live_files.find(rev.value());
+      for(const auto & file : sharp::directory_get_files(rev_dir)) {
+        auto name = file->get_basename();
+        if(!is_revision_file(name) || (live != live_files.end() && live->second.count(name) > 0)) {
+          continue;
+        }
+
+        auto size = file->query_info(G_FILE_ATTRIBUTE_STANDARD_SIZE)->get_size();
+        file->remove();
+        ++report.removed_files;
+        report.reclaimed_bytes += size;
+      }
+
+      if(is_empty_dir(*rev_dir)) {
+        rev_dir->remove();
+        ++report.removed_dirs;
+      }
+    }
+
+    if(is_empty_dir(*group_dir)) {
+      group_dir->remove();
+      ++report.removed_dirs;
+    }
+  }
+}
+
+
 int FileSystemSyncServer::latest_revision()
 {
   int latest_rev = -1;
@@ -610,12 +911,83 @@ void FileSystemSyncServer::lock_timeout()
 }
 
 
+void FileSystemSyncServer::sync_new_revision()
+{
+  if(m_durability == Durability::NONE || !m_new_revision_path->is_native()) {
+    return;
+  }
+
+  // only files written to new revision, both for FILE and BATCH
+  auto revision_dir = m_new_revision_path->get_path();
+  for(const auto & file : sharp::directory_get_files(revision_dir)) {
+    fsync_path(file);
+  }
+  fsync_path(revision_dir);
+  // revision directory might be new too
+  fsync_path(Glib::path_get_dirname(revision_dir));
+}
+
+
+void FileSystemSyncServer::sync_manifest()
+{
+  auto manifest = m_server_path->get_child("manifest.xml");
+  if(m_durability == Durability::NONE || !manifest->is_native()) {
+    return;
+  }
+
+  fsync_path(manifest->get_path());
+  fsync_path(m_server_path->get_path());
+}
+
+
+void FileSystemSyncServer::write_revision_stamp()
+{
+  // stamp is only a hint, sync has already succeeded
+  try {
+    auto stream = m_server_path->get_child(REVISION_STAMP)->replace();
+    gsize written;
+    stream->write_all(TO_STRING(m_manifest.revision()) + "\n", written);
+    stream->close();
+  }
+  catch(std::exception & e) {
+    ERR_OUT("Failed to write revision stamp: %s", e.what());
+  }
+}
+
+
+std::optional<int> FileSystemSyncServer::read_revision_stamp()
+{
+  try {
+    auto stamp = m_server_path->get_child(REVISION_STAMP);
+    // with microseconds, a manifest written in the same second as the stamp is detected too
+    const char *attributes = G_FILE_ATTRIBUTE_TIME_MODIFIED "," G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC;
+    auto stamp_info = stamp->query_info(attributes);
+    auto manifest_info = m_manifest.file().query_info(attributes);
+    // manifest was written after the stamp, by a client that doesn't update it
+    if(stamp_info->get_modification_date_time() < manifest_info->get_modification_date_time()) {
+      return std::nullopt;
+    }
+
+    auto content = read_binary_file(*stamp);
+    auto end = content.find_first_not_of("0123456789");
+    if(end == 0 || (end != std::string::npos && content.find_first_not_of("\n", end) != std::string::npos)) {
+      return std::nullopt;
+    }
+    return std::stoi(content.substr(0, end));
+  }
+  catch(std::exception & e) {
+    DBG_OUT_1("Revision stamp not available: %s", e.what());
+    return std::nullopt;
+  }
+}
+
+
 template <typename ContainerT>
 unsigned FileSystemSyncServer::transfer_files(const ContainerT &transfers) const
 {
   const auto max = max_concurrent_transfers();
   if(max) {
-    return transfer_files<ContainerT, TransferLimiterFixed>(transfers, max.value());
+    return transfer_files<ContainerT, TransferLimiterAdaptive>(transfers, max.value());
   }
   else {
     return transfer_files<ContainerT, TransferLimiterNoLimit>(transfers);
@@ -21,10 +21,14 @@
 #ifndef _SYNCHRONIZATION_FILESYSTEMSYNCSERVER_HPP_
 #define _SYNCHRONIZATION_FILESYSTEMSYNCSERVER_HPP_
 
+#include <map>
 #include <memory>
+#include <optional>
 
+#include "durability.hpp"
 #include "isyncmanager.hpp"
 #include "manifestfile.hpp"
+#include "revisionpack.hpp"
 #include "utils.hpp"
 #include "sharp/datetime.hpp"
 
@@ -37,32 +41,72 @@ class FileSystemSyncServer
   : public SyncServer
 {
 public:
+  struct CompactionReport
+  {
+    unsigned removed_files = 0;
+    unsigned removed_dirs = 0;
+    guint64 reclaimed_bytes = 0;
+    // revision, that all notes were folded into, -1 if history was kept
+    int baseline_revision = -1;
+  };
+
+  // file in server root with the latest revision, so it can be checked without loading the manifest
+  static const char *const REVISION_STAMP;
+
   static std::unique_ptr<SyncServer> create(Glib::RefPtr<Gio::File> && path, Preferences & prefs);
   FileSystemSyncServer(Glib::RefPtr<Gio::File> && path, const Glib::ustring & client_id);
   virtual bool begin_sync_transaction() override;
   virtual bool commit_sync_transaction() override;
   virtual bool cancel_sync_transaction() override;
   virtual std::vector<Glib::ustring> get_all_note_uuids() override;
-  NoteUpdatesMap get_note_updates_since(int revision) override;
+  void get_note_updates_since(int revision, std::size_t batch_size, const NoteUpdatesSlot & consumer) override;
   notebooks::NotebookSerializer::Notebooks get_notebooks() override;
   virtual void delete_notes(const std::vector<Glib::ustring> & deletedNoteUUIDs) override;
-  void upload_notes(const std::vector<NoteBase::Ref> & notes) override;
+  void upload_notes(const std::vector<NoteBase::Ref> & notes, const std::vector<Glib::ustring> & content_hashes) override;
   void upload_notebooks(const std::vector<notebooks::NotebookData> &notebooks) override;
   virtual int latest_revision() override; // NOTE: Only reliable during a transaction
   virtual SyncLockInfo current_sync_lock() override;
   virtual Glib::ustring id() override;
   virtual bool updates_available_since(int revision) override;
+  void collect_stats(SyncStats & stats) override;
+  // applies to files written on local file systems
+  void durability(Durability durability)
+    {
+      m_durability = durability;
+    }
+  // upload notes of a revision as single pack file, see RevisionPackWriter
+  void pack_revisions(bool pack)
+    {
+      m_pack_revisions = pack;
+    }
+  // Removes revision files, that are no longer referenced by the manifest, and empty revision directories.
+  // With fold_history all notes are first copied to a new revision, so that older ones can be removed entirely.
+  // Takes the sync lock, returns nothing if it is held by another client. Must not be called during sync.
+  std::optional<CompactionReport> compact(bool fold_history);
 protected:
   virtual void mkdir_p(const Glib::RefPtr<Gio::File> & path);
+  // when set, concurrency adapts to server response up to this value
   virtual std::optional<unsigned> max_concurrent_transfers() const
     {
       return {};
     }
 private:
+  // revision to notes in its pack
+  typedef std::map<int, std::vector<std::pair<Glib::ustring, RevisionPackEntry>>> PackedNotes;
+
   Glib::RefPtr<Gio::File> get_revision_dir_path(int rev);
   void update_lock_file(const SyncLockInfo & syncLockInfo);
   bool is_valid_xml_file(Gio::File &xml_file, xmlDocPtr *xml_doc);
   void lock_timeout();
+  void sync_new_revision();
+  void upload_notes_packed(const std::vector<NoteBase::Ref> & notes, const std::vector<Glib::ustring> & content_hashes);
+  void download_packed_notes(const PackedNotes & packed, const Glib::ustring & temp_path, std::size_t batch_size, const NoteUpdatesSlot & consumer);
+  void sync_manifest();
+  void write_revision_stamp();
+  std::optional<int> read_revision_stamp();
+  void set_content_hash(NoteUpdate & update);
+  void fold_into_baseline();
+  void collect_garbage(CompactionReport & report);
 
   template <typename ContainerT>
   [[nodiscard]]
@@ -73,7 +117,15 @@ private:
 
   std::vector<Glib::ustring> m_updated_notes;
   std::vector<Glib::ustring> m_deleted_notes;
+  // locations of notes in the pack of new revision
+  std::unordered_map<Glib::ustring, RevisionPackEntry, Hash<Glib::ustring>> m_packed_notes;
+  // content hashes of notes uploaded in new revision
+  std::unordered_map<Glib::ustring, Glib::ustring, Hash<Glib::ustring>> m_note_hashes;
   bool m_notebooks_updated;
+  // stats of current transaction
+  gint64 m_manifest_load_usec;
+  guint64 m_bytes_downloaded;
+  guint64 m_bytes_uploaded;
 
   Glib::ustring m_server_id;
 
@@ -87,6 +139,8 @@ private:
 
   utils::InterruptableTimeout m_lock_timeout;
   SyncLockInfo m_sync_lock;
+  Durability m_durability;
+  bool m_pack_revisions;
 };
 
 }
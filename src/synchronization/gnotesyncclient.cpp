@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2012-2014,2017,2019-2020,2023,2025 Aurimas Cernius
+ * Copyright (C) 2012-2014,2017,2019-2020,2023,2025-2026 Aurimas Cernius
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -70,6 +70,7 @@ namespace sync {
     }
     m_deleted_notes[deleted_note.id()] = deleted_note.get_title();
     m_file_revisions.erase(deleted_note.id());
+    m_content_hashes.erase(deleted_note.id());
 
     write(m_local_manifest_file_path);
   }
@@ -77,7 +78,7 @@ namespace sync {
 
   void GnoteSyncClient::read_updated_note_atts(sharp::XmlReader & reader)
   {
-    Glib::ustring guid, rev;
+    Glib::ustring guid, rev, hash;
     while(reader.move_to_next_attribute()) {
       if(reader.get_name() == "guid") {
 	guid = reader.get_value();
@@ -85,6 +86,9 @@ namespace sync {
       else if(reader.get_name() == "latest-revision") {
 	rev = reader.get_value();
       }
+      else if(reader.get_name() == "content-hash") {
+	hash = reader.get_value();
+      }
     }
     int revision = -1;
     try {
@@ -93,6 +97,9 @@ namespace sync {
     catch(...) {}
     if(guid != "") {
       m_file_revisions[guid] = revision;
+      if(hash != "") {
+        m_content_hashes[guid] = hash;
+      }
     }
   }
 
@@ -135,6 +142,7 @@ namespace sync {
     m_last_sync_date = Glib::DateTime::create_now_local().add_days(-1);
     m_last_sync_rev = -1;
     m_file_revisions.clear();
+    m_content_hashes.clear();
     m_deleted_notes.clear();
     m_server_id = "";
 
@@ -211,6 +219,10 @@ namespace sync {
 	xml.write_start_element("", "note", "");
 	xml.write_attribute_string("", "guid", "", noteGuid.first);
 	xml.write_attribute_string("", "latest-revision", "", TO_STRING(noteGuid.second));
+	auto hash = m_content_hashes.find(noteGuid.first);
+	if(hash != m_content_hashes.end()) {
+	  xml.write_attribute_string("", "content-hash", "", hash->second);
+	}
 	xml.write_end_element();
       }
 
@@ -268,6 +280,23 @@ namespace sync {
   }
 
 
+  Glib::ustring GnoteSyncClient::get_content_hash(const NoteBase &note) const
+  {
+    auto iter = m_content_hashes.find(note.id());
+    if(iter != m_content_hashes.end()) {
+      return iter->second;
+    }
+
+    return Glib::ustring();
+  }
+
+
+  void GnoteSyncClient::set_content_hash(const NoteBase &note, const Glib::ustring &hash)
+  {
+    m_content_hashes[note.id()] = hash;
+  }
+
+
   void GnoteSyncClient::reset()
   {
     if(sharp::file_exists(m_local_manifest_file_path)) {
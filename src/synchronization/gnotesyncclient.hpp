@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2012-2014,2017,2019-2020,2023,2025 Aurimas Cernius
+ * Copyright (C) 2012-2014,2017,2019-2020,2023,2025-2026 Aurimas Cernius
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -46,6 +46,8 @@ namespace sync {
     void last_synchronized_revision(int) override;
     int get_revision(const NoteBase &note) const override;
     void set_revision(const NoteBase &note, int revision) override;
+    Glib::ustring get_content_hash(const NoteBase &note) const override;
+    void set_content_hash(const NoteBase &note, const Glib::ustring &hash) override;
     const DeletedTitlesMap &deleted_note_titles() const override
       {
         return m_deleted_notes;
@@ -77,6 +79,7 @@ namespace sync {
     int m_last_sync_rev;
     Glib::ustring m_server_id;
     std::map<Glib::ustring, int> m_file_revisions;
+    std::map<Glib::ustring, Glib::ustring> m_content_hashes;
     DeletedTitlesMap  m_deleted_notes;
     bool m_synchronizing;
   };
@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2025 Aurimas Cernius
+ * Copyright (C) 2025-2026 Aurimas Cernius
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -17,6 +17,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+
 #include <glibmm/i18n.h>
 
 #include "debug.hpp"
@@ -26,6 +28,16 @@
 namespace gnote {
 namespace sync {
 
+namespace {
+
+const std::chrono::milliseconds MAX_RETRY_BACKOFF(8000);
+// latency, that is considered a sign of congestion
+const unsigned CONGESTION_LATENCY_FACTOR = 4;
+const std::chrono::microseconds CONGESTION_LATENCY_MIN(100000);
+
+}
+
+
 void GioFileWrapper::copy_to_async(const GioFileWrapper &dest, const std::function<void(TransferResult)> &completion, const Glib::RefPtr<Gio::Cancellable> &cancel_op) const
 {
   m_file->copy_async(dest.m_file, [this, completion](Glib::RefPtr<Gio::AsyncResult> &result) {
@@ -65,6 +77,16 @@ unsigned GvfsTransferBase::calculate_failure_margin(std::size_t transfers)
   return failure_margin;
 }
 
+std::chrono::milliseconds GvfsTransferBase::backoff_for_attempt(unsigned attempt) const
+{
+  auto backoff = m_retry_backoff;
+  for(unsigned i = 1; i < attempt && backoff < MAX_RETRY_BACKOFF; ++i) {
+    backoff *= 2;
+  }
+
+  return std::min(backoff, MAX_RETRY_BACKOFF);
+}
+
 
 TransferLimiterFixed::TransferLimiterFixed(unsigned max)
 {
@@ -87,6 +109,66 @@ void TransferLimiterFixed::release()
 }
 
 
+TransferLimiterAdaptive::TransferLimiterAdaptive(unsigned max, unsigned initial)
+  : m_max(std::max(max, 1u))
+  , m_limit(std::clamp(initial, 1u, m_max))
+  , m_in_flight(0)
+  , m_successes(0)
+  , m_since_decrease(m_limit)
+{
+}
+
+void TransferLimiterAdaptive::claim()
+{
+  std::unique_lock<std::mutex> lock(m_lock);
+  m_slot_free.wait(lock, [this] { return m_in_flight < m_limit; });
+  ++m_in_flight;
+}
+
+void TransferLimiterAdaptive::release()
+{
+  {
+    std::unique_lock<std::mutex> lock(m_lock);
+    --m_in_flight;
+  }
+  m_slot_free.notify_one();
+}
+
+void TransferLimiterAdaptive::completed(TransferResult result, std::chrono::microseconds latency)
+{
+  std::unique_lock<std::mutex> lock(m_lock);
+  ++m_since_decrease;
+  bool congested = result == TransferResult::FAILURE;
+  if(!congested) {
+    if(!m_min_latency || latency < m_min_latency.value()) {
+      m_min_latency = latency;
+    }
+    congested = latency > CONGESTION_LATENCY_MIN && latency > m_min_latency.value() * CONGESTION_LATENCY_FACTOR;
+  }
+
+  if(congested) {
+    m_successes = 0;
+    if(m_since_decrease >= m_limit) {
+      m_limit = std::max(m_limit / 2, 1u);
+      m_since_decrease = 0;
+      DBG_OUT_1("Transfer limit decreased to %u", m_limit);
+    }
+    return;
+  }
+
+  if(++m_successes >= m_limit && m_limit < m_max) {
+    ++m_limit;
+    m_successes = 0;
+    m_slot_free.notify_one();
+  }
 }
+
+unsigned TransferLimiterAdaptive::limit() const
+{
+  std::unique_lock<std::mutex> lock(m_lock);
+  return m_limit;
 }
 
+
+}
+}
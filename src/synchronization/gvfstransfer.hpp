@@ -20,7 +20,11 @@
 #ifndef _SYNCHRONIZATION_GVFSTRANSFER_HPP_
 #define _SYNCHRONIZATION_GVFSTRANSFER_HPP_
 
-#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <vector>
 
 #include <semaphore.h>
 #include <giomm/file.h>
@@ -102,10 +106,65 @@ private:
 };
 
 
+/**
+ * Limits concurrency using additive increase, multiplicative decrease.
+ *
+ * Limit grows by one after a limit worth of successful transfers and halves on
+ * failure or when latency grows well above the lowest one observed, but no more
+ * often than once per limit worth of transfers, as those were already running.
+ */
+class TransferLimiterAdaptive
+{
+public:
+  explicit TransferLimiterAdaptive(unsigned max, unsigned initial = 2);
+  TransferLimiterAdaptive(const TransferLimiterAdaptive&) = delete;
+  TransferLimiterAdaptive &operator=(const TransferLimiterAdaptive&) = delete;
+
+  void claim();
+  void release();
+  void completed(TransferResult result, std::chrono::microseconds latency);
+  unsigned limit() const;
+private:
+  mutable std::mutex m_lock;
+  std::condition_variable m_slot_free;
+  const unsigned m_max;
+  unsigned m_limit;
+  unsigned m_in_flight;
+  unsigned m_successes;
+  unsigned m_since_decrease;
+  std::optional<std::chrono::microseconds> m_min_latency;
+};
+
+
+// feeds transfer outcome to limiters that adapt to it
+template <typename TransferLimiterT>
+auto notify_transfer_completed(TransferLimiterT &limiter, TransferResult result, std::chrono::microseconds latency, int)
+  -> decltype(limiter.completed(result, latency), void())
+{
+  limiter.completed(result, latency);
+}
+
+template <typename TransferLimiterT>
+void notify_transfer_completed(TransferLimiterT&, TransferResult, std::chrono::microseconds, long)
+{
+}
+
+
 class GvfsTransferBase
 {
+public:
+  static constexpr unsigned MAX_ATTEMPTS = 4;
+
+  // delay before the first retry of failed transfer, doubles for every next one
+  void retry_backoff(std::chrono::milliseconds backoff)
+    {
+      m_retry_backoff = backoff;
+    }
 protected:
   static unsigned calculate_failure_margin(std::size_t transfers);
+  std::chrono::milliseconds backoff_for_attempt(unsigned attempt) const;
+
+  std::chrono::milliseconds m_retry_backoff = std::chrono::milliseconds(250);
 };
 
 template <typename ContainerT, typename FileTransferT = FileTransfer, typename TransferLimiterT = TransferLimiterNoLimit>
@@ -122,67 +181,121 @@ public:
 
   unsigned transfer()
   {
-    unsigned failures = 0;
-    do {
-      unsigned fails = try_file_transfer();
-      if(fails > 0) {
-        bool no_progress = fails == failures;
-        failures = fails;
-        if(no_progress) {
-          break;
+    {
+      Monitor::Lock lock(m_finished);
+      m_remaining = 0;
+      m_failures = 0;
+      m_retries.clear();
+      for(const FileTransferT &transfer : m_transfers) {
+        if(transfer.result != TransferResult::SUCCESS) {
+          ++m_remaining;
         }
       }
-      else {
-        failures = 0;
+    }
+
+    for(const FileTransferT &transfer : m_transfers) {
+      if(transfer.result != TransferResult::SUCCESS) {
+        start_transfer(transfer, 1);
       }
     }
-    while(failures > 0 && !m_cancel_op->is_cancelled());
 
-    return failures;
+    // failed transfers are retried one by one, when their backoff expires
+    while(true) {
+      std::vector<Retry> due;
+      {
+        Monitor::Lock lock(m_finished);
+        while(due.empty()) {
+          if(m_failures > m_failure_margin) {
+            m_cancel_op->cancel();
+          }
+          if(m_cancel_op->is_cancelled() && !m_retries.empty()) {
+            m_failures += m_retries.size();
+            m_remaining -= m_retries.size();
+            m_retries.clear();
+          }
+          if(m_remaining == 0) {
+            return m_failures;
+          }
+
+          auto now = std::chrono::steady_clock::now();
+          std::optional<std::chrono::steady_clock::time_point> next_retry;
+          for(auto iter = m_retries.begin(); iter != m_retries.end();) {
+            if(iter->due <= now) {
+              due.push_back(*iter);
+              iter = m_retries.erase(iter);
+            }
+            else {
+              if(!next_retry || iter->due < *next_retry) {
+                next_retry = iter->due;
+              }
+              ++iter;
+            }
+          }
+
+          if(due.empty()) {
+            if(next_retry) {
+              m_finished.wait_until(lock, *next_retry);
+            }
+            else {
+              m_finished.wait(lock);
+            }
+          }
+        }
+      }
+
+      // limiter might block, so has to be done without holding the lock
+      for(const auto & retry : due) {
+        start_transfer(*retry.transfer, retry.attempt);
+      }
+    }
   }
 protected:
   TransferLimiterT m_limiter;
 private:
-  unsigned try_file_transfer()
+  struct Retry
   {
-    std::atomic<unsigned> remaining(m_transfers.size());
-    std::atomic<unsigned> failures(0);
+    const FileTransferT *transfer;
+    unsigned attempt;
+    std::chrono::steady_clock::time_point due;
+  };
 
-    for(const FileTransferT &transfer : m_transfers) {
-      if(transfer.result == TransferResult::SUCCESS) {
-        --remaining;
-        continue;
-      }
-      transfer.result = TransferResult::NOT_STARTED;
-      m_limiter.claim();
-      transfer.transfer_async([this, &remaining, &failures](TransferResult result) {
-        m_limiter.release();
-        if(result == TransferResult::FAILURE) {
-          ++failures;
-        }
+  void start_transfer(const FileTransferT &transfer, unsigned attempt)
+  {
+    transfer.result = TransferResult::NOT_STARTED;
+    m_limiter.claim();
+    auto started = std::chrono::steady_clock::now();
+    transfer.transfer_async([this, &transfer, attempt, started](TransferResult result) {
+      auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+      transfer_completed(transfer, attempt, result, latency);
+    }, m_cancel_op);
+  }
 
-        if(--remaining == 0 || result == TransferResult::FAILURE) {
-          Monitor::Lock lock(m_finished);
-          m_finished.notify_one();
-        }
-      }, m_cancel_op);
-    }
+  void transfer_completed(const FileTransferT &transfer, unsigned attempt, TransferResult result, std::chrono::microseconds latency)
+  {
+    transfer.result = result;
+    notify_transfer_completed(m_limiter, result, latency, 0);
+    m_limiter.release();
 
     Monitor::Lock lock(m_finished);
-    while(remaining > 0) {
-      m_finished.wait(lock);
-      if(failures > m_failure_margin) {
-        m_cancel_op->cancel();
+    if(result == TransferResult::FAILURE) {
+      if(attempt < MAX_ATTEMPTS && !m_cancel_op->is_cancelled()) {
+        m_retries.push_back(Retry{&transfer, attempt + 1, std::chrono::steady_clock::now() + backoff_for_attempt(attempt)});
+        m_finished.notify_one();
+        return;
       }
+      ++m_failures;
     }
-
-    return failures;
+    --m_remaining;
+    m_finished.notify_one();
   }
 
   const ContainerT &m_transfers;
   const unsigned m_failure_margin;
   const Glib::RefPtr<Gio::Cancellable> m_cancel_op = Gio::Cancellable::create();
   Monitor m_finished;
+  unsigned m_remaining = 0;
+  unsigned m_failures = 0;
+  std::vector<Retry> m_retries;
 };
 
 }
@@ -21,6 +21,8 @@
 #ifndef _SYNCHRONIZATION_ISYNCMANAGER_HPP_
 #define _SYNCHRONIZATION_ISYNCMANAGER_HPP_
 
+#include <functional>
+
 #include "note.hpp"
 #include "syncui.hpp"
 #include "syncutils.hpp"
@@ -54,6 +56,9 @@ public:
   virtual void last_sync_date(const Glib::DateTime &) = 0;
   virtual int get_revision(const NoteBase &note) const = 0;
   virtual void set_revision(const NoteBase & note, int revision) = 0;
+  // hash of note content at last synchronization, empty if not known
+  virtual Glib::ustring get_content_hash(const NoteBase &note) const = 0;
+  virtual void set_content_hash(const NoteBase &note, const Glib::ustring &hash) = 0;
   virtual const DeletedTitlesMap &deleted_note_titles() const = 0;
   virtual void reset() = 0;
   virtual const Glib::ustring &associated_server_id() const = 0;
@@ -72,12 +77,15 @@ public:
   virtual void perform_synchronization(const SyncUI::Ptr & sync_ui) = 0;
   virtual bool synchronized_note_xml_matches(const Glib::ustring & noteXml1, const Glib::ustring & noteXml2) = 0;
   virtual SyncState state() const = 0;
+  // stats of the last finished synchronization, can be called from any thread
+  virtual SyncStats last_sync_stats() const = 0;
 };
 
 class SyncServer
 {
 public:
   typedef std::unordered_map<Glib::ustring, NoteUpdate, Hash<Glib::ustring>> NoteUpdatesMap;
+  typedef std::function<void(NoteUpdatesMap && updates)> NoteUpdatesSlot;
 
   virtual ~SyncServer();
 
@@ -85,15 +93,20 @@ public:
   virtual bool commit_sync_transaction() = 0;
   virtual bool cancel_sync_transaction() = 0;
   virtual std::vector<Glib::ustring> get_all_note_uuids() = 0;
-  virtual NoteUpdatesMap get_note_updates_since(int revision) = 0;
+  // Passes updates to consumer in batches of at most batch_size, as soon as they are downloaded,
+  // so that only a few batches are in memory at once. Exceptions from consumer are propagated.
+  virtual void get_note_updates_since(int revision, std::size_t batch_size, const NoteUpdatesSlot & consumer) = 0;
   virtual notebooks::NotebookSerializer::Notebooks get_notebooks() = 0;
   virtual void delete_notes(const std::vector<Glib::ustring> & deletedNoteUUIDs) = 0;
-  virtual void upload_notes(const std::vector<NoteBase::Ref> & notes) = 0;
+  // content_hashes are note_content_hash() of notes, in the same order
+  virtual void upload_notes(const std::vector<NoteBase::Ref> & notes, const std::vector<Glib::ustring> & content_hashes) = 0;
   virtual void upload_notebooks(const std::vector<notebooks::NotebookData> &notebooks) = 0;
   virtual int latest_revision() = 0; // NOTE: Only reliable during a transaction
   virtual SyncLockInfo current_sync_lock() = 0;
   virtual Glib::ustring id() = 0;
   virtual bool updates_available_since(int revision) = 0;
+  // add the counters, that only server knows about
+  virtual void collect_stats(SyncStats & stats) = 0;
 };
 
 class GnoteSyncException
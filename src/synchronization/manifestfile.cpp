@@ -18,6 +18,10 @@
  */
 
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
 #include "debug.hpp"
 #include "manifestfile.hpp"
 #include "base/macros.hpp"
@@ -29,9 +33,28 @@
 namespace gnote {
 namespace sync {
 
+namespace {
+
+const char *attribute_value(const xmlAttr *attr)
+{
+  if(attr->children && attr->children->content) {
+    return reinterpret_cast<const char*>(attr->children->content);
+  }
+  return "";
+}
+
+guint64 str_to_uint64(const char *s)
+{
+  return g_ascii_strtoull(s, nullptr, 10);
+}
+
+}
+
+
 ManifestFile::ManifestFile(Glib::RefPtr<Gio::File> && path)
   : m_path(std::move(path))
   , m_xml(nullptr, nullptr)
+  , m_notes_parsed(false)
 {
   if(!m_path) {
     throw std::invalid_argument("Manifest path must be provided");
@@ -41,6 +64,7 @@ ManifestFile::ManifestFile(Glib::RefPtr<Gio::File> && path)
 ManifestFile::ManifestFile(Glib::ustring && xml_content)
   : m_xml_content(std::move(xml_content))
   , m_xml(nullptr, nullptr)
+  , m_notes_parsed(false)
 {
 }
 
@@ -65,6 +89,11 @@ bool ManifestFile::load()
 
 bool ManifestFile::load_xml()
 {
+  m_revision.reset();
+  m_server_id.clear();
+  m_notes_parsed = false;
+  m_notes.clear();
+  m_notes_by_rev.clear();
   if(xmlDocPtr xml = xmlReadMemory(m_xml_content.c_str(), m_xml_content.size(), m_path ? m_path->get_uri().c_str() : nullptr, "UTF-8", 0)) {
     m_xml = xmlDocUniquePtr(std::move(xml), &xmlFreeDoc);
     return true;
@@ -84,7 +113,11 @@ unsigned ManifestFile::revision()
   }
 
   xmlNodePtr root_node = xmlDocGetRootElement(m_xml.get());
-  xmlNodePtr sync_node = sharp::xml_node_xpath_find_single_node(root_node, "//sync");
+  // avoid searching the entire document, sync is the root
+  xmlNodePtr sync_node = root_node;
+  if(!sync_node || !xmlStrEqual(sync_node->name, reinterpret_cast<const xmlChar*>("sync"))) {
+    sync_node = sharp::xml_node_xpath_find_single_node(root_node, "//sync");
+  }
   Glib::ustring latest_rev_str = sharp::xml_node_get_attribute(sync_node, "revision");
   if(latest_rev_str != "") {
     m_revision = STRING_TO_INT(latest_rev_str );
@@ -146,6 +179,119 @@ void ManifestFile::write_new(const Glib::ustring &content)
   }
 }
 
+const ManifestFile::NoteMap &ManifestFile::notes()
+{
+  parse_notes();
+  return m_notes;
+}
+
+const ManifestNote *ManifestFile::find_note(const Glib::ustring &id)
+{
+  parse_notes();
+  auto iter = m_notes.find(id);
+  if(iter == m_notes.end()) {
+    return nullptr;
+  }
+  return &iter->second;
+}
+
+ManifestFile::NoteList ManifestFile::notes_since(int revision)
+{
+  parse_notes();
+  auto start = std::upper_bound(m_notes_by_rev.begin(), m_notes_by_rev.end(), revision,
+    [](int rev, const ManifestNote *note) { return rev < note->rev; });
+  return NoteList(start, m_notes_by_rev.end());
+}
+
+void ManifestFile::parse_notes()
+{
+  if(m_notes_parsed) {
+    return;
+  }
+  if(!m_xml) {
+    throw std::runtime_error("No valid manifest file has been loaded");
+  }
+
+  // manifest is flat, note elements are direct children of root
+  xmlNodePtr root_node = xmlDocGetRootElement(m_xml.get());
+  for(xmlNodePtr node = root_node ? root_node->children : nullptr; node; node = node->next) {
+    if(node->type != XML_ELEMENT_NODE || !xmlStrEqual(node->name, reinterpret_cast<const xmlChar*>("note"))) {
+      continue;
+    }
+
+    ManifestNote note{"", 0, std::nullopt, ""};
+    const char *pack_offset = nullptr;
+    const char *pack_length = nullptr;
+    for(xmlAttr *attr = node->properties; attr; attr = attr->next) {
+      const char *name = reinterpret_cast<const char*>(attr->name);
+      if(std::strcmp(name, "id") == 0) {
+        note.id = attribute_value(attr);
+      }
+      else if(std::strcmp(name, "rev") == 0) {
+        note.rev = std::atoi(attribute_value(attr));
+      }
+      else if(std::strcmp(name, "pack-offset") == 0) {
+        pack_offset = attribute_value(attr);
+      }
+      else if(std::strcmp(name, "pack-length") == 0) {
+        pack_length = attribute_value(attr);
+      }
+      else if(std::strcmp(name, "content-hash") == 0) {
+        note.content_hash = attribute_value(attr);
+      }
+    }
+    if(note.id.empty()) {
+      continue;
+    }
+    if(pack_offset && *pack_offset) {
+      note.pack = RevisionPackEntry{str_to_uint64(pack_offset), pack_length ? str_to_uint64(pack_length) : 0};
+    }
+
+    auto id = note.id;
+    auto res = m_notes.emplace(std::move(id), std::move(note));
+    if(!res.second) {
+      DBG_OUT_1("Duplicate note %s in manifest, ignoring", res.first->first.c_str());
+      continue;
+    }
+    m_notes_by_rev.push_back(&res.first->second);
+  }
+
+  std::stable_sort(m_notes_by_rev.begin(), m_notes_by_rev.end(),
+    [](const ManifestNote *a, const ManifestNote *b) { return a->rev < b->rev; });
+  m_notes_parsed = true;
+}
+
+
+ManifestWriter::ManifestWriter(int revision, const Glib::ustring &server_id)
+{
+  m_xml.write_start_document();
+  m_xml.write_start_element("", "sync", "");
+  m_xml.write_attribute_string("", "revision", "", TO_STRING(revision));
+  m_xml.write_attribute_string("", "server-id", "", server_id);
 }
+
+void ManifestWriter::write_note(const Glib::ustring &id, int rev, const std::optional<RevisionPackEntry> &pack, const Glib::ustring &content_hash)
+{
+  m_xml.write_start_element("", "note", "");
+  m_xml.write_attribute_string("", "id", "", id);
+  m_xml.write_attribute_string("", "rev", "", TO_STRING(rev));
+  if(pack) {
+    m_xml.write_attribute_string("", "pack-offset", "", TO_STRING(pack->offset));
+    m_xml.write_attribute_string("", "pack-length", "", TO_STRING(pack->length));
+  }
+  if(!content_hash.empty()) {
+    m_xml.write_attribute_string("", "content-hash", "", content_hash);
+  }
+  m_xml.write_end_element();
+}
+
+Glib::ustring ManifestWriter::finish()
+{
+  m_xml.write_end_element();
+  m_xml.write_end_document();
+  m_xml.close();
+  return m_xml.to_string();
 }
 
+}
+}
@@ -18,15 +18,36 @@
  */
 
 
+#ifndef _SYNCHRONIZATION_MANIFESTFILE_HPP_
+#define _SYNCHRONIZATION_MANIFESTFILE_HPP_
+
 #include <optional>
+#include <unordered_map>
+#include <vector>
 
 #include <giomm/file.h>
 #include <libxml/xmlreader.h>
 
+#include "base/hash.hpp"
+#include "revisionpack.hpp"
+#include "sharp/xmlwriter.hpp"
+
 
 namespace gnote {
 namespace sync {
 
+// note entry of a manifest
+struct ManifestNote
+{
+  Glib::ustring id;
+  int rev;
+  // location in revision pack, empty for notes stored in separate files
+  std::optional<RevisionPackEntry> pack;
+  // hash of synchronized note content, empty if not known
+  Glib::ustring content_hash;
+};
+
+
 class ManifestFile
 {
 public:
@@ -64,8 +85,17 @@ public:
   [[nodiscard]] unsigned revision();
   [[nodiscard]] Glib::ustring server_id();
   void write_new(const Glib::ustring &content);
+
+  typedef std::unordered_map<Glib::ustring, ManifestNote, Hash<Glib::ustring>> NoteMap;
+  typedef std::vector<const ManifestNote*> NoteList;
+  // notes are parsed once per loaded manifest
+  [[nodiscard]] const NoteMap &notes();
+  [[nodiscard]] const ManifestNote *find_note(const Glib::ustring &id);
+  // notes with revision greater than given one, ordered by revision
+  [[nodiscard]] NoteList notes_since(int revision);
 private:
   bool load_xml();
+  void parse_notes();
 
   Glib::RefPtr<Gio::File> m_path;
   Glib::ustring m_xml_content;
@@ -73,8 +103,33 @@ private:
   xmlDocUniquePtr m_xml;
   std::optional<unsigned> m_revision;
   Glib::ustring m_server_id;
+  bool m_notes_parsed;
+  NoteMap m_notes;
+  NoteList m_notes_by_rev;
+};
+
+
+/**
+ * Serializes manifest content note by note into a single string, without
+ * building an intermediate XML document.
+ */
+class ManifestWriter
+{
+public:
+  ManifestWriter(int revision, const Glib::ustring &server_id);
+  void write_note(const Glib::ustring &id, int rev, const std::optional<RevisionPackEntry> &pack, const Glib::ustring &content_hash);
+  void write_note(const ManifestNote &note)
+    {
+      write_note(note.id, note.rev, note.pack, note.content_hash);
+    }
+  // returns manifest content, writer can't be used afterwards
+  Glib::ustring finish();
+private:
+  sharp::XmlWriter m_xml;
 };
 
 }
 }
 
+#endif
+
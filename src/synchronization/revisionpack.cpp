@@ -0,0 +1,259 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <cstring>
+#include <stdexcept>
+
+#include <gio/gio.h>
+
+#include "revisionpack.hpp"
+
+
+namespace gnote {
+namespace sync {
+
+namespace {
+
+const char PACK_MAGIC[8] = {'G', 'N', 'O', 'T', 'E', 'P', 'C', 'K'};
+// magic, index offset, entry count, magic
+const std::size_t TRAILER_SIZE = sizeof(PACK_MAGIC) + sizeof(guint64) + sizeof(guint32) + sizeof(PACK_MAGIC);
+
+
+void append_u32(std::string & out, guint32 value)
+{
+  value = GUINT32_TO_LE(value);
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void append_u64(std::string & out, guint64 value)
+{
+  value = GUINT64_TO_LE(value);
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+class PackReader
+{
+public:
+  PackReader(const std::string & data, std::size_t pos, std::size_t end)
+    : m_data(data)
+    , m_pos(pos)
+    , m_end(end)
+    {}
+
+  guint32 read_u32()
+    {
+      guint32 value;
+      read_bytes(&value, sizeof(value));
+      return GUINT32_FROM_LE(value);
+    }
+
+  guint64 read_u64()
+    {
+      guint64 value;
+      read_bytes(&value, sizeof(value));
+      return GUINT64_FROM_LE(value);
+    }
+
+  Glib::ustring read_string()
+    {
+      auto length = read_u32();
+      if(m_end - m_pos < length) {
+        throw std::runtime_error("Unexpected end of revision pack");
+      }
+      std::string str(m_data, m_pos, length);
+      m_pos += length;
+      return str;
+    }
+
+  void read_bytes(void *dest, std::size_t count)
+    {
+      if(m_end - m_pos < count) {
+        throw std::runtime_error("Unexpected end of revision pack");
+      }
+      std::memcpy(dest, m_data.data() + m_pos, count);
+      m_pos += count;
+    }
+
+  bool at_end() const
+    {
+      return m_pos == m_end;
+    }
+private:
+  const std::string & m_data;
+  std::size_t m_pos;
+  const std::size_t m_end;
+};
+
+
+std::string convert(GConverter *converter, const char *data, std::size_t size)
+{
+  std::string out;
+  char buffer[16384];
+  while(true) {
+    gsize bytes_read = 0;
+    gsize bytes_written = 0;
+    GError *error = nullptr;
+    auto result = g_converter_convert(converter, data, size, buffer, sizeof(buffer), G_CONVERTER_INPUT_AT_END, &bytes_read, &bytes_written, &error);
+    if(result == G_CONVERTER_ERROR) {
+      std::runtime_error e(error->message);
+      g_error_free(error);
+      throw e;
+    }
+
+    out.append(buffer, bytes_written);
+    data += bytes_read;
+    size -= bytes_read;
+    if(result == G_CONVERTER_FINISHED) {
+      break;
+    }
+    if(bytes_read == 0 && bytes_written == 0) {
+      throw std::runtime_error("Incomplete compressed data");
+    }
+  }
+
+  return out;
+}
+
+std::string compress(const Glib::ustring & content)
+{
+  auto compressor = g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_RAW, -1);
+  try {
+    auto ret = convert(G_CONVERTER(compressor), content.data(), content.bytes());
+    g_object_unref(compressor);
+    return ret;
+  }
+  catch(...) {
+    g_object_unref(compressor);
+    throw;
+  }
+}
+
+std::string decompress(const char *data, std::size_t size)
+{
+  auto decompressor = g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_RAW);
+  try {
+    auto ret = convert(G_CONVERTER(decompressor), data, size);
+    g_object_unref(decompressor);
+    return ret;
+  }
+  catch(...) {
+    g_object_unref(decompressor);
+    throw;
+  }
+}
+
+}
+
+
+const char *const RevisionPackWriter::FILE_NAME = "notes.pack";
+
+
+RevisionPackWriter::RevisionPackWriter()
+{
+  m_data.append(PACK_MAGIC, sizeof(PACK_MAGIC));
+}
+
+RevisionPackEntry RevisionPackWriter::add(const Glib::ustring & note_id, const Glib::ustring & content)
+{
+  auto compressed = compress(content);
+  RevisionPackEntry entry{m_data.size(), compressed.size()};
+  m_data.append(compressed);
+  m_index[note_id] = entry;
+  return entry;
+}
+
+std::string RevisionPackWriter::finish()
+{
+  guint64 index_offset = m_data.size();
+  for(const auto & entry : m_index) {
+    append_u32(m_data, entry.first.bytes());
+    m_data.append(entry.first.raw());
+    append_u64(m_data, entry.second.offset);
+    append_u64(m_data, entry.second.length);
+  }
+  m_data.append(PACK_MAGIC, sizeof(PACK_MAGIC));
+  append_u64(m_data, index_offset);
+  append_u32(m_data, m_index.size());
+  m_data.append(PACK_MAGIC, sizeof(PACK_MAGIC));
+
+  m_index.clear();
+  return std::move(m_data);
+}
+
+
+RevisionPackReader::RevisionPackReader(std::string && data)
+  : m_data(std::move(data))
+{
+  if(m_data.size() < sizeof(PACK_MAGIC) + TRAILER_SIZE
+     || std::memcmp(m_data.data(), PACK_MAGIC, sizeof(PACK_MAGIC)) != 0) {
+    throw std::runtime_error("Not a revision pack");
+  }
+
+  PackReader trailer(m_data, m_data.size() - TRAILER_SIZE, m_data.size());
+  char magic[sizeof(PACK_MAGIC)];
+  trailer.read_bytes(magic, sizeof(magic));
+  auto index_offset = trailer.read_u64();
+  auto count = trailer.read_u32();
+  char end_magic[sizeof(PACK_MAGIC)];
+  trailer.read_bytes(end_magic, sizeof(end_magic));
+  if(std::memcmp(magic, PACK_MAGIC, sizeof(magic)) != 0
+     || std::memcmp(end_magic, PACK_MAGIC, sizeof(end_magic)) != 0
+     || index_offset < sizeof(PACK_MAGIC) || index_offset > m_data.size() - TRAILER_SIZE) {
+    throw std::runtime_error("Revision pack is truncated");
+  }
+
+  PackReader index(m_data, index_offset, m_data.size() - TRAILER_SIZE);
+  m_index.reserve(count);
+  for(guint32 i = 0; i < count; ++i) {
+    auto note_id = index.read_string();
+    RevisionPackEntry entry;
+    entry.offset = index.read_u64();
+    entry.length = index.read_u64();
+    m_index[std::move(note_id)] = entry;
+  }
+  if(!index.at_end()) {
+    throw std::runtime_error("Invalid revision pack index");
+  }
+}
+
+Glib::ustring RevisionPackReader::read(const RevisionPackEntry & entry) const
+{
+  if(entry.offset < sizeof(PACK_MAGIC) || entry.offset > m_data.size() || m_data.size() - entry.offset < entry.length) {
+    throw std::runtime_error("Note is out of revision pack bounds");
+  }
+
+  auto content = decompress(m_data.data() + entry.offset, entry.length);
+  if(!g_utf8_validate(content.data(), content.size(), nullptr)) {
+    throw std::runtime_error("Note in revision pack is not valid UTF-8");
+  }
+  return content;
+}
+
+std::optional<RevisionPackEntry> RevisionPackReader::find(const Glib::ustring & note_id) const
+{
+  auto iter = m_index.find(note_id);
+  if(iter == m_index.end()) {
+    return std::nullopt;
+  }
+  return iter->second;
+}
+
+}
+}
@@ -0,0 +1,91 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _SYNCHRONIZATION_REVISIONPACK_HPP_
+#define _SYNCHRONIZATION_REVISIONPACK_HPP_
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include <glibmm/ustring.h>
+
+#include "base/hash.hpp"
+
+
+namespace gnote {
+namespace sync {
+
+// location of compressed note in a pack
+struct RevisionPackEntry
+{
+  guint64 offset;
+  guint64 length;
+};
+
+
+/**
+ * Notes of a sync revision stored in a single compressed file.
+ *
+ * Every note is deflated separately, so that it can be read using offset and
+ * length, that are stored in the manifest, without inflating the others. An
+ * index at the end makes the pack readable on its own as well. Numbers are
+ * stored little endian, so packs can be shared between machines.
+ */
+class RevisionPackWriter
+{
+public:
+  static const char *const FILE_NAME;
+
+  RevisionPackWriter();
+  RevisionPackEntry add(const Glib::ustring & note_id, const Glib::ustring & content);
+  // returns pack file content, writer can't be used afterwards
+  std::string finish();
+  std::size_t size() const
+    {
+      return m_index.size();
+    }
+private:
+  std::string m_data;
+  std::unordered_map<Glib::ustring, RevisionPackEntry, Hash<Glib::ustring>> m_index;
+};
+
+
+class RevisionPackReader
+{
+public:
+  // throws, if data is not a valid pack
+  explicit RevisionPackReader(std::string && data);
+  // throws, if entry is out of range or not valid compressed data
+  Glib::ustring read(const RevisionPackEntry & entry) const;
+  std::optional<RevisionPackEntry> find(const Glib::ustring & note_id) const;
+  const std::unordered_map<Glib::ustring, RevisionPackEntry, Hash<Glib::ustring>> & index() const
+    {
+      return m_index;
+    }
+private:
+  std::string m_data;
+  std::unordered_map<Glib::ustring, RevisionPackEntry, Hash<Glib::ustring>> m_index;
+};
+
+}
+}
+
+#endif
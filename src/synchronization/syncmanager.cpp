@@ -20,6 +20,8 @@
 
 #include "config.h"
 
+#include <algorithm>
+
 #include <glibmm/i18n.h>
 #include <sigc++/sigc++.h>
 
@@ -42,6 +44,9 @@ namespace sync {
 
 namespace {
 
+  // updates downloaded and applied at once
+  const std::size_t NOTE_UPDATE_BATCH_SIZE = 64;
+
   std::vector<Glib::ustring> get_updated_note_titles(const SyncServer::NoteUpdatesMap &note_updates)
   {
     std::vector<Glib::ustring> titles;
@@ -61,6 +66,9 @@ namespace {
     : m_gnote(g)
     , m_note_manager(m)
     , m_state(IDLE)
+    , m_local_changes(0)
+    , m_local_changes_known(false)
+    , m_saving_for_upload(false)
   {
   }
 
@@ -121,6 +129,7 @@ namespace {
 
   void SyncManager::reset_client()
   {
+    m_local_changes_known = false;
     try {
       m_client->reset();
     }
@@ -149,13 +158,26 @@ namespace {
 
   void SyncManager::synchronization_thread()
   {
+    SyncStats stats;
+    stats.start();
     struct finally {
       SyncManager & manager;
       SyncServiceAddin *addin;
-      finally(SyncManager & m) : manager(m), addin(NULL){}
+      SyncStats & stats;
+      bool succeeded;
+      unsigned local_changes;
+      finally(SyncManager & m, SyncStats & s) : manager(m), addin(NULL), stats(s), succeeded(false), local_changes(0){}
       ~finally()
       {
+        if(succeeded) {
+          manager.m_local_changes_known = true;
+        }
+        else {
+          // changes were not uploaded
+          manager.m_local_changes += local_changes;
+        }
         try {
+          manager.sync_finished(stats, succeeded);
           if(addin) {
             addin->post_sync_cleanup();
           }
@@ -166,7 +188,7 @@ namespace {
         auto &m = manager;
         utils::main_context_invoke([&m] { m.m_sync_thread.reset(); });
       }
-    } f(*this);
+    } f(*this, stats);
     std::unique_ptr<SyncServer> server;
     try {
       f.addin = get_configured_sync_service();
@@ -197,8 +219,10 @@ namespace {
       //       For now, only saving before uploading (not sufficient for note conflict handling)
 
       set_state(ACQUIRING_LOCK);
+      stats.begin_phase(SyncStats::LOCK_WAIT);
       // TODO: We should really throw exceptions from BeginSyncTransaction ()
       if(!server->begin_sync_transaction()) {
+        stats.end_phase();
         set_state(LOCKED);
         DBG_OUT_1("Server locked, try again later");
         set_state(IDLE);
@@ -222,11 +246,101 @@ namespace {
 
       m_client->begin_synchronization();
       set_state(PREPARE_DOWNLOAD);
+      stats.begin_phase(SyncStats::DOWNLOAD);
+
+      // Gather list of new/updated note titles
+      // for title conflict handling purposes.
+      std::vector<Glib::ustring> note_update_titles;
+      // notes modified both locally and on server, resolved once all updates are known
+      std::vector<NoteUpdate> conflicts;
+      // updates having the title of other modified local note; the user is prompted
+      // once all updates are known, so renames are checked against all updated titles
+      std::vector<NoteUpdate> title_conflicts;
+
+      // Process updates from the server; the bread and butter of sync!
+      // Returns the updates to apply, the rest are added to conflicts.
+      auto without_conflicts = [this, &conflicts](std::vector<NoteUpdate> && updates, const NoteHashes & local_hashes) {
+        std::vector<NoteUpdate> batch;
+        batch.reserve(updates.size());
+        for(auto & update : updates) {
+          auto existing_note = find_note_by_uuid(update.m_uuid);
+          Glib::ustring content_hash;
+          if(existing_note) {
+            auto hash = local_hashes.find(existing_note.value().get().uri());
+            if(hash != local_hashes.end()) {
+              content_hash = hash->second;
+            }
+          }
+          if(!existing_note
+                || !touched_since_last_sync(existing_note.value())
+                || !locally_modified(existing_note.value(), content_hash)
+                || update.basically_equal_to(existing_note.value(), content_hash)) {
+            // New note or existing note hasn't been modified since last sync; simply update it from server
+            batch.push_back(std::move(update));
+          }
+          else {
+            conflicts.push_back(std::move(update));
+          }
+        }
+        return batch;
+      };
 
       // Handle notes modified or added on server
+      // Updates without conflicts are applied as they are downloaded, batch by batch.
       DBG_OUT_1("get_note_updates_since rev %d", m_client->last_synchronized_revision());
-      const auto note_updates = server->get_note_updates_since(m_client->last_synchronized_revision());
-      DBG_OUT_1("%zu updates since rev %d", note_updates.size(), m_client->last_synchronized_revision());
+      server->get_note_updates_since(m_client->last_synchronized_revision(), NOTE_UPDATE_BATCH_SIZE,
+        [this, &stats, &note_update_titles, &title_conflicts, &without_conflicts](SyncServer::NoteUpdatesMap && note_updates) {
+          stats.begin_phase(SyncStats::APPLY);
+          auto titles = get_updated_note_titles(note_updates);
+          note_update_titles.insert(note_update_titles.end(), titles.begin(), titles.end());
+
+          // hashes of local notes involved, computed in main thread at once
+          std::vector<Glib::ustring> hashed_uris;
+          for(auto & iter : note_updates) {
+            if(auto existing_note = find_note_by_uuid(iter.second.m_uuid)) {
+              if(touched_since_last_sync(existing_note.value())) {
+                hashed_uris.push_back(existing_note.value().get().uri());
+              }
+              if(auto by_title = note_mgr().find(iter.second.m_title)) {
+                hashed_uris.push_back(by_title.value().get().uri());
+              }
+            }
+          }
+          const auto local_hashes = note_content_hashes_in_main_thread(hashed_uris);
+
+          // First, check for new local notes that might have title conflicts
+          // with the updates coming from the server.  These are deferred, the user
+          // is prompted only when titles of all updates are known.
+          std::vector<NoteUpdate> updates;
+          updates.reserve(note_updates.size());
+          for(auto & iter : note_updates) {
+            if(find_note_by_uuid(iter.second.m_uuid)) {
+              auto existing_note = note_mgr().find(iter.second.m_title);
+              if(existing_note) {
+                auto hash = local_hashes.find(existing_note.value().get().uri());
+                if(!iter.second.basically_equal_to(existing_note.value(), hash != local_hashes.end() ? hash->second : Glib::ustring())) {
+                  DBG_OUT_1("Early conflict detection for '%s'", iter.second.m_title.c_str());
+                  title_conflicts.push_back(std::move(iter.second));
+                  continue;
+                }
+              }
+            }
+            updates.push_back(std::move(iter.second));
+          }
+
+          if(stats.notes_downloaded == 0 && note_updates.size() > 0)
+            set_state(DOWNLOADING);
+          stats.notes_downloaded += note_updates.size();
+
+          // TODO: Figure out why GUI doesn't always update smoothly
+
+          auto batch = without_conflicts(std::move(updates), local_hashes);
+          if(!batch.empty()) {
+            apply_note_updates_in_main_thread(std::move(batch));
+          }
+          stats.begin_phase(SyncStats::DOWNLOAD);
+        });
+      DBG_OUT_1("%zu updates since rev %d", stats.notes_downloaded, m_client->last_synchronized_revision());
 
       auto saved_notebooks = server->get_notebooks();
       bool write_notebooks = false;
@@ -234,125 +348,136 @@ namespace {
         write_notebooks = true;
       }
 
-      // Gather list of new/updated note titles
-      // for title conflict handling purposes.
-      const std::vector<Glib::ustring> note_update_titles{get_updated_note_titles(note_updates)};
-
-      // First, check for new local notes that might have title conflicts
-      // with the updates coming from the server.  Prompt the user if necessary.
-      // TODO: Lots of searching here and in the next foreach...
-      //       Want this stuff to happen all at once first, but
-      //       maybe there's a way to store this info and pass it on?
-      for(auto & iter : note_updates) {
-        if(find_note_by_uuid(iter.second.m_uuid)) {
-          auto existing_note = note_mgr().find(iter.second.m_title);
-          if(existing_note && !iter.second.basically_equal_to(existing_note.value())) {
-            DBG_OUT_1("Early conflict detection for '%s'", iter.second.m_title.c_str());
-            if(m_sync_ui != 0) {
-              m_sync_ui->note_conflict_detected(existing_note.value(), iter.second, note_update_titles);
+      stats.begin_phase(SyncStats::APPLY);
+      // titles of all updates are known now, prompt for title conflicts
+      for(auto & update : title_conflicts) {
+        auto existing_note = note_mgr().find(update.m_title);
+        if(!existing_note) {
+          continue;
+        }
+        auto hashes = note_content_hashes_in_main_thread({existing_note.value().get().uri()});
+        auto hash = hashes.find(existing_note.value().get().uri());
+        if(!update.basically_equal_to(existing_note.value(), hash != hashes.end() ? hash->second : Glib::ustring())) {
+          if(m_sync_ui != 0) {
+            m_sync_ui->note_conflict_detected(existing_note.value(), update, note_update_titles);
+          }
+        }
+      }
+      if(!title_conflicts.empty()) {
+        std::vector<Glib::ustring> hashed_uris;
+        for(auto & update : title_conflicts) {
+          if(auto existing_note = find_note_by_uuid(update.m_uuid)) {
+            if(touched_since_last_sync(existing_note.value())) {
+              hashed_uris.push_back(existing_note.value().get().uri());
             }
           }
         }
+        auto batch = without_conflicts(std::move(title_conflicts), note_content_hashes_in_main_thread(hashed_uris));
+        if(!batch.empty()) {
+          apply_note_updates_in_main_thread(std::move(batch));
+        }
       }
 
-      if(note_updates.size() > 0)
-        set_state(DOWNLOADING);
-
-      // TODO: Figure out why GUI doesn't always update smoothly
-
-      // Process updates from the server; the bread and butter of sync!
-      for(auto & iter : note_updates) {
-        auto existing_note = find_note_by_uuid(iter.second.m_uuid);
-
-        if(!existing_note) {
-          // Actually, it's possible to have a conflict here
-          // because of automatically-created notes like
-          // template notes (if a note with a new tag syncs
-          // before its associated template). So check by
-          // title and delete if necessary.
-          auto existingNote = note_mgr().find(iter.second.m_title);
-          if(existingNote) {
-            DBG_OUT_1("Deleting auto-generated note: %s", iter.second.m_title.c_str());
-            delete_note_in_main_thread(existingNote.value());
+      // all other updates are applied, so they can be involved in conflicts
+      for(auto & update : conflicts) {
+        if(auto existing_note = find_note_by_uuid(update.m_uuid)) {
+          // Logger.Debug ("Sync: Late conflict detection for '{0}'", noteUpdate.Title);
+          DBG_OUT_1("Content conflict in note update for note '%s'", update.m_title.c_str());
+          // Note already exists locally, but has been modified since last sync; prompt user
+          if(m_sync_ui != 0) {
+            m_sync_ui->note_conflict_detected(existing_note.value(), update, note_update_titles);
           }
-          create_note_in_main_thread(iter.second);
         }
-        else {
-          NoteBase & existing = existing_note.value();
-          if(existing.metadata_change_date() <= m_client->last_sync_date()
-                || iter.second.basically_equal_to(existing)) {
-            // Existing note hasn't been modified since last sync; simply update it from server
-            update_note_in_main_thread(existing, iter.second);
-          }
-          else {
-            // Logger.Debug ("Sync: Late conflict detection for '{0}'", noteUpdate.Title);
-            DBG_OUT_1("Content conflict in note update for note '%s'", iter.second.m_title.c_str());
-            // Note already exists locally, but has been modified since last sync; prompt user
-            if(m_sync_ui != 0) {
-              m_sync_ui->note_conflict_detected(existing, iter.second, note_update_titles);
-            }
 
-            if(auto existing_note = find_note_by_uuid(iter.second.m_uuid)) {
-              update_note_in_main_thread(existing_note.value(), iter.second);
-            }
-            else {
-              // Note has been deleted or okay'd for overwrite
-              create_note_in_main_thread(iter.second);
-            }
-          }
+        if(auto existing_note = find_note_by_uuid(update.m_uuid)) {
+          update_note_in_main_thread(existing_note.value(), update);
+        }
+        else {
+          // Note has been deleted or okay'd for overwrite
+          create_note_in_main_thread(update);
         }
       }
 
+      // server notes don't change until commit, get them once
+      const auto all_note_uuids = server->get_all_note_uuids();
+      const NoteIdSet server_note_ids(all_note_uuids.begin(), all_note_uuids.end());
+
       // Note deletion may affect the GUI, so we have to use the
       // delegate to run in the main gtk thread.
       // To be consistent, any exceptions in the delgate will be caught
       // and then rethrown in the synchronization thread.
-      delete_notes_in_main_thread(*server);
+      const auto notes_before_delete = note_mgr().note_count();
+      delete_notes_in_main_thread(server_note_ids);
+      stats.notes_deleted_locally = notes_before_delete - std::min(notes_before_delete, note_mgr().note_count());
 
       // TODO: Add following updates to syncDialog treeview
 
       set_state(PREPARE_UPLOAD);
+      stats.begin_phase(SyncStats::UPLOAD);
+      // everything changed so far, including notes updated from server, is checked below,
+      // saving the notes to upload doesn't count as change
+      f.local_changes = m_local_changes.exchange(0);
       // Look through all the notes modified on the client
       // and upload new or modified ones to the server
       std::vector<NoteBase::Ref> new_or_modified_notes;
-      note_mgr().for_each([this, &new_or_modified_notes](NoteBase & note) {
+      std::vector<Glib::ustring> uploaded_hashes;
+      NoteIdSet local_note_ids;
+      local_note_ids.reserve(note_mgr().note_count());
+      // new notes and notes touched since last sync, latter are only uploaded when content changed
+      std::vector<NoteBase::Ref> candidates;
+      std::vector<Glib::ustring> candidate_uris;
+      note_mgr().for_each([this, &candidates, &candidate_uris, &local_note_ids](NoteBase & note) {
+        local_note_ids.insert(note.id());
         // This is a new note that has never been synchronized to the server
         bool new_note = m_client->get_revision(note) == -1;
-        bool modified = m_client->get_revision(note) <= m_client->last_synchronized_revision()
-          && note.metadata_change_date() > m_client->last_sync_date();
-        if(new_note || modified) {
+        bool touched = !new_note && m_client->get_revision(note) <= m_client->last_synchronized_revision()
+          && touched_since_last_sync(note);
+        if(new_note || touched) {
+          candidates.push_back(note);
+          candidate_uris.push_back(note.uri());
+        }
+      });
+
+      const auto candidate_hashes = note_content_hashes_in_main_thread(candidate_uris);
+      for(NoteBase & note : candidates) {
+        auto hash = candidate_hashes.find(note.uri());
+        if(hash == candidate_hashes.end()) {
+          continue;  // deleted meanwhile
+        }
+        bool new_note = m_client->get_revision(note) == -1;
+        if(new_note || locally_modified(note, hash->second)) {
           note_save(note);
           new_or_modified_notes.push_back(note);
+          uploaded_hashes.push_back(hash->second);
           if(m_sync_ui != 0) {
             m_sync_ui->note_synchronized_th(note.get_title(), new_note? UPLOAD_NEW : UPLOAD_MODIFIED);
           }
         }
-      });
+      }
 
       DBG_OUT_1("Uploading %zu note updates", new_or_modified_notes.size());
       if(new_or_modified_notes.size() > 0) {
+        // files are uploaded from disk
+        note_mgr().flush_saves();
         set_state(UPLOADING);
-        server->upload_notes(new_or_modified_notes); // TODO: Callbacks to update GUI as upload progresses
+        server->upload_notes(new_or_modified_notes, uploaded_hashes); // TODO: Callbacks to update GUI as upload progresses
         write_notebooks = true;
       }
+      stats.notes_uploaded = new_or_modified_notes.size();
 
       DBG_OUT_2("upload complete, deleting notes");
 
       // Handle notes deleted on client
-      std::vector<Glib::ustring> locally_deleted_uuids;
-      auto all_note_uuids = server->get_all_note_uuids();
-      for(auto & iter : all_note_uuids) {
-        if(!find_note_by_uuid(iter)) {
-          locally_deleted_uuids.push_back(iter);
-          if(m_sync_ui != 0) {
-            Glib::ustring deleted_title = iter;
-            auto &deleted_note_titles = m_client->deleted_note_titles();
-            auto deleted_note = deleted_note_titles.find(iter);
-            if(deleted_note != deleted_note_titles.end()) {
-              deleted_title = deleted_note->second;
-            }
-            m_sync_ui->note_synchronized_th(deleted_title, DELETE_FROM_SERVER);
+      const auto locally_deleted_uuids = note_ids_missing_from(all_note_uuids, local_note_ids);
+      if(m_sync_ui != 0) {
+        auto &deleted_note_titles = m_client->deleted_note_titles();
+        for(auto & iter : locally_deleted_uuids) {
+          Glib::ustring deleted_title = iter;
+          auto deleted_note = deleted_note_titles.find(iter);
+          if(deleted_note != deleted_note_titles.end()) {
+            deleted_title = deleted_note->second;
           }
+          m_sync_ui->note_synchronized_th(deleted_title, DELETE_FROM_SERVER);
         }
       }
       if(locally_deleted_uuids.size() > 0) {
@@ -360,6 +485,7 @@ namespace {
         server->delete_notes(locally_deleted_uuids);
         write_notebooks = true;
       }
+      stats.notes_deleted_on_server = locally_deleted_uuids.size();
 
       {
       std::vector<notebooks::NotebookData> all_notebooks;
@@ -382,12 +508,17 @@ namespace {
       DBG_OUT_1("note synchronization completed, finishing up transaction");
 
       set_state(COMMITTING_CHANGES);
+      stats.begin_phase(SyncStats::COMMIT);
       bool commitResult = server->commit_sync_transaction();
+      stats.end_phase();
+      server->collect_stats(stats);
+      f.succeeded = commitResult;
       if(commitResult) {
         // Apply this revision number to all new/modified notes since last sync
         // TODO: Is this the best place to do this (after successful server commit)
-        for(NoteBase & iter : new_or_modified_notes) {
-          m_client->set_revision(iter, new_revision);
+        for(std::size_t i = 0; i < new_or_modified_notes.size(); ++i) {
+          m_client->set_revision(new_or_modified_notes[i], new_revision);
+          m_client->set_content_hash(new_or_modified_notes[i], uploaded_hashes[i]);
         }
         set_state(SUCCEEDED);
       }
@@ -409,6 +540,13 @@ namespace {
     }
     catch(std::exception & e) { // top-level try
       ERR_OUT(_("Synchronization failed with the following exception: %s"), e.what());
+      if(server) {
+        try {
+          server->collect_stats(stats);
+        }
+        catch(...)
+        {}
+      }
       abort_sync(server.get());
     }
   }
@@ -434,6 +572,22 @@ namespace {
   }
 
 
+  void SyncManager::sync_finished(SyncStats & stats, bool succeeded)
+  {
+    stats.finish(succeeded);
+    DBG_OUT_1("Synchronization stats: %s", stats.to_string().c_str());
+    std::lock_guard<std::mutex> lock(m_stats_lock);
+    m_last_stats = stats;
+  }
+
+
+  SyncStats SyncManager::last_sync_stats() const
+  {
+    std::lock_guard<std::mutex> lock(m_stats_lock);
+    return m_last_stats;
+  }
+
+
   void SyncManager::handle_note_buffer_changed(NoteBase &)
   {
     // Note changed, iff a sync is coming up we kill the
@@ -472,6 +626,11 @@ namespace {
 
   void SyncManager::handle_note_saved_or_deleted(NoteBase &)
   {
+    // the note is uploaded by the running sync
+    if(m_saving_for_upload) {
+      return;
+    }
+    ++m_local_changes;
     if(!m_sync_thread && m_autosync_timeout_pref_minutes > 0) {
       DBG_OUT_3("Note saved or deleted...restarting sync timer");
       m_last_background_check = Glib::DateTime::create_now_utc();
@@ -510,8 +669,9 @@ namespace {
         // TODO: Figure out a clever way to get the specific error up to the GUI
       }
       bool server_has_updates = false;
-      bool client_has_updates = m_client->deleted_note_titles().size() > 0;
-      if(!client_has_updates) {
+      bool client_has_updates = m_local_changes > 0 || m_client->deleted_note_titles().size() > 0;
+      if(!client_has_updates && !m_local_changes_known) {
+        // notes might have been changed before start, scan them once
         client_has_updates = note_mgr().search([this](const NoteBase & note, bool & has_updates) {
           if(m_client->get_revision(note) == -1 || note.metadata_change_date() > m_client->last_sync_date()) {
             has_updates = true;
@@ -519,6 +679,9 @@ namespace {
           }
           return true;
         }, false);
+        if(!client_has_updates) {
+          m_local_changes_known = true;
+        }
       }
 
       // NOTE: Important to check, at least to verify
@@ -647,6 +810,37 @@ namespace {
   }
 
 
+  void SyncManager::apply_note_updates_in_main_thread(std::vector<NoteUpdate> && updates)
+  {
+    // One dispatch per batch, so that UI stays responsive between them
+    utils::main_context_call([this, updates=std::move(updates)]() { apply_note_updates(updates); });
+  }
+
+
+  void SyncManager::apply_note_updates(const std::vector<NoteUpdate> & updates)
+  {
+    // listeners refresh titles and links once for the whole batch
+    NoteManagerBase::BatchChange batch(note_mgr());
+    for(const auto & update : updates) {
+      if(auto existing_note = find_note_by_uuid(update.m_uuid)) {
+        update_note(existing_note.value(), update);
+        continue;
+      }
+
+      // Actually, it's possible to have a conflict here
+      // because of automatically-created notes like
+      // template notes (if a note with a new tag syncs
+      // before its associated template). So check by
+      // title and delete if necessary.
+      if(auto existing_note = note_mgr().find(update.m_title)) {
+        DBG_OUT_1("Deleting auto-generated note: %s", update.m_title.c_str());
+        delete_note(existing_note.value());
+      }
+      create_note(update);
+    }
+  }
+
+
   void SyncManager::delete_note_in_main_thread(const NoteBase & existing_note)
   {
     // Note deletion may affect the GUI, so we have to use the
@@ -670,6 +864,8 @@ namespace {
     catch(...)
     {} // TODO: Handle exception in case that serverNote.XmlContent is invalid XML
     m_client->set_revision(local_note, server_note.m_latest_revision);
+    // runs in main thread, as part of note creation or update
+    m_client->set_content_hash(local_note, note_content_hash(local_note.data()));
 
     // Update dialog's sync status
     if(m_sync_ui != 0) {
@@ -678,6 +874,45 @@ namespace {
   }
 
 
+  bool SyncManager::touched_since_last_sync(const NoteBase & note)
+  {
+    return note.metadata_change_date() > m_client->last_sync_date();
+  }
+
+
+  // Notes, that were only touched (like metadata change), are not modified.
+  // content_hash is the current hash of the note, computed in main thread.
+  bool SyncManager::locally_modified(const NoteBase & note, const Glib::ustring & content_hash)
+  {
+    auto synced_hash = m_client->get_content_hash(note);
+    // hash is not known for notes synchronized by older versions
+    return synced_hash.empty() || synced_hash != content_hash;
+  }
+
+
+  SyncManager::NoteHashes SyncManager::note_content_hashes(const std::vector<Glib::ustring> & uris)
+  {
+    NoteHashes hashes;
+    for(const auto & uri : uris) {
+      note_mgr().find_by_uri(uri, [&hashes](NoteBase & note) {
+        hashes[note.uri()] = note_content_hash(note.data());
+      });
+    }
+    return hashes;
+  }
+
+
+  SyncManager::NoteHashes SyncManager::note_content_hashes_in_main_thread(const std::vector<Glib::ustring> & uris)
+  {
+    // Note text is loaded and cached in main thread only, so hash the whole batch there
+    NoteHashes hashes;
+    if(!uris.empty()) {
+      utils::main_context_call([this, &uris, &hashes]() { hashes = note_content_hashes(uris); });
+    }
+    return hashes;
+  }
+
+
   NoteBase::ORef SyncManager::find_note_by_uuid(const Glib::ustring & uuid)
   {
     auto note = note_mgr().find_by_uri("note://gnote/" + uuid);
@@ -740,23 +975,21 @@ namespace {
   }
 
 
-  void SyncManager::delete_notes_in_main_thread(SyncServer & server)
+  void SyncManager::delete_notes_in_main_thread(const NoteIdSet & server_notes)
   {
-    utils::main_context_call([this, &server]() { delete_notes(server); });
+    utils::main_context_call([this, &server_notes]() { delete_notes(server_notes); });
   }
 
 
-  void SyncManager::delete_notes(SyncServer & server)
+  void SyncManager::delete_notes(const NoteIdSet & server_notes)
   {
     try {
-      // Get all notes currently on server
-      auto server_notes = server.get_all_note_uuids();
       std::vector<NoteBase::Ref> to_delete;
 
       // Delete notes locally that have been deleted on the server
-      note_mgr().for_each([this, server_notes=std::move(server_notes), &to_delete](NoteBase & note) {
+      note_mgr().for_each([this, &server_notes, &to_delete](NoteBase & note) {
 	if(m_client->get_revision(note) != -1
-	   && std::find(server_notes.begin(), server_notes.end(), note.id()) == server_notes.end()) {
+	   && server_notes.find(note.id()) == server_notes.end()) {
 	  if(m_sync_ui != 0) {
 	    m_sync_ui->note_synchronized(note.get_title(), DELETE_FROM_CLIENT);
 	  }
@@ -824,11 +1057,19 @@ namespace {
   {
     auto uri = note.uri();
     utils::main_context_call([this, uri] {
-      note_mgr().find_by_uri(uri, [](NoteBase & note) { note.save(); });
+      note_mgr().find_by_uri(uri, [this](NoteBase & note) { save_note_for_upload(note); });
     });
   }
 
 
+  void SyncManager::save_note_for_upload(NoteBase & note)
+  {
+    m_saving_for_upload = true;
+    note.save();
+    m_saving_for_upload = false;
+  }
+
+
   void SyncManager::update_local_notebooks_on_main_thread(std::vector<notebooks::NotebookData> &&updates)
   {
     utils::main_context_call([this, updates=std::move(updates)] {
@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2012-2014,2017-2021,2023-2025 Aurimas Cernius
+ * Copyright (C) 2012-2014,2017-2021,2023-2026 Aurimas Cernius
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -22,7 +22,9 @@
 #define _SYNCHRONIZATION_SYNCMANAGER_HPP_
 
 
+#include <atomic>
 #include <map>
+#include <mutex>
 #include <thread>
 
 #include <glibmm/main.h>
@@ -53,22 +55,33 @@ namespace sync {
       {
         return m_state;
       }
+    virtual SyncStats last_sync_stats() const override;
   protected:
     virtual void initialize_sync_service_addins(NoteManagerBase &);
     virtual void connect_system_signals();
     virtual SyncServiceAddin *get_sync_service_addin(const Glib::ustring & sync_service_id);
     virtual SyncServiceAddin *get_configured_sync_service();
-    virtual void delete_notes_in_main_thread(SyncServer & server);
-    void delete_notes(SyncServer & server);
+    // deletes synchronized notes, that are no longer on server
+    virtual void delete_notes_in_main_thread(const NoteIdSet & server_notes);
+    void delete_notes(const NoteIdSet & server_notes);
     void update_local_notebooks(const std::vector<notebooks::NotebookData> &updates);
     virtual void note_save(const NoteBase & note);
+    // saves note to upload, the save is not counted as local change
+    void save_note_for_upload(NoteBase & note);
     virtual void create_note_in_main_thread(const NoteUpdate & noteUpdate);
     virtual void update_note_in_main_thread(const NoteBase & existing_note, const NoteUpdate & note_update);
     virtual void delete_note_in_main_thread(const NoteBase & existing_note);
+    // create or update notes without conflicts
+    virtual void apply_note_updates_in_main_thread(std::vector<NoteUpdate> && updates);
     virtual void update_local_notebooks_on_main_thread(std::vector<notebooks::NotebookData> &&updates);
     void create_note(const NoteUpdate & noteUpdate);
     void update_note(NoteBase & existing_note, const NoteUpdate & note_update);
     void delete_note(NoteBase & existing_note);
+    void apply_note_updates(const std::vector<NoteUpdate> & updates);
+    typedef std::unordered_map<Glib::ustring, Glib::ustring, Hash<Glib::ustring>> NoteHashes;
+    // content hashes of notes by uri, missing notes are skipped
+    NoteHashes note_content_hashes(const std::vector<Glib::ustring> & uris);
+    virtual NoteHashes note_content_hashes_in_main_thread(const std::vector<Glib::ustring> & uris);
 
     std::unique_ptr<SyncClient> m_client;
     SyncUI::Ptr m_sync_ui;
@@ -79,12 +92,15 @@ namespace sync {
     void background_sync_checker();
     void set_state(SyncState new_state);
     void update_local_note(NoteBase & local_note, const NoteUpdate & server_note, NoteSyncType sync_type);
+    bool touched_since_last_sync(const NoteBase & note);
+    bool locally_modified(const NoteBase & note, const Glib::ustring & content_hash);
     NoteBase::ORef find_note_by_uuid(const Glib::ustring & uuid);
     NoteManagerBase & note_mgr();
     void get_synchronized_xml_bits(const Glib::ustring & noteXml, Glib::ustring & title, Glib::ustring & tags, Glib::ustring & content);
     void abort_sync(SyncServer *server);
     void sync_checker_thread();
     void on_sync_checker_finished(bool need_update);
+    void sync_finished(SyncStats & stats, bool succeeded);
 
     IGnote & m_gnote;
     NoteManagerBase & m_note_manager;
@@ -95,6 +111,14 @@ namespace sync {
     int m_autosync_timeout_pref_minutes;
     int m_current_autosync_timeout_minutes;
     Glib::DateTime m_last_background_check;
+    // notes saved or deleted since the last upload, so background check doesn't scan notes
+    std::atomic<unsigned> m_local_changes;
+    // false until notes are scanned or synchronized once, changes from previous runs aren't counted
+    std::atomic<bool> m_local_changes_known;
+    // main thread only
+    bool m_saving_for_upload;
+    mutable std::mutex m_stats_lock;
+    SyncStats m_last_stats;
   };
 
 
@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2012-2014,2016-2017,2019,2021,2023-2025 Aurimas Cernius
+ * Copyright (C) 2012-2014,2016-2017,2019,2021,2023-2026 Aurimas Cernius
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -18,6 +18,10 @@
  */
 
 
+#include <algorithm>
+
+#include <glibmm/checksum.h>
+
 #include "notemanagerbase.hpp"
 #include "syncutils.hpp"
 #include "sharp/xmlreader.hpp"
@@ -49,8 +53,12 @@ namespace sync {
   }
 
 
-  bool NoteUpdate::basically_equal_to(const NoteBase &existing_note) const
+  bool NoteUpdate::basically_equal_to(const NoteBase &existing_note, const Glib::ustring &local_hash) const
   {
+    if(!m_content_hash.empty() && !local_hash.empty()) {
+      return m_content_hash == local_hash;
+    }
+
     // NOTE: This would be so much easier if NoteUpdate
     //       was not just a container for a big XML string
     sharp::XmlReader xml;
@@ -94,5 +102,164 @@ namespace sync {
     return false;
   }
 
+
+  Glib::ustring note_content_hash(const NoteData &data)
+  {
+    // content without note-content element, to ignore differences in its attributes
+    const std::string &text = data.text().raw();
+    std::string::size_type start = 0, end = text.size();
+    if(text.compare(0, 13, "<note-content") == 0) {
+      auto open_end = text.find('>');
+      auto close = text.rfind("</note-content>");
+      if(open_end != std::string::npos && close != std::string::npos && close > open_end) {
+        start = open_end + 1;
+        end = close;
+      }
+    }
+
+    std::vector<std::string> tags;
+    tags.reserve(data.tags().size());
+    for(const auto & tag : data.tags()) {
+      tags.push_back(tag.raw());
+    }
+    std::sort(tags.begin(), tags.end());
+
+    Glib::Checksum checksum(Glib::Checksum::Type::SHA256);
+    auto update = [&checksum](const char *str, std::size_t len) {
+      checksum.update(reinterpret_cast<const guchar*>(str), len);
+      // separator, that can't occur in UTF-8
+      const guchar sep = 0xff;
+      checksum.update(&sep, 1);
+    };
+    update(data.title().data(), data.title().bytes());
+    update(text.data() + start, end - start);
+    for(const auto & tag : tags) {
+      update(tag.data(), tag.size());
+    }
+
+    return checksum.get_string();
+  }
+
+
+  std::vector<Glib::ustring> note_ids_missing_from(const std::vector<Glib::ustring> &ids, const NoteIdSet &present)
+  {
+    std::vector<Glib::ustring> missing;
+    for(const auto & id : ids) {
+      if(present.find(id) == present.end()) {
+        missing.push_back(id);
+      }
+    }
+    return missing;
+  }
+
+
+  const char *SyncStats::phase_name(Phase phase)
+  {
+    switch(phase) {
+    case LOCK_WAIT:
+      return "lock-wait";
+    case MANIFEST_LOAD:
+      return "manifest-load";
+    case DOWNLOAD:
+      return "download";
+    case APPLY:
+      return "apply";
+    case UPLOAD:
+      return "upload";
+    case COMMIT:
+      return "commit";
+    default:
+      return "unknown";
+    }
+  }
+
+
+  SyncStats::SyncStats()
+    : notes_downloaded(0)
+    , notes_uploaded(0)
+    , notes_deleted_locally(0)
+    , notes_deleted_on_server(0)
+    , bytes_downloaded(0)
+    , bytes_uploaded(0)
+    , m_current_phase(-1)
+    , m_phase_start(0)
+    , m_start(0)
+    , m_end(0)
+    , m_succeeded(false)
+  {
+    std::fill(m_phase_usec, m_phase_usec + PHASE_COUNT, 0);
+  }
+
+
+  void SyncStats::start()
+  {
+    *this = SyncStats();
+    m_start = m_end = g_get_monotonic_time();
+  }
+
+
+  void SyncStats::finish(bool succeeded)
+  {
+    end_phase();
+    m_end = g_get_monotonic_time();
+    m_succeeded = succeeded;
+  }
+
+
+  void SyncStats::begin_phase(Phase phase)
+  {
+    end_phase();
+    m_current_phase = phase;
+    m_phase_start = g_get_monotonic_time();
+  }
+
+
+  void SyncStats::end_phase()
+  {
+    if(m_current_phase >= 0) {
+      m_phase_usec[m_current_phase] += g_get_monotonic_time() - m_phase_start;
+      m_current_phase = -1;
+    }
+  }
+
+
+  void SyncStats::move_phase_time(Phase from, Phase to, gint64 usec)
+  {
+    usec = std::min(usec, m_phase_usec[from]);
+    m_phase_usec[from] -= usec;
+    m_phase_usec[to] += usec;
+  }
+
+
+  std::map<Glib::ustring, gint64> SyncStats::to_map() const
+  {
+    std::map<Glib::ustring, gint64> values;
+    for(int i = 0; i < PHASE_COUNT; ++i) {
+      values[Glib::ustring(phase_name(Phase(i))) + "-usec"] = m_phase_usec[i];
+    }
+    values["total-usec"] = total_usec();
+    values["succeeded"] = m_succeeded;
+    values["notes-downloaded"] = notes_downloaded;
+    values["notes-uploaded"] = notes_uploaded;
+    values["notes-deleted-locally"] = notes_deleted_locally;
+    values["notes-deleted-on-server"] = notes_deleted_on_server;
+    values["bytes-downloaded"] = bytes_downloaded;
+    values["bytes-uploaded"] = bytes_uploaded;
+    return values;
+  }
+
+
+  Glib::ustring SyncStats::to_string() const
+  {
+    Glib::ustring str;
+    for(const auto & value : to_map()) {
+      if(!str.empty()) {
+        str += ' ';
+      }
+      str += Glib::ustring::compose("%1=%2", value.first, value.second);
+    }
+    return str;
+  }
+
 }
 }
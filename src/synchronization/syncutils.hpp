@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2012-2013,2017,2019,2021,2023-2025 Aurimas Cernius
+ * Copyright (C) 2012-2013,2017,2019,2021,2023-2026 Aurimas Cernius
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -22,7 +22,11 @@
 #define _SYNCHRONIZATION_SYNCUTILS_HPP_
 
 
+#include <map>
+#include <unordered_set>
+
 #include "note.hpp"
+#include "base/hash.hpp"
 
 
 namespace gnote {
@@ -69,14 +73,84 @@ namespace sync {
     Glib::ustring m_title;
     Glib::ustring m_uuid; //needed?
     int m_latest_revision;
+    // from server manifest, empty if server doesn't have it
+    Glib::ustring m_content_hash;
 
     NoteUpdate(const Glib::ustring & xml_content, const Glib::ustring & title, const Glib::ustring & uuid, int latest_revision);
-    [[nodiscard]] bool basically_equal_to(const NoteBase &existing_note) const;
+    // local_hash is note_content_hash() of existing_note, computed in main thread; empty if unknown
+    [[nodiscard]] bool basically_equal_to(const NoteBase &existing_note, const Glib::ustring &local_hash) const;
   private:
     Glib::ustring get_inner_content(const Glib::ustring & full_content_element) const;
     bool compare_tags(const NoteData::TagSet &set1, const NoteData::TagSet &set2) const;
   };
 
+
+  // Hash of note parts, that are synchronized: title, tags and content.
+  // Stable across runs and machines, so it can be stored in manifests.
+  Glib::ustring note_content_hash(const NoteData &data);
+
+
+  typedef std::unordered_set<Glib::ustring, Hash<Glib::ustring>> NoteIdSet;
+
+  // Ids from the list, that are not in the set, in list order.
+  // Used to find notes deleted on either side, linear in note count.
+  std::vector<Glib::ustring> note_ids_missing_from(const std::vector<Glib::ustring> &ids, const NoteIdSet &present);
+
+
+  // Timings and counters of a single synchronization run
+  class SyncStats
+  {
+  public:
+    enum Phase {
+      LOCK_WAIT,
+      MANIFEST_LOAD,
+      DOWNLOAD,
+      APPLY,
+      UPLOAD,
+      COMMIT,
+      PHASE_COUNT
+    };
+    static const char *phase_name(Phase phase);
+
+    SyncStats();
+    void start();
+    void finish(bool succeeded);
+    // ends the current phase, if any
+    void begin_phase(Phase phase);
+    void end_phase();
+    // for part of a phase, that is measured by the server
+    void move_phase_time(Phase from, Phase to, gint64 usec);
+    gint64 phase_usec(Phase phase) const
+      {
+        return m_phase_usec[phase];
+      }
+    gint64 total_usec() const
+      {
+        return m_end - m_start;
+      }
+    bool succeeded() const
+      {
+        return m_succeeded;
+      }
+    // all values by name, times in microseconds
+    std::map<Glib::ustring, gint64> to_map() const;
+    Glib::ustring to_string() const;
+
+    guint64 notes_downloaded;
+    guint64 notes_uploaded;
+    guint64 notes_deleted_locally;
+    guint64 notes_deleted_on_server;
+    guint64 bytes_downloaded;
+    guint64 bytes_uploaded;
+  private:
+    gint64 m_phase_usec[PHASE_COUNT];
+    int m_current_phase;
+    gint64 m_phase_start;
+    gint64 m_start;
+    gint64 m_end;
+    bool m_succeeded;
+  };
+
 }
 }
 
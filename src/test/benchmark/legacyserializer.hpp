@@ -0,0 +1,453 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Note buffer serialization as it was before writing runs of characters at
+// once and deserialization as it was before loading the text at once, for
+// comparison in tests and benchmarks.
+
+#ifndef _TEST_BENCHMARK_LEGACYSERIALIZER_HPP_
+#define _TEST_BENCHMARK_LEGACYSERIALIZER_HPP_
+
+#include <deque>
+#include <stack>
+
+#include "notebuffer.hpp"
+#include "sharp/xmlreader.hpp"
+#include "sharp/xmlwriter.hpp"
+
+namespace benchmark {
+
+inline void legacy_write_tag(const Glib::RefPtr<const Gtk::TextTag> & tag, sharp::XmlWriter & xml, bool start)
+{
+  if(auto note_tag = std::dynamic_pointer_cast<const gnote::NoteTag>(tag)) {
+    note_tag->write(xml, start);
+  }
+  else if(gnote::NoteTagTable::tag_is_serializable(tag)) {
+    if(start) {
+      xml.write_start_element("", tag->property_name().get_value(), "");
+    }
+    else {
+      xml.write_end_element();
+    }
+  }
+}
+
+inline bool legacy_tag_ends_here(const Glib::RefPtr<const Gtk::TextTag> & tag,
+                                 const Gtk::TextIter & iter,
+                                 const Gtk::TextIter & next_iter)
+{
+  return (iter.has_tag(tag) && !next_iter.has_tag(tag)) || next_iter.is_end();
+}
+
+inline void legacy_serialize(const Glib::RefPtr<Gtk::TextBuffer> & buffer,
+                             const Gtk::TextIter & start,
+                             const Gtk::TextIter & end, sharp::XmlWriter & xml)
+{
+  std::stack<Glib::RefPtr<const Gtk::TextTag> > tag_stack;
+  std::stack<Glib::RefPtr<const Gtk::TextTag> > replay_stack;
+  std::stack<Glib::RefPtr<const Gtk::TextTag> > continue_stack;
+
+  Gtk::TextIter iter = start;
+  Gtk::TextIter next_iter = start;
+  next_iter.forward_char();
+
+  bool line_has_depth = false;
+  int prev_depth_line = -1;
+  int prev_depth = -1;
+
+  xml.write_start_element ("", "note-content", "");
+  xml.write_attribute_string ("", "version", "", "0.1");
+  xml.write_attribute_string("xmlns",
+                             "link",
+                             "",
+                             "http://beatniksoftware.com/tomboy/link");
+  xml.write_attribute_string("xmlns",
+                             "size",
+                             "",
+                             "http://beatniksoftware.com/tomboy/size");
+
+  // Insert any active tags at start into tag_stack...
+  for(const auto & start_tag : start.get_tags()) {
+    if (!start.toggles_tag (start_tag)) {
+      tag_stack.push (start_tag);
+      legacy_write_tag (start_tag, xml, true);
+    }
+  }
+
+  while ((iter != end) && iter.get_char()) {
+    gnote::DepthNoteTag::Ptr depth_tag = gnote::NoteBuffer::find_depth_tag (iter);
+
+    // If we are at a character with a depth tag we are at the
+    // start of a bulleted line
+    if (depth_tag && iter.starts_line()) {
+      line_has_depth = true;
+
+      if (iter.get_line() == prev_depth_line + 1) {
+        // Line part of existing list
+
+        if (depth_tag->get_depth() == prev_depth) {
+          // Line same depth as previous
+          // Close previous <list-item>
+          xml.write_end_element ();
+
+        }
+        else if (depth_tag->get_depth() > prev_depth) {
+          // Line of greater depth
+          xml.write_start_element ("", "list", "");
+
+          for (int i = prev_depth + 2; i <= depth_tag->get_depth(); i++) {
+            // Start a new nested list
+            xml.write_start_element ("", "list-item", "");
+            xml.write_start_element ("", "list", "");
+          }
+        } 
+        else {
+          // Line of lesser depth
+          // Close previous <list-item>
+          // and nested <list>s
+          xml.write_end_element ();
+
+          for (int i = prev_depth; i > depth_tag->get_depth(); i--) {
+            // Close nested <list>
+            xml.write_end_element ();
+            // Close <list-item>
+            xml.write_end_element ();
+          }
+        }
+      } 
+      else {
+        // Start of new list
+        xml.write_start_element ("", "list", "");
+        for (int i = 1; i <= depth_tag->get_depth(); i++) {
+          xml.write_start_element ("", "list-item", "");
+          xml.write_start_element ("", "list", "");
+        }
+      }
+
+      prev_depth = depth_tag->get_depth();
+
+      // Start a new <list-item>
+      legacy_write_tag (depth_tag, xml, true);
+    }
+
+    // Output any tags that begin at the current position
+    for(const auto& tag : iter.get_tags()) {
+      if(iter.starts_tag(tag)) {
+        if (!std::dynamic_pointer_cast<gnote::DepthNoteTag>(tag) && gnote::NoteTagTable::tag_is_serializable(tag)) {
+          legacy_write_tag (tag, xml, true);
+          tag_stack.push (tag);
+        }
+      }
+    }
+
+    // Reopen tags that continued across indented lines
+    // or into or out of lines with a depth
+    while (!continue_stack.empty() &&
+           ((!depth_tag && iter.starts_line ()) || (iter.get_line_offset() == 1)))
+    {
+      Glib::RefPtr<const Gtk::TextTag> continue_tag = continue_stack.top();
+      continue_stack.pop();
+
+      if (!legacy_tag_ends_here (continue_tag, iter, next_iter)
+          && iter.has_tag (continue_tag))
+      {
+        legacy_write_tag (continue_tag, xml, true);
+        tag_stack.push (continue_tag);
+      }
+    }
+
+    // Hidden character representing an anchor
+    if (iter.get_char() == 0xFFFC) {
+      if (iter.get_child_anchor()) {
+        const char * serialize = (const char*)(iter.get_child_anchor()->get_data(Glib::Quark("serialize")));
+        if (serialize)
+          xml.write_raw (serialize);
+      }
+      // Line Separator character
+    } 
+    else if (iter.get_char() == 0x2028) {
+      xml.write_char_entity (0x2028);
+    } 
+    else if (!depth_tag) {
+      xml.write_string (Glib::ustring(1, (gunichar)iter.get_char()));
+    }
+
+    bool end_of_depth_line = line_has_depth && next_iter.ends_line ();
+
+    bool next_line_has_depth = false;
+    if (iter.get_line() < buffer->get_line_count() - 1) {
+      Gtk::TextIter next_line = buffer->get_iter_at_line(iter.get_line()+1);
+      next_line_has_depth = (bool)gnote::NoteBuffer::find_depth_tag (next_line);
+    }
+
+    bool at_empty_line = iter.ends_line () && iter.starts_line ();
+
+    if (end_of_depth_line ||
+        (next_line_has_depth && (next_iter.ends_line () || at_empty_line)))
+    {
+      // Close all tags in the tag_stack
+      while (!tag_stack.empty()) {
+        Glib::RefPtr<const Gtk::TextTag> existing_tag;
+        existing_tag = tag_stack.top();
+        tag_stack.pop ();
+
+        // Any tags which continue across the indented
+        // line are added to the continue_stack to be
+        // reopened at the start of the next <list-item>
+        if (!legacy_tag_ends_here (existing_tag, iter, next_iter)) {
+          continue_stack.push (existing_tag);
+        }
+
+        legacy_write_tag (existing_tag, xml, false);
+      }
+    } 
+    else {
+      for(const auto& tag : iter.get_tags()) {
+        if (legacy_tag_ends_here (tag, iter, next_iter) &&
+            gnote::NoteTagTable::tag_is_serializable(tag) && !std::dynamic_pointer_cast<gnote::DepthNoteTag>(tag))
+        {
+          while (!tag_stack.empty()) {
+            Glib::RefPtr<const Gtk::TextTag> existing_tag = tag_stack.top();
+            tag_stack.pop();
+
+            if (!legacy_tag_ends_here (existing_tag, iter, next_iter)) {
+              replay_stack.push (existing_tag);
+            }
+
+            legacy_write_tag (existing_tag, xml, false);
+          }
+
+          // Replay the replay queue.
+          // Restart any tags that
+          // overlapped with the ended
+          // tag...
+          while (!replay_stack.empty()) {
+            Glib::RefPtr<const Gtk::TextTag> replay_tag = replay_stack.top();
+            replay_stack.pop();
+            tag_stack.push (replay_tag);
+
+            legacy_write_tag (replay_tag, xml, true);
+          }
+        }
+      }
+    }
+
+    // At the end of the line record that it
+    // was the last line encountered with a depth
+    if (end_of_depth_line) {
+      line_has_depth = false;
+      prev_depth_line = iter.get_line();
+    }
+
+    // If we are at the end of a line with a depth and the
+    // next line does not have a depth line close all <list>
+    // and <list-item> tags that remain open
+    if (end_of_depth_line && !next_line_has_depth) {
+      for (int i = prev_depth; i > -1; i--) {
+        // Close <list>
+        xml.write_full_end_element ();
+        // Close <list-item>
+        xml.write_full_end_element ();
+      }
+
+      prev_depth = -1;
+    }
+
+    iter.forward_char();
+    next_iter.forward_char();
+  }
+
+  // Empty any trailing tags left in tag_stack..
+  while (!tag_stack.empty()) {
+    Glib::RefPtr<const Gtk::TextTag> tail_tag = tag_stack.top ();
+    tag_stack.pop();
+    legacy_write_tag (tail_tag, xml, false);
+  }
+
+  xml.write_end_element (); // </note-content>
+}
+
+
+inline Glib::ustring legacy_serialize(const Glib::RefPtr<Gtk::TextBuffer> & buffer)
+{
+  sharp::XmlWriter xml;
+  legacy_serialize(buffer, buffer->begin(), buffer->end(), xml);
+  xml.close();
+  return xml.to_string();
+}
+
+
+struct LegacyTagStart
+{
+  LegacyTagStart()
+    : start(0)
+    {}
+  int start;
+  Glib::RefPtr<Gtk::TextTag> tag;
+};
+
+inline void legacy_deserialize(const Glib::RefPtr<Gtk::TextBuffer> & buffer,
+                               const Gtk::TextIter & start,
+                               sharp::XmlReader & xml)
+{
+  int offset = start.get_offset();
+  std::stack<LegacyTagStart> tag_stack;
+  LegacyTagStart tag_start;
+  Glib::ustring value;
+
+  gnote::NoteTagTable::Ptr note_table = std::dynamic_pointer_cast<gnote::NoteTagTable>(buffer->get_tag_table());
+
+  int curr_depth = -1;
+
+  // A stack of boolean values which mark if a
+  // list-item contains content other than another list
+  // For some reason, std::stack<bool> cause crashes.
+  std::deque<bool> list_stack;
+
+  try {
+    while (xml.read ()) {
+      Gtk::TextIter insert_at;
+      switch (xml.get_node_type()) {
+      case XML_READER_TYPE_ELEMENT:
+        if (xml.get_name() == "note-content")
+          break;
+
+        tag_start = LegacyTagStart();
+        tag_start.start = offset;
+
+        if (note_table &&
+            note_table->is_dynamic_tag_registered (xml.get_name())) {
+          tag_start.tag =
+            note_table->create_dynamic_tag (xml.get_name());
+        } 
+        else if (xml.get_name() == "list") {
+          curr_depth++;
+          // If we are inside a <list-item> mark off
+          // that we have encountered some content
+          if (!list_stack.empty()) {
+            list_stack.pop_front();
+            list_stack.push_front(true);
+          }
+          break;
+        } 
+        else if (xml.get_name() == "list-item") {
+          if (curr_depth >= 0) {
+            tag_start.tag = note_table->get_depth_tag(curr_depth);
+            list_stack.push_front (false);
+          } 
+          else {
+            g_warning("</list> tag mismatch");
+          }
+        } 
+        else {
+          tag_start.tag = buffer->get_tag_table()->lookup (xml.get_name());
+        }
+
+        if (auto tag = std::dynamic_pointer_cast<gnote::NoteTag>(tag_start.tag)) {
+          tag->read(xml, true);
+        }
+
+        if(!xml.is_empty_element()) {
+          tag_stack.push (tag_start);
+        }
+        break;
+      case XML_READER_TYPE_TEXT:
+      case XML_READER_TYPE_WHITESPACE:
+      case XML_READER_TYPE_SIGNIFICANT_WHITESPACE:
+        insert_at = buffer->get_iter_at_offset (offset);
+        value = xml.get_value();
+        buffer->insert (insert_at, value);
+
+        // we need the # of chars *Unicode) and not bytes (ASCII)
+        // see bug #587070
+        offset += value.length();
+
+        // If we are inside a <list-item> mark off
+        // that we have encountered some content
+        if (!list_stack.empty()) {
+          list_stack.pop_front ();
+          list_stack.push_front (true);
+        }
+
+        break;
+      case XML_READER_TYPE_END_ELEMENT:
+        if (xml.get_name() == "note-content")
+          break;
+
+        if (xml.get_name() == "list") {
+          curr_depth--;
+          break;
+        }
+
+        tag_start = tag_stack.top();
+        tag_stack.pop();
+        if (tag_start.tag) {
+
+          Gtk::TextIter apply_start, apply_end;
+          apply_start = buffer->get_iter_at_offset (tag_start.start);
+          apply_end = buffer->get_iter_at_offset (offset);
+
+          if(auto tag = std::dynamic_pointer_cast<gnote::NoteTag>(tag_start.tag)) {
+            tag->read(xml, false);
+          }
+
+          // Insert a bullet if we have reached a closing
+          // <list-item> tag, but only if the <list-item>
+          // had content.
+          auto depth_tag = std::dynamic_pointer_cast<gnote::DepthNoteTag>(tag_start.tag);
+
+          if (depth_tag && list_stack.front ()) {
+            auto note_buffer = std::dynamic_pointer_cast<gnote::NoteBuffer>(buffer);
+            // Do not insert bullet if it's already there
+            // this happens when using double identation in bullet list
+            if(!note_buffer->find_depth_tag(apply_start)) {
+              note_buffer->insert_bullet(apply_start, depth_tag->get_depth());
+              buffer->remove_all_tags (apply_start, apply_start);
+              offset += 2;
+            }
+            list_stack.pop_front();
+          } 
+          else if (!depth_tag) {
+            buffer->apply_tag (tag_start.tag, apply_start, apply_end);
+          }
+        }
+        break;
+      default:
+        g_warning("Unhandled element %d", xml.get_node_type());
+        break;
+      }
+    }
+  }
+  catch(const std::exception & e) {
+    g_warning("Exception: %s", e.what());
+  }
+}
+
+inline void legacy_deserialize(const Glib::RefPtr<Gtk::TextBuffer> & buffer, const Glib::ustring & content)
+{
+  if(!content.empty()) {
+    sharp::XmlReader xml;
+    xml.load_buffer(content);
+    legacy_deserialize(buffer, buffer->begin(), xml);
+  }
+}
+
+}
+
+#endif
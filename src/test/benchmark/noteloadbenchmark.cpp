@@ -0,0 +1,112 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// Measures loading of a generated note directory.
+// Usage: noteloadbenchmark [note count] [serial|parallel|lazy|snapshot]
+// Without mode all of them are run in turn. Peak memory is for the whole
+// process, run a single mode to get the peak for it.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <glibmm/init.h>
+#include <giomm/init.h>
+#include <gtkmm/init.h>
+
+#include "base/macros.hpp"
+#include "test/testgnote.hpp"
+#include "test/testnotemanager.hpp"
+#include "test/testutils.hpp"
+
+
+namespace {
+
+long current_rss_kb()
+{
+  long pages = 0, resident = 0;
+  FILE *statm = fopen("/proc/self/statm", "r");
+  if(statm) {
+    if(fscanf(statm, "%ld %ld", &pages, &resident) != 2) {
+      resident = 0;
+    }
+    fclose(statm);
+  }
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+long peak_rss_kb()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+void run(const char *mode, unsigned note_count, unsigned threads, bool with_text, bool from_snapshot = false)
+{
+  test::Gnote g;
+  auto dir = test::make_temp_dir();
+  auto files = test::write_test_notes(dir, note_count);
+  // first load writes the snapshot, the measured one reads it
+  std::unique_ptr<test::NoteManager> warmup;
+  if(from_snapshot) {
+    warmup = std::make_unique<test::NoteManager>(dir, g);
+    warmup->load_note_files(std::vector<Glib::ustring>(files), with_text, threads);
+  }
+  test::NoteManager manager(dir, g);
+
+  long rss_before = current_rss_kb();
+  auto start = std::chrono::steady_clock::now();
+  manager.load_note_files(std::move(files), with_text, threads);
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+  printf("%-8s notes: %6u  time: %6ld ms  memory: %7ld KiB  peak: %7ld KiB\n",
+         mode, unsigned(manager.note_count()), long(elapsed.count()), current_rss_kb() - rss_before, peak_rss_kb());
+}
+
+}
+
+
+int main(int argc, char **argv)
+{
+  setenv("LC_ALL", "en_US", 1);
+  Glib::init();
+  Gio::init();
+  Gtk::init_gtkmm_internals();
+
+  unsigned note_count = argc > 1 ? STRING_TO_INT(argv[1]) : 10000;
+  const char *mode = argc > 2 ? argv[2] : nullptr;
+
+  if(!mode || strcmp(mode, "serial") == 0) {
+    run("serial", note_count, 1, true);
+  }
+  if(!mode || strcmp(mode, "parallel") == 0) {
+    run("parallel", note_count, 0, true);
+  }
+  if(!mode || strcmp(mode, "lazy") == 0) {
+    run("lazy", note_count, 0, false);
+  }
+  if(!mode || strcmp(mode, "snapshot") == 0) {
+    run("snapshot", note_count, 0, false, true);
+  }
+
+  return 0;
+}
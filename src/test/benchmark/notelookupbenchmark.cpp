@@ -0,0 +1,89 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// Measures note lookup by title and by URI for growing note stores.
+// Usage: notelookupbenchmark [largest note count] [lookups]
+// Lookup cost should not grow with the number of notes.
+
+#include <chrono>
+#include <cstdio>
+#include <glibmm/init.h>
+#include <giomm/init.h>
+#include <gtkmm/init.h>
+
+#include "base/macros.hpp"
+#include "test/testgnote.hpp"
+#include "test/testnotemanager.hpp"
+#include "test/testutils.hpp"
+
+
+namespace {
+
+bool run(unsigned note_count, unsigned lookups)
+{
+  test::Gnote g;
+  auto dir = test::make_temp_dir();
+  test::NoteManager manager(dir, g);
+  manager.load_note_files(test::write_test_notes(dir, note_count), false);
+  std::vector<Glib::ustring> uris;
+  manager.for_each([&uris](gnote::NoteBase & note) { uris.push_back(note.uri()); });
+
+  unsigned found = 0;
+  auto start = std::chrono::steady_clock::now();
+  for(unsigned i = 0; i < lookups; ++i) {
+    unsigned idx = i * 7 % note_count;
+    found += manager.find(Glib::ustring::compose("note %1", idx)).has_value();
+  }
+  std::chrono::duration<double, std::micro> by_title = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for(unsigned i = 0; i < lookups; ++i) {
+    found += manager.find_by_uri(uris[i * 7 % note_count]).has_value();
+  }
+  std::chrono::duration<double, std::micro> by_uri = std::chrono::steady_clock::now() - start;
+
+  printf("notes: %6u  by title: %7.3f us  by uri: %7.3f us\n",
+         note_count, by_title.count() / lookups, by_uri.count() / lookups);
+  test::remove_dir(dir);
+  return found == 2 * lookups;
+}
+
+}
+
+
+int main(int argc, char **argv)
+{
+  setenv("LC_ALL", "en_US", 1);
+  Glib::init();
+  Gio::init();
+  Gtk::init_gtkmm_internals();
+
+  unsigned max_notes = argc > 1 ? STRING_TO_INT(argv[1]) : 10000;
+  unsigned lookups = argc > 2 ? STRING_TO_INT(argv[2]) : 20000;
+
+  for(unsigned note_count = 500; note_count <= max_notes; note_count *= 4) {
+    if(!run(note_count, lookups)) {
+      fprintf(stderr, "Lookup failed to find existing notes\n");
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// Measures loading note content into a buffer, as done when a note is opened.
+// Usage: noteopenbenchmark [repetitions]
+// Generated notes of 1 KiB, 100 KiB and 1 MiB are loaded text node by text
+// node, as previously, and at once. An insert handler, that looks at the
+// block around inserted text, stands in for the note watchers.
+
+#include <chrono>
+#include <cstdio>
+#include <glibmm/init.h>
+#include <giomm/init.h>
+#include <gtkmm/init.h>
+
+#include "base/macros.hpp"
+#include "notebuffer.hpp"
+#include "test/benchmark/legacyserializer.hpp"
+
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double elapsed_ms(Clock::time_point start)
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count() / 1000.0;
+}
+
+Glib::ustring generate_content(std::size_t size)
+{
+  Glib::ustring content = "<note-content version=\"0.1\" xmlns:link=\"http://beatniksoftware.com/tomboy/link\""
+    " xmlns:size=\"http://beatniksoftware.com/tomboy/size\">Generated note\n\n";
+  for(unsigned i = 0; content.bytes() < size; ++i) {
+    content += Glib::ustring::compose("%1: the <bold>meeting</bold> went <italic>well</italic>, "
+                                      "see <link:url>http://example.com/%1</link:url> &amp; notes.\n", i);
+  }
+  content += "</note-content>";
+  return content;
+}
+
+Glib::RefPtr<Gtk::TextBuffer> create_buffer(const Glib::RefPtr<Gtk::TextTagTable> & table, unsigned & scanned)
+{
+  auto buffer = Gtk::TextBuffer::create(table);
+  auto link = table->lookup("link:url");
+  buffer->signal_insert().connect([link, &scanned](const Gtk::TextIter & pos, const Glib::ustring & text, int) {
+    Gtk::TextIter start = pos;
+    start.backward_chars(text.size());
+    Gtk::TextIter end = pos;
+    gnote::NoteBuffer::get_block_extents(start, end, 80, link);
+    scanned += start.get_slice(end).size();
+  });
+  return buffer;
+}
+
+template <typename Load>
+double measure(const Glib::RefPtr<Gtk::TextTagTable> & table, const Glib::ustring & content, unsigned repetitions, Load load)
+{
+  double total = 0;
+  for(unsigned i = 0; i < repetitions; ++i) {
+    unsigned scanned = 0;
+    auto buffer = create_buffer(table, scanned);
+    auto start = Clock::now();
+    load(buffer, content);
+    total += elapsed_ms(start);
+  }
+  return total / repetitions;
+}
+
+}
+
+
+int main(int argc, char **argv)
+{
+  setenv("LC_ALL", "en_US", 1);
+  Glib::init();
+  Gio::init();
+  Gtk::init_gtkmm_internals();
+
+  unsigned repetitions = argc > 1 ? STRING_TO_INT(argv[1]) : 5;
+
+  auto table = Gtk::TextTagTable::create();
+  for(const char *name : {"bold", "italic", "link:url"}) {
+    table->add(gnote::NoteTag::create(name, gnote::NoteTag::CAN_UNDO));
+  }
+
+  for(std::size_t size : {std::size_t(1024), std::size_t(100 * 1024), std::size_t(1024 * 1024)}) {
+    auto content = generate_content(size);
+    double by_nodes = measure(table, content, repetitions, [](const Glib::RefPtr<Gtk::TextBuffer> & buffer, const Glib::ustring & xml) {
+      benchmark::legacy_deserialize(buffer, xml);
+    });
+    double at_once = measure(table, content, repetitions, [](const Glib::RefPtr<Gtk::TextBuffer> & buffer, const Glib::ustring & xml) {
+      gnote::NoteBufferArchiver::deserialize(buffer, xml);
+    });
+    unsigned scanned = 0;
+    auto legacy = create_buffer(table, scanned);
+    benchmark::legacy_deserialize(legacy, content);
+    auto buffer = create_buffer(table, scanned);
+    gnote::NoteBufferArchiver::deserialize(buffer, content);
+    if(gnote::NoteBufferArchiver::serialize(buffer) != benchmark::legacy_serialize(legacy)) {
+      fprintf(stderr, "Loaded buffers differ\n");
+      return 1;
+    }
+
+    printf("%5lu KiB note  by text nodes: %9.2f ms  at once: %9.2f ms\n",
+           (unsigned long)(size / 1024), by_nodes, at_once);
+  }
+  return 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// Serializes a large generated note buffer.
+// Usage: serializebenchmark [line count] [edits]
+// Measures the throughput of full serialization, compared to the previous
+// character by character one, then serializes every edit in full and using
+// the block cache, the cache should only pay for the blocks the edit touched.
+
+#include <chrono>
+#include <cstdio>
+#include <glibmm/init.h>
+#include <giomm/init.h>
+#include <gtkmm/init.h>
+
+#include "base/macros.hpp"
+#include "notebuffer.hpp"
+#include "test/benchmark/legacyserializer.hpp"
+
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double elapsed_ms(Clock::time_point start)
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count() / 1000.0;
+}
+
+Glib::RefPtr<Gtk::TextBuffer> create_buffer(unsigned line_count)
+{
+  auto table = Gtk::TextTagTable::create();
+  auto bold = gnote::NoteTag::create("bold", gnote::NoteTag::CAN_UNDO);
+  auto italic = gnote::NoteTag::create("italic", gnote::NoteTag::CAN_UNDO);
+  gnote::DepthNoteTag::Ptr depth = Glib::make_refptr_for_instance(new gnote::DepthNoteTag(0));
+  table->add(bold);
+  table->add(italic);
+  table->add(depth);
+  auto buffer = Gtk::TextBuffer::create(table);
+
+  // meeting log like: paragraphs with some formatting and short lists
+  for(unsigned i = 0; i < line_count; ++i) {
+    auto end = buffer->end();
+    if(i % 12 >= 9) {
+      end = buffer->insert_with_tag(end, "• ", depth);
+      buffer->insert(end, Glib::ustring::compose("Action item %1 for the team\n", i));
+    }
+    else {
+      end = buffer->insert(end, Glib::ustring::compose("%1: discussed the topic, ", i));
+      end = buffer->insert_with_tag(end, "decided", i % 2 ? bold : italic);
+      buffer->insert(end, " to follow up & report <back> next week.\n");
+    }
+  }
+  return buffer;
+}
+
+}
+
+
+int main(int argc, char **argv)
+{
+  setenv("LC_ALL", "en_US", 1);
+  Glib::init();
+  Gio::init();
+  Gtk::init_gtkmm_internals();
+
+  unsigned line_count = argc > 1 ? STRING_TO_INT(argv[1]) : 3000;
+  unsigned edits = argc > 2 ? STRING_TO_INT(argv[2]) : 50;
+
+  auto buffer = create_buffer(line_count);
+
+  auto start = Clock::now();
+  auto xml = gnote::NoteBufferArchiver::serialize(buffer);
+  double runs_ms = elapsed_ms(start);
+  start = Clock::now();
+  auto legacy_xml = benchmark::legacy_serialize(buffer);
+  double legacy_ms = elapsed_ms(start);
+  double mib = xml.bytes() / (1024.0 * 1024.0);
+  printf("Note of %u lines, %lu KiB XML\n", line_count, (unsigned long)(xml.bytes() / 1024));
+  printf("full, by runs:       %8.2f ms %8.2f MiB/s\n", runs_ms, mib * 1000 / runs_ms);
+  printf("full, by characters: %8.2f ms %8.2f MiB/s\n", legacy_ms, mib * 1000 / legacy_ms);
+  if(xml != legacy_xml) {
+    printf("serialization differs from the previous one\n");
+    return 1;
+  }
+
+  gnote::NoteBufferXmlCache cache(buffer);
+  start = Clock::now();
+  cache.serialize();
+  printf("first cached:        %8.2f ms, %lu blocks\n", elapsed_ms(start), (unsigned long)cache.block_count());
+
+  double full_ms = 0, cached_ms = 0;
+  bool same = true;
+  for(unsigned i = 0; i < edits; ++i) {
+    auto line = buffer->get_iter_at_line((i * 7919) % line_count);
+    line.forward_chars(3);
+    buffer->insert(line, "x");
+
+    start = Clock::now();
+    auto full = gnote::NoteBufferArchiver::serialize(buffer);
+    full_ms += elapsed_ms(start);
+
+    start = Clock::now();
+    auto cached = cache.serialize();
+    cached_ms += elapsed_ms(start);
+    same = same && full == cached;
+  }
+
+  printf("after edit, full:    %8.2f ms\n", full_ms / edits);
+  printf("after edit, cached:  %8.2f ms\n", cached_ms / edits);
+  if(!same) {
+    printf("cached serialization differs from full one\n");
+    return 1;
+  }
+  return 0;
+}
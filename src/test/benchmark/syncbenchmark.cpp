@@ -0,0 +1,150 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// Synchronizes generated stores through a local sync directory.
+// Usage: syncbenchmark [note count] [plain|packed] [modified notes]
+// Runs the first upload, the first download to another client, a sync
+// without changes and the round trip of modified notes, printing the
+// phase timings and counters of every run.
+
+#include <cstdio>
+#include <cstring>
+#include <glib/gstdio.h>
+#include <thread>
+#include <glibmm/init.h>
+#include <glibmm/main.h>
+#include <giomm/init.h>
+#include <gtkmm/init.h>
+
+#include "base/macros.hpp"
+#include "synchronization/silentui.hpp"
+#include "test/testgnote.hpp"
+#include "test/testnote.hpp"
+#include "test/testnotemanager.hpp"
+#include "test/testsyncmanager.hpp"
+#include "test/testutils.hpp"
+
+
+namespace {
+
+class Client
+{
+public:
+  Client(const Glib::ustring & dir, const Glib::ustring & sync_dir, bool pack)
+    : m_manifest(dir + "/manifest.xml")
+    , m_note_manager(dir + "/notes", m_gnote)
+    , m_sync_manager(m_gnote, m_note_manager, sync_dir)
+  {
+    m_gnote.notebook_manager(&m_note_manager.notebook_manager());
+    m_gnote.sync_manager(&m_sync_manager);
+    m_sync_manager.pack_revisions(pack);
+  }
+
+  test::NoteManager & note_manager()
+  {
+    return m_note_manager;
+  }
+
+  gnote::sync::SyncStats sync()
+  {
+    m_sync_manager.get_client(m_manifest);
+    auto ui = gnote::sync::SilentUI::create(m_gnote, m_note_manager);
+    m_sync_manager.perform_synchronization(ui);
+    return m_sync_manager.last_sync_stats();
+  }
+private:
+  const Glib::ustring m_manifest;
+  test::Gnote m_gnote;
+  test::NoteManager m_note_manager;
+  test::SyncManager m_sync_manager;
+};
+
+void print(const char *run, const gnote::sync::SyncStats & stats)
+{
+  printf("%-10s %s  total: %8.1f ms ", run, stats.succeeded() ? "ok    " : "failed", stats.total_usec() / 1000.0);
+  for(int i = 0; i < gnote::sync::SyncStats::PHASE_COUNT; ++i) {
+    auto phase = gnote::sync::SyncStats::Phase(i);
+    printf(" %s: %.1f", gnote::sync::SyncStats::phase_name(phase), stats.phase_usec(phase) / 1000.0);
+  }
+  printf("\n%-10s notes down/up: %lu/%lu  KiB down/up: %lu/%lu\n", "",
+         (unsigned long)stats.notes_downloaded, (unsigned long)stats.notes_uploaded,
+         (unsigned long)(stats.bytes_downloaded / 1024), (unsigned long)(stats.bytes_uploaded / 1024));
+}
+
+void modify_notes(test::NoteManager & manager, unsigned count)
+{
+  std::vector<gnote::NoteBase::Ref> notes;
+  manager.for_each([&notes, count](gnote::NoteBase & note) {
+    if(notes.size() < count) {
+      notes.push_back(note);
+    }
+  });
+  for(gnote::NoteBase & note : notes) {
+    auto & n = static_cast<test::Note&>(note);
+    n.set_xml_content(Glib::ustring::compose("<note-content><note-title>%1</note-title>\n\nModified content</note-content>", note.get_title()));
+    n.set_change_type(gnote::CONTENT_CHANGED);
+    n.save();
+  }
+}
+
+}
+
+
+int main(int argc, char **argv)
+{
+  setenv("LC_ALL", "en_US", 1);
+  Glib::init();
+  Gio::init();
+  Gtk::init_gtkmm_internals();
+
+  unsigned note_count = argc > 1 ? STRING_TO_INT(argv[1]) : 1000;
+  bool pack = argc > 2 && strcmp(argv[2], "packed") == 0;
+  unsigned modified_count = argc > 3 ? STRING_TO_INT(argv[3]) : note_count / 10;
+
+  auto dir = test::make_temp_dir();
+  auto sync_dir = dir + "/sync";
+  auto dir1 = dir + "/client1";
+  auto dir2 = dir + "/client2";
+  for(const auto & d : {sync_dir, dir1, dir2, dir1 + "/notes", dir2 + "/notes"}) {
+    g_mkdir(d.c_str(), S_IRWXU);
+  }
+
+  printf("Synchronizing %u notes (%s revisions), %u modified\n", note_count, pack ? "packed" : "plain", modified_count);
+  // file transfers complete in the main loop
+  auto main_loop = Glib::MainLoop::create();
+  std::thread thread([&]() {
+    Client client1(dir1, sync_dir, pack);
+    client1.note_manager().load_note_files(test::write_test_notes(dir1 + "/notes", note_count), true);
+    Client client2(dir2, sync_dir, pack);
+
+    print("upload", client1.sync());
+    print("download", client2.sync());
+    print("unchanged", client1.sync());
+    modify_notes(client1.note_manager(), modified_count);
+    print("modified", client1.sync());
+    print("updated", client2.sync());
+    main_loop->quit();
+  });
+  main_loop->run();
+  thread.join();
+
+  test::remove_dir(dir);
+  return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// Measures title trie matching throughput on note text, as done by auto-linking.
+// Usage: triebenchmark [note directory] [repetitions]
+// Without directory generated notes are used. Both the current tree and the
+// previous layout are measured on the same titles and text. Renaming a title
+// in place is compared to rebuilding the current tree.
+
+#include <chrono>
+#include <cstdio>
+#include <glibmm/init.h>
+#include <giomm/init.h>
+
+#include "base/macros.hpp"
+#include "notebase.hpp"
+#include "trie.hpp"
+#include "utils.hpp"
+#include "sharp/directory.hpp"
+#include "test/testnotemanager.hpp"
+#include "test/testutils.hpp"
+#include "test/benchmark/legacytrie.hpp"
+
+
+namespace {
+
+struct NoteText
+{
+  std::vector<Glib::ustring> titles;
+  std::vector<Glib::ustring> texts;
+  std::size_t bytes = 0;
+};
+
+NoteText read_notes(const Glib::ustring & dir)
+{
+  NoteText notes;
+  for(auto & file : sharp::directory_get_files_with_ext(dir, ".note")) {
+    gnote::NoteArchiver::ParsedNote note;
+    note.file = file;
+    try {
+      gnote::NoteArchiver::parse_file(note, true);
+    }
+    catch(const std::exception & e) {
+      fprintf(stderr, "Skipping %s: %s\n", file.c_str(), e.what());
+      continue;
+    }
+    notes.titles.push_back(note.data->title());
+    notes.texts.push_back(gnote::utils::XmlDecoder::decode(note.data->text()));
+    notes.bytes += notes.texts.back().bytes();
+  }
+  return notes;
+}
+
+template <typename Trie>
+void run(const char *name, const NoteText & notes, unsigned repetitions)
+{
+  auto start = std::chrono::steady_clock::now();
+  Trie trie(false);
+  for(const auto & title : notes.titles) {
+    trie.add_keyword(title, title);
+  }
+  trie.compute_failure_graph();
+  std::chrono::duration<double, std::milli> build = std::chrono::steady_clock::now() - start;
+
+  std::size_t hits = 0;
+  start = std::chrono::steady_clock::now();
+  for(unsigned i = 0; i < repetitions; ++i) {
+    for(const auto & text : notes.texts) {
+      hits += trie.find_matches(text).size();
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  double megabytes = double(notes.bytes) * repetitions / (1024 * 1024);
+  printf("%-8s build: %8.1f ms  matching: %8.2f MB/s  hits: %zu\n",
+         name, build.count(), megabytes / elapsed.count(), hits);
+}
+
+void run_renames(const NoteText & notes, unsigned renames)
+{
+  const auto & titles = notes.titles;
+  if(titles.empty()) {
+    return;
+  }
+  gnote::TrieTree<Glib::ustring> trie(false);
+  auto start = std::chrono::steady_clock::now();
+  for(const auto & title : titles) {
+    trie.add_keyword(title, title);
+  }
+  trie.compute_failure_graph();
+  std::chrono::duration<double, std::micro> rebuild = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for(unsigned i = 0; i < renames; ++i) {
+    const auto & title = titles[i * 7 % titles.size()];
+    Glib::ustring renamed = title + " renamed";
+    trie.remove_keyword(title, title);
+    trie.insert_keyword(renamed, title);
+    trie.remove_keyword(renamed, title);
+    trie.insert_keyword(title, title);
+  }
+  std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+  printf("rename   titles: %zu  rename: %8.2f us  full rebuild: %10.0f us\n",
+         titles.size(), elapsed.count() / (renames * 2), rebuild.count());
+}
+
+}
+
+
+int main(int argc, char **argv)
+{
+  setenv("LC_ALL", "en_US", 1);
+  Glib::init();
+  Gio::init();
+
+  Glib::ustring dir;
+  bool generated = argc < 2;
+  if(generated) {
+    dir = test::make_temp_dir();
+    test::write_test_notes(dir, 5000);
+  }
+  else {
+    dir = argv[1];
+  }
+  unsigned repetitions = argc > 2 ? STRING_TO_INT(argv[2]) : 5;
+
+  auto notes = read_notes(dir);
+  if(generated) {
+    test::remove_dir(dir);
+  }
+  printf("notes: %zu  text: %.2f MB  repetitions: %u\n", notes.texts.size(), double(notes.bytes) / (1024 * 1024), repetitions);
+
+  run<benchmark::LegacyTrieTree<Glib::ustring>>("previous", notes, repetitions);
+  run<gnote::TrieTree<Glib::ustring>>("current", notes, repetitions);
+  run_renames(notes, 500);
+
+  return 0;
+}
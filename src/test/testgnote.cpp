@@ -18,6 +18,7 @@
  */
 
 
+#include "preferences.hpp"
 #include "testgnote.hpp"
 
 namespace test {
@@ -63,7 +64,9 @@ void Gnote::sync_manager(gnote::sync::ISyncManager* manager)
 
 gnote::Preferences & Gnote::preferences()
 {
-  throw std::logic_error(std::string("Not implemented ") + __FUNCTION__);
+  // not initialized, only the cached settings are available, with zero values
+  static gnote::Preferences preferences;
+  return preferences;
 }
 
 gnote::MainWindow & Gnote::get_main_window()
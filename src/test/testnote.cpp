@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2014,2018-2019,2022 Aurimas Cernius
+ * Copyright (C) 2014,2018-2019,2022,2026 Aurimas Cernius
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -43,5 +43,10 @@ void Note::set_change_type(gnote::ChangeType c)
   gnote::NoteBase::set_change_type(c);
 }
 
+void Note::handle_link_rename(const Glib::ustring &, const gnote::NoteBase & renamed, bool)
+{
+  signal_link_rename(renamed);
+}
+
 }
 
@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2014,2018-2019,2022-2023 Aurimas Cernius
+ * Copyright (C) 2014,2018-2019,2022-2023,2026 Aurimas Cernius
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -31,9 +31,13 @@ public:
       return Glib::make_refptr_for_instance(new Note(std::move(_data), std::move(filepath), manager));
     }
   void set_change_type(gnote::ChangeType c);
+
+  // emitted for notes linking to the renamed one, before rename is finished
+  sigc::signal<void(const gnote::NoteBase&)> signal_link_rename;
 protected:
   virtual const gnote::NoteDataBufferSynchronizerBase & data_synchronizer() const;
   virtual gnote::NoteDataBufferSynchronizerBase & data_synchronizer();
+  void handle_link_rename(const Glib::ustring & old_title, const gnote::NoteBase & renamed, bool rename) override;
 private:
   Note(std::unique_ptr<gnote::NoteData> _data, Glib::ustring && filepath, gnote::NoteManagerBase & manager);
 
@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2014,2017,2019-2020,2022-2023,2025 Aurimas Cernius
+ * Copyright (C) 2014,2017,2019-2020,2022-2023,2025-2026 Aurimas Cernius
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -78,5 +78,11 @@ gnote::NoteBase::Ptr NoteManager::note_load(Glib::ustring && /*file_name*/)
   return gnote::NoteBase::Ptr();
 }
 
+gnote::NoteBase::Ptr NoteManager::note_load(gnote::NoteArchiver::ParsedNote && parsed)
+{
+  note_archiver().read_parsed(parsed);
+  return Note::create(std::move(parsed.data), std::move(parsed.file), *this);
+}
+
 }
 
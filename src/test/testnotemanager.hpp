@@ -53,9 +53,15 @@ public:
     }
 
   using gnote::NoteManagerBase::delete_old_backups;
+  using gnote::NoteManagerBase::load_note_files;
 protected:
   virtual gnote::NoteBase::Ptr note_create_new(Glib::ustring && title, Glib::ustring && file_name) override;
   gnote::NoteBase::Ptr note_load(Glib::ustring && file_name) override;
+  gnote::NoteBase::Ptr note_load(gnote::NoteArchiver::ParsedNote && parsed) override;
+  virtual Glib::ustring cache_dir() const override
+    {
+      return notes_dir();
+    }
 private:
   class NotebookManager
     : public gnote::notebooks::NotebookManager
@@ -26,14 +26,17 @@
 
 namespace test {
 
-SyncAddin::SyncAddin(const Glib::ustring & sync_path)
+SyncAddin::SyncAddin(const Glib::ustring & sync_path, bool pack_revisions)
   : m_sync_path(sync_path)
+  , m_pack_revisions(pack_revisions)
 {
 }
 
 std::unique_ptr<gnote::sync::SyncServer> SyncAddin::create_sync_server()
 {
-  return std::make_unique<gnote::sync::FileSystemSyncServer>(Gio::File::create_for_path(m_sync_path), "test");
+  auto server = std::make_unique<gnote::sync::FileSystemSyncServer>(Gio::File::create_for_path(m_sync_path), "test");
+  server->pack_revisions(m_pack_revisions);
+  return server;
 }
 
 void SyncAddin::post_sync_cleanup()
@@ -31,7 +31,7 @@ class SyncAddin
   : public gnote::sync::SyncServiceAddin
 {
 public:
-  SyncAddin(const Glib::ustring & sync_path);
+  SyncAddin(const Glib::ustring & sync_path, bool pack_revisions = false);
   std::unique_ptr<gnote::sync::SyncServer> create_sync_server() override;
   virtual void post_sync_cleanup() override;
   virtual Gtk::Widget *create_preferences_control(Gtk::Window & parent, EventHandler requiredPrefChanged) override;
@@ -46,6 +46,7 @@ public:
   virtual bool initialized() override;
 private:
   Glib::ustring m_sync_path;
+  bool m_pack_revisions;
 };
 
 }
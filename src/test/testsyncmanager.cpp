@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2017-2020,2023,2025 Aurimas Cernius
+ * Copyright (C) 2017-2020,2023,2025-2026 Aurimas Cernius
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -26,6 +26,7 @@ namespace test {
 SyncManager::SyncManager(gnote::IGnote & g, gnote::NoteManagerBase & manager, const Glib::ustring & sync_path)
   : gnote::sync::SyncManager(g, manager)
   , m_sync_path(sync_path)
+  , m_pack_revisions(false)
 {
   m_client.reset(new test::SyncClient(manager));
 }
@@ -55,7 +56,7 @@ bool SyncManager::synchronized_note_xml_matches(const Glib::ustring & /*noteXml1
 
 gnote::sync::SyncServiceAddin *SyncManager::get_sync_service_addin(const Glib::ustring & /*sync_service_id*/)
 {
-  return new SyncAddin(m_sync_path);
+  return new SyncAddin(m_sync_path, m_pack_revisions);
 }
 
 gnote::sync::SyncServiceAddin *SyncManager::get_configured_sync_service()
@@ -63,14 +64,14 @@ gnote::sync::SyncServiceAddin *SyncManager::get_configured_sync_service()
   return get_sync_service_addin("");
 }
 
-void SyncManager::delete_notes_in_main_thread(gnote::sync::SyncServer & server)
+void SyncManager::delete_notes_in_main_thread(const gnote::sync::NoteIdSet & server_notes)
 {
-  delete_notes(server);
+  delete_notes(server_notes);
 }
 
 void SyncManager::note_save(const gnote::NoteBase & note)
 {
-  const_cast<gnote::NoteBase&>(note).save();
+  save_note_for_upload(const_cast<gnote::NoteBase&>(note));
 }
 
 void SyncManager::create_note_in_main_thread(const gnote::sync::NoteUpdate & noteUpdate)
@@ -88,10 +89,20 @@ void SyncManager::delete_note_in_main_thread(const gnote::NoteBase & existing_no
   delete_note(const_cast<gnote::NoteBase&>(existing_note));
 }
 
+void SyncManager::apply_note_updates_in_main_thread(std::vector<gnote::sync::NoteUpdate> && updates)
+{
+  apply_note_updates(updates);
+}
+
 void SyncManager::update_local_notebooks_on_main_thread(std::vector<gnote::notebooks::NotebookData> &&updates)
 {
   update_local_notebooks(updates);
 }
 
+SyncManager::NoteHashes SyncManager::note_content_hashes_in_main_thread(const std::vector<Glib::ustring> & uris)
+{
+  return note_content_hashes(uris);
+}
+
 }
 
@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2017-2019,2023,2025 Aurimas Cernius
+ * Copyright (C) 2017-2019,2023,2025-2026 Aurimas Cernius
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -37,16 +37,23 @@ public:
   virtual bool synchronized_note_xml_matches(const Glib::ustring & noteXml1, const Glib::ustring & noteXml2) override;
   virtual gnote::sync::SyncServiceAddin *get_sync_service_addin(const Glib::ustring & sync_service_id) override;
   virtual gnote::sync::SyncServiceAddin *get_configured_sync_service() override;
-  virtual void delete_notes_in_main_thread(gnote::sync::SyncServer & server) override;
+  virtual void delete_notes_in_main_thread(const gnote::sync::NoteIdSet & server_notes) override;
   void note_save(const gnote::NoteBase & note) override;
   test::SyncClient & get_client(const Glib::ustring & manifest);
+  void pack_revisions(bool pack)
+    {
+      m_pack_revisions = pack;
+    }
 protected:
   virtual void create_note_in_main_thread(const gnote::sync::NoteUpdate & noteUpdate) override;
   void update_note_in_main_thread(const gnote::NoteBase & existing_note, const gnote::sync::NoteUpdate & note_update) override;
   void delete_note_in_main_thread(const gnote::NoteBase & existing_note) override;
+  void apply_note_updates_in_main_thread(std::vector<gnote::sync::NoteUpdate> && updates) override;
   void update_local_notebooks_on_main_thread(std::vector<gnote::notebooks::NotebookData> &&updates) override;
+  NoteHashes note_content_hashes_in_main_thread(const std::vector<Glib::ustring> & uris) override;
 private:
   Glib::ustring m_sync_path;
+  bool m_pack_revisions;
 };
 
 }
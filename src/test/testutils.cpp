@@ -18,6 +18,10 @@
  */
 
 
+#include <fstream>
+
+#include <glibmm/miscutils.h>
+
 #include "testutils.hpp"
 
 
@@ -34,5 +38,38 @@ Glib::ustring make_temp_dir()
   throw std::runtime_error("Failed to create temp dir");
 }
 
+std::vector<Glib::ustring> write_test_notes(const Glib::ustring & dir, unsigned count)
+{
+  std::vector<Glib::ustring> files;
+  for(unsigned i = 0; i < count; ++i) {
+    auto file = Glib::build_filename(dir, Glib::ustring::compose("note%1.note", i));
+    std::ofstream out(file);
+    out << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+        << "<note version=\"0.3\" xmlns:link=\"http://beatniksoftware.com/tomboy/link\" xmlns:size=\"http://beatniksoftware.com/tomboy/size\" xmlns=\"http://beatniksoftware.com/tomboy\">"
+        << "<title>Note " << i << "</title>"
+        << "<text xml:space=\"preserve\"><note-content version=\"0.1\">Note " << i << "\n\n";
+    for(unsigned p = 0; p < 20; ++p) {
+      out << "Paragraph " << p << " of generated note, with <bold>some</bold> formatting and a link to "
+          << "<link:internal>Note " << (i + p) % count << "</link:internal>.\n";
+    }
+    out << "</note-content></text>"
+        << "<last-change-date>2026-01-01T10:00:00.0000000+02:00</last-change-date>"
+        << "<last-metadata-change-date>2026-01-01T10:00:00.0000000+02:00</last-metadata-change-date>"
+        << "<create-date>2025-12-01T10:00:00.0000000+02:00</create-date>"
+        << "<cursor-position>0</cursor-position><selection-bound-position>-1</selection-bound-position>"
+        << "<width>450</width><height>360</height>";
+    if(i % 10 == 0) {
+      out << "<tags><tag>system:notebook:Notebook " << i % 7 << "</tag></tags>";
+    }
+    out << "</note>\n";
+    if(!out.good()) {
+      throw std::runtime_error("Failed to write note");
+    }
+    files.push_back(std::move(file));
+  }
+
+  return files;
+}
+
 }
 
@@ -18,12 +18,16 @@
  */
 
 
+#include <vector>
+
 #include <glibmm/ustring.h>
 
 
 namespace test {
 
 Glib::ustring make_temp_dir();
+// Write count generated notes to directory, returns the file names
+std::vector<Glib::ustring> write_test_notes(const Glib::ustring & dir, unsigned count);
 
 }
 
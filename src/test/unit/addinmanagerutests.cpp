@@ -0,0 +1,187 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <glibmm/miscutils.h>
+#include <UnitTest++/UnitTest++.h>
+
+#include "addinmanager.hpp"
+#include "notemanager.hpp"
+#include "notetag.hpp"
+#include "preferences.hpp"
+#include "sharp/dynamicmodule.hpp"
+#include "test/testgnote.hpp"
+#include "test/testutils.hpp"
+
+
+namespace {
+
+// Behaves like NoteSpellChecker: connects to a preference and attaches once, when the note is opened.
+class TestNoteAddin
+  : public gnote::NoteAddin
+{
+public:
+  static unsigned s_instances;
+  static unsigned s_initialized;
+  static unsigned s_shut_down;
+
+  static TestNoteAddin *create()
+    {
+      return new TestNoteAddin;
+    }
+  ~TestNoteAddin()
+    {
+      --s_instances;
+    }
+  void initialize() override
+    {
+      ++s_initialized;
+    }
+  void shutdown() override
+    {
+      ++s_shut_down;
+    }
+  void on_note_opened() override
+    {
+      ignote().preferences().signal_enable_spellchecking_changed
+        .connect(sigc::mem_fun(*this, &TestNoteAddin::on_enable_changed));
+      if(!m_attached) {
+        m_attached = true;
+      }
+    }
+  bool attached() const
+    {
+      return m_attached;
+    }
+private:
+  TestNoteAddin()
+    : m_attached(false)
+    {
+      ++s_instances;
+    }
+  void on_enable_changed()
+    {
+    }
+
+  bool m_attached;
+};
+
+unsigned TestNoteAddin::s_instances = 0;
+unsigned TestNoteAddin::s_initialized = 0;
+unsigned TestNoteAddin::s_shut_down = 0;
+
+
+class TestModule
+  : public sharp::DynamicModule
+{
+public:
+  TestModule()
+    {
+      ADD_INTERFACE_IMPL(TestNoteAddin);
+    }
+};
+
+}
+
+
+SUITE(AddinManager)
+{
+  struct Fixture
+  {
+    test::Gnote g;
+    TestModule module;
+    gnote::NoteManager manager;
+    gnote::AddinManager addin_manager;
+    gnote::Note::Ptr note;
+
+    Fixture()
+      : manager(g)
+      , addin_manager(g, manager, g.preferences(), test::make_temp_dir())
+    {
+      TestNoteAddin::s_initialized = 0;
+      TestNoteAddin::s_shut_down = 0;
+      gnote::NoteTagTable::setup_instance(g.preferences());
+      addin_manager.add_note_addin_info("test", &module);
+      note = gnote::Note::create_new_note("Note", Glib::build_filename(test::make_temp_dir(), "note.note"), manager, g);
+      addin_manager.load_addins_for_note(*note);
+    }
+
+    TestNoteAddin *test_addin()
+    {
+      for(auto addin : addin_manager.get_note_addins(*note)) {
+        if(auto test_addin = dynamic_cast<TestNoteAddin*>(addin)) {
+          return test_addin;
+        }
+      }
+      return nullptr;
+    }
+
+    std::size_t preference_handlers()
+    {
+      return g.preferences().signal_enable_spellchecking_changed.size();
+    }
+  };
+
+  TEST_FIXTURE(Fixture, reloaded_addins_start_over)
+  {
+    auto handlers = preference_handlers();
+    auto opened_handlers = note->signal_opened().size();
+    auto addin = test_addin();
+    REQUIRE CHECK(addin != nullptr);
+    CHECK_EQUAL(1, TestNoteAddin::s_instances);
+    CHECK_EQUAL(1, TestNoteAddin::s_initialized);
+
+    // opening note, the window is not available in tests
+    addin->on_note_opened();
+    CHECK(addin->attached());
+    CHECK_EQUAL(handlers + 1, preference_handlers());
+
+    // releasing buffer of the note with closed window
+    addin_manager.unload_addins_for_note(*note);
+    CHECK(addin_manager.get_note_addins(*note).empty());
+    CHECK_EQUAL(1, TestNoteAddin::s_shut_down);
+    CHECK_EQUAL(0, TestNoteAddin::s_instances);
+    CHECK_EQUAL(handlers, preference_handlers());
+    CHECK_EQUAL(0, note->signal_opened().size());
+    addin_manager.load_addins_for_note(*note);
+    CHECK_EQUAL(opened_handlers, note->signal_opened().size());
+
+    // opening again
+    addin = test_addin();
+    REQUIRE CHECK(addin != nullptr);
+    CHECK_EQUAL(1, TestNoteAddin::s_instances);
+    CHECK_EQUAL(2, TestNoteAddin::s_initialized);
+    CHECK(!addin->attached());
+    addin->on_note_opened();
+    CHECK(addin->attached());
+    CHECK_EQUAL(handlers + 1, preference_handlers());
+  }
+
+  TEST_FIXTURE(Fixture, release_without_window_keeps_addins)
+  {
+    auto addin = test_addin();
+    note->get_buffer();
+    CHECK(note->has_buffer());
+    CHECK(note->release_buffer());
+    CHECK(!note->has_buffer());
+    CHECK_EQUAL(addin, test_addin());
+    CHECK_EQUAL(1, TestNoteAddin::s_instances);
+    CHECK_EQUAL(0, TestNoteAddin::s_shut_down);
+  }
+}
@@ -0,0 +1,172 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+
+#include <UnitTest++/UnitTest++.h>
+#include <glib.h>
+
+#include "autolinker.hpp"
+#include "test/testgnote.hpp"
+#include "test/testnotemanager.hpp"
+
+
+SUITE(AutoLinker)
+{
+  struct TitlesFixture
+  {
+    gnote::AutoLinker::TitleTrie titles;
+
+    TitlesFixture()
+      : titles(false)
+    {
+      titles.add_keyword("Target", "note://target");
+      titles.add_keyword("A & B", "note://ab");
+      titles.add_keyword("Two words", "note://two");
+      titles.compute_failure_graph();
+    }
+
+    Glib::ustring link(const Glib::ustring & body, const Glib::ustring & uri = "note://self")
+    {
+      Glib::ustring xml = "<note-content version=\"0.1\">Title\n\n" + body + "</note-content>";
+      if(!gnote::AutoLinker::link_titles(xml, titles, uri)) {
+        return "unchanged";
+      }
+      return xml.substr(35, xml.size() - 35 - 15);
+    }
+  };
+
+  struct Fixture
+  {
+    test::Gnote g;
+    test::NoteManager manager;
+
+    Fixture()
+      : manager(test::NoteManager::test_notes_dir(), g)
+    {
+      g.notebook_manager(&manager.notebook_manager());
+    }
+
+    gnote::NoteBase & create(const Glib::ustring & title, const Glib::ustring & body)
+    {
+      return manager.create(Glib::ustring(title), Glib::ustring::compose("<note-content>%1\n\n%2</note-content>", title, body));
+    }
+
+    void wait(gnote::AutoLinker & linker)
+    {
+      while(linker.is_running()) {
+        g_main_context_iteration(nullptr, TRUE);
+      }
+    }
+  };
+
+
+  TEST_FIXTURE(TitlesFixture, link_titles)
+  {
+    CHECK_EQUAL("see <link:internal>target</link:internal> here", link("see target here"));
+    CHECK_EQUAL("<link:internal>TARGET</link:internal>, <link:internal>Target</link:internal>", link("TARGET, Target"));
+    CHECK_EQUAL("<link:internal>two words</link:internal> and <link:internal>A &amp; B</link:internal>", link("two words and A &amp; B"));
+    CHECK_EQUAL("<bold><link:internal>target</link:internal></bold>", link("<bold>target</bold>"));
+    CHECK_EQUAL("<list><list-item dir=\"ltr\"><link:internal>target</link:internal>\n</list-item></list>",
+                link("<list><list-item dir=\"ltr\">target\n</list-item></list>"));
+  }
+
+  TEST_FIXTURE(TitlesFixture, link_titles_skips)
+  {
+    // parts of words
+    CHECK_EQUAL("unchanged", link("targets and subtarget"));
+    CHECK_EQUAL("unchanged", link("x<bold>target</bold>"));
+    CHECK_EQUAL("unchanged", link("<bold>target</bold>s"));
+    // existing links
+    CHECK_EQUAL("unchanged", link("<link:internal>target</link:internal>"));
+    CHECK_EQUAL("unchanged", link("<link:url>http://x.org/ target</link:url>"));
+    CHECK_EQUAL("unchanged", link("<link:broken>Target</link:broken>"));
+    // links to itself
+    CHECK_EQUAL("unchanged", link("target", "note://target"));
+    CHECK_EQUAL("unchanged", link("no titles &lt;here&gt;"));
+  }
+
+  TEST_FIXTURE(Fixture, links_closed_notes)
+  {
+    auto & source = create("Source", "mentions the target note");
+    auto & other = create("Other", "nothing to link");
+    auto & target = create("Target", "text");
+    auto other_xml = other.xml_content();
+
+    std::vector<Glib::ustring> handled;
+    gnote::AutoLinker linker(manager, [&handled](gnote::NoteBase & note) {
+      handled.push_back(note.uri());
+      return false;
+    });
+    linker.link({target.uri()});
+    wait(linker);
+
+    CHECK_EQUAL("<note-content>Source\n\nmentions the <link:internal>target</link:internal> note</note-content>",
+                source.xml_content());
+    CHECK_EQUAL("<note-content>Target\n\ntext</note-content>", target.xml_content());
+    CHECK_EQUAL(other_xml, other.xml_content());
+    // notes without the title words are not looked at
+    CHECK(std::find(handled.begin(), handled.end(), other.uri()) == handled.end());
+    CHECK(std::find(handled.begin(), handled.end(), source.uri()) != handled.end());
+  }
+
+  TEST_FIXTURE(Fixture, buffer_handler_takes_note)
+  {
+    auto & source = create("Source", "mentions the target note");
+    auto source_xml = source.xml_content();
+    auto & target = create("Target", "text");
+
+    gnote::AutoLinker linker(manager, [&source](gnote::NoteBase & note) {
+      return &note == &source;
+    });
+    linker.link({target.uri()});
+    wait(linker);
+    CHECK_EQUAL(source_xml, source.xml_content());
+  }
+
+  TEST_FIXTURE(Fixture, renamed_title_linked)
+  {
+    auto & source = create("Source", "mentions the new name");
+    auto & target = create("Target", "text");
+
+    gnote::AutoLinker linker(manager, [](gnote::NoteBase &) { return false; });
+    target.set_title("New name");
+    linker.link({target.uri()});
+    wait(linker);
+    CHECK_EQUAL("<note-content>Source\n\nmentions the <link:internal>new name</link:internal></note-content>",
+                source.xml_content());
+  }
+
+  TEST_FIXTURE(Fixture, cancel)
+  {
+    create("Source", "mentions the target note");
+    auto & target = create("Target", "text");
+
+    gnote::AutoLinker linker(manager, [](gnote::NoteBase &) { return false; });
+    linker.link({target.uri()});
+    linker.cancel();
+    CHECK(!linker.is_running());
+    // results of cancelled pass are dropped
+    while(g_main_context_iteration(nullptr, FALSE)) {
+    }
+    CHECK(!linker.is_running());
+  }
+}
+
@@ -128,5 +128,36 @@ SUITE(FileSystemSyncServerTests)
       // expected
     }
   }
-}
 
+  TEST_FIXTURE(FixtureValidManifest, updates_available_since_without_stamp)
+  {
+    gnote::sync::FileSystemSyncServer probe(Gio::File::create_for_path(sync_path), "probe");
+    CHECK(probe.updates_available_since(1));
+    CHECK(!probe.updates_available_since(2));
+  }
+
+  TEST_FIXTURE(FixtureValidManifest, commit_writes_revision_stamp)
+  {
+    server.upload_notebooks({});
+    CHECK(server.commit_sync_transaction());
+    auto stamp = Glib::build_filename(sync_path, gnote::sync::FileSystemSyncServer::REVISION_STAMP);
+    CHECK_EQUAL("3\n", sharp::file_read_all_text(stamp));
+
+    // stamp is read instead of the manifest
+    sharp::file_write_all_text(stamp, "7\n");
+    gnote::sync::FileSystemSyncServer probe(Gio::File::create_for_path(sync_path), "probe");
+    CHECK(probe.updates_available_since(6));
+    CHECK(!probe.updates_available_since(7));
+  }
+
+  TEST_FIXTURE(FixtureValidManifest, stale_revision_stamp_is_ignored)
+  {
+    auto stamp = Gio::File::create_for_path(Glib::build_filename(sync_path, gnote::sync::FileSystemSyncServer::REVISION_STAMP));
+    sharp::file_write_all_text(stamp->get_path(), "1\n");
+    // manifest written later by a client, that doesn't update the stamp
+    stamp->set_attribute_uint64(G_FILE_ATTRIBUTE_TIME_MODIFIED, Glib::DateTime::create_now_utc().to_unix() - 3600, Gio::FileQueryInfoFlags::NONE);
+    gnote::sync::FileSystemSyncServer probe(Gio::File::create_for_path(sync_path), "probe");
+    CHECK(probe.updates_available_since(1));
+    CHECK(!probe.updates_available_since(2));
+  }
+}
@@ -18,6 +18,7 @@
  */
 
 
+#include <map>
 #include <queue>
 #include <thread>
 
@@ -28,6 +29,7 @@
 #include "synchronization/gvfstransfer.hpp"
 
 using TransferResult = gnote::sync::TransferResult;
+using namespace std::chrono_literals;
 
 
 SUITE(GvfsTransferTests)
@@ -250,6 +252,212 @@ SUITE(GvfsTransferTests)
     CHECK(TransferResult::SUCCESS == transfers[3].result);
     CHECK_EQUAL(MAX_TRANSFERS, TestLimiterFixed::s_max);
   }
+
+
+  // transfer, that completes after given latency and fails given number of times first
+  struct TransferProfile
+  {
+    std::chrono::milliseconds latency;
+    unsigned failures;
+  };
+
+  struct ProfiledTransfer
+  {
+    typedef std::function<void(std::chrono::milliseconds, std::function<void()>)> Scheduler;
+
+    ProfiledTransfer(const Scheduler &schedule, const TransferProfile &profile)
+      : result(TransferResult::NOT_STARTED)
+      , attempts(0)
+      , schedule(schedule)
+      , profile(profile)
+    {
+    }
+
+    void transfer_async(const std::function<void(TransferResult)> &completion, const Glib::RefPtr<Gio::Cancellable>&) const
+    {
+      auto res = ++attempts > profile.failures ? TransferResult::SUCCESS : TransferResult::FAILURE;
+      schedule(profile.latency, [completion, res] { completion(res); });
+    }
+
+    mutable TransferResult result;
+    mutable unsigned attempts;
+    Scheduler schedule;
+    TransferProfile profile;
+  };
+
+  template <typename LimiterT = gnote::sync::TransferLimiterNoLimit>
+  struct ProfiledGvfsTransfer : gnote::sync::GvfsTransfer<std::vector<ProfiledTransfer>, ProfiledTransfer, LimiterT>
+  {
+    template <typename... LimiterArgs>
+    explicit ProfiledGvfsTransfer(const std::vector<ProfiledTransfer> &transfers, const LimiterArgs... args)
+      : gnote::sync::GvfsTransfer<std::vector<ProfiledTransfer>, ProfiledTransfer, LimiterT>(transfers, args...)
+    {}
+
+    using gnote::sync::GvfsTransfer<std::vector<ProfiledTransfer>, ProfiledTransfer, LimiterT>::m_limiter;
+  };
+
+  struct ProfileFixture
+  {
+    std::mutex lock;
+    std::condition_variable cond;
+    std::multimap<std::chrono::steady_clock::time_point, std::function<void()>> pending;
+    std::size_t max_in_flight = 0;
+    bool transfers_complete = false;
+    ProfiledTransfer::Scheduler scheduler;
+
+    ProfileFixture()
+      : scheduler([this](std::chrono::milliseconds latency, std::function<void()> completion) { schedule(latency, completion); })
+    {
+    }
+
+    void schedule(std::chrono::milliseconds latency, std::function<void()> completion)
+    {
+      std::unique_lock guard(lock);
+      pending.emplace(std::chrono::steady_clock::now() + latency, completion);
+      max_in_flight = std::max(max_in_flight, pending.size());
+      cond.notify_one();
+    }
+
+    std::vector<ProfiledTransfer> make_transfers(unsigned count, const TransferProfile &profile)
+    {
+      std::vector<ProfiledTransfer> transfers;
+      for(unsigned i = 0; i < count; ++i) {
+        transfers.emplace_back(scheduler, profile);
+      }
+      return transfers;
+    }
+
+    // completes transfers in order of their due time, returns failures
+    template <typename LimiterT>
+    unsigned perform_transfers(ProfiledGvfsTransfer<LimiterT> &transfer)
+    {
+      unsigned failures = 0;
+      std::thread tfer_thread([this, &transfer, &failures] {
+        failures = transfer.transfer();
+        std::unique_lock guard(lock);
+        transfers_complete = true;
+        cond.notify_one();
+      });
+
+      while(true) {
+        std::function<void()> func;
+        {
+          std::unique_lock guard(lock);
+          while(!transfers_complete && (pending.empty() || pending.begin()->first > std::chrono::steady_clock::now())) {
+            if(pending.empty()) {
+              cond.wait(guard);
+            }
+            else {
+              cond.wait_until(guard, pending.begin()->first);
+            }
+          }
+          if(transfers_complete) {
+            break;
+          }
+          func = pending.begin()->second;
+          pending.erase(pending.begin());
+        }
+        func();
+      }
+
+      tfer_thread.join();
+      return failures;
+    }
+  };
+
+
+  TEST_FIXTURE(ProfileFixture, failed_transfer_is_retried_with_backoff)
+  {
+    auto transfers = make_transfers(1, TransferProfile{0ms, 2});
+    transfers.emplace_back(scheduler, TransferProfile{0ms, 0});
+    ProfiledGvfsTransfer transfer(transfers);
+    transfer.retry_backoff(20ms);
+
+    auto start = std::chrono::steady_clock::now();
+    CHECK_EQUAL(0, perform_transfers(transfer));
+    CHECK(std::chrono::steady_clock::now() - start >= 60ms);
+    CHECK(TransferResult::SUCCESS == transfers[0].result);
+    CHECK_EQUAL(3, transfers[0].attempts);
+    // only the failed one is retried
+    CHECK_EQUAL(1, transfers[1].attempts);
+  }
+
+  TEST_FIXTURE(ProfileFixture, transfer_gives_up_after_max_attempts)
+  {
+    auto transfers = make_transfers(3, TransferProfile{1ms, 0});
+    transfers.emplace_back(scheduler, TransferProfile{1ms, 100});
+    ProfiledGvfsTransfer transfer(transfers);
+    transfer.retry_backoff(1ms);
+
+    CHECK_EQUAL(1, perform_transfers(transfer));
+    CHECK(TransferResult::FAILURE == transfers[3].result);
+    CHECK_EQUAL(gnote::sync::GvfsTransferBase::MAX_ATTEMPTS, transfers[3].attempts);
+    for(unsigned i = 0; i < 3; ++i) {
+      CHECK(TransferResult::SUCCESS == transfers[i].result);
+    }
+  }
+
+  TEST_FIXTURE(ProfileFixture, adaptive_limit_grows_on_fast_server)
+  {
+    const unsigned MAX_TRANSFERS = 8;
+    auto transfers = make_transfers(60, TransferProfile{2ms, 0});
+    ProfiledGvfsTransfer<gnote::sync::TransferLimiterAdaptive> transfer(transfers, MAX_TRANSFERS);
+
+    CHECK_EQUAL(0, perform_transfers(transfer));
+    CHECK_EQUAL(MAX_TRANSFERS, transfer.m_limiter.limit());
+    CHECK(max_in_flight > 2);
+    CHECK(max_in_flight <= MAX_TRANSFERS);
+  }
+
+  TEST_FIXTURE(ProfileFixture, adaptive_limit_shrinks_on_flaky_server)
+  {
+    const unsigned MAX_TRANSFERS = 8;
+    auto transfers = make_transfers(8, TransferProfile{1ms, 1});
+    ProfiledGvfsTransfer<gnote::sync::TransferLimiterAdaptive> transfer(transfers, MAX_TRANSFERS, MAX_TRANSFERS);
+    transfer.retry_backoff(1ms);
+
+    CHECK_EQUAL(0, perform_transfers(transfer));
+    CHECK(transfer.m_limiter.limit() < MAX_TRANSFERS);
+    for(const auto & tfer : transfers) {
+      CHECK(TransferResult::SUCCESS == tfer.result);
+    }
+  }
+
+  TEST(adaptive_limiter_decreases_once_per_window)
+  {
+    gnote::sync::TransferLimiterAdaptive limiter(16, 8);
+    limiter.completed(TransferResult::FAILURE, 1000us);
+    CHECK_EQUAL(4, limiter.limit());
+    // transfers, that were running already
+    for(int i = 0; i < 3; ++i) {
+      limiter.completed(TransferResult::FAILURE, 1000us);
+    }
+    CHECK_EQUAL(4, limiter.limit());
+    limiter.completed(TransferResult::FAILURE, 1000us);
+    CHECK_EQUAL(2, limiter.limit());
+  }
+
+  TEST(adaptive_limiter_decreases_on_latency_growth)
+  {
+    gnote::sync::TransferLimiterAdaptive limiter(16, 8);
+    limiter.completed(TransferResult::SUCCESS, 10000us);
+    CHECK_EQUAL(8, limiter.limit());
+    limiter.completed(TransferResult::SUCCESS, 500000us);
+    CHECK_EQUAL(4, limiter.limit());
+  }
+
+  TEST(adaptive_limiter_stays_within_bounds)
+  {
+    gnote::sync::TransferLimiterAdaptive limiter(3);
+    for(int i = 0; i < 100; ++i) {
+      limiter.completed(TransferResult::SUCCESS, 1000us);
+    }
+    CHECK_EQUAL(3, limiter.limit());
+    for(int i = 0; i < 100; ++i) {
+      limiter.completed(TransferResult::FAILURE, 1000us);
+    }
+    CHECK_EQUAL(1, limiter.limit());
+  }
 }
 
 unsigned SuiteGvfsTransferTests::TestLimiterFixed::s_max = 0;
@@ -0,0 +1,121 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <UnitTest++/UnitTest++.h>
+
+#include "linkindex.hpp"
+#include "test/testgnote.hpp"
+#include "test/testnotemanager.hpp"
+
+
+SUITE(LinkIndex)
+{
+  struct Fixture
+  {
+    test::Gnote g;
+    test::NoteManager manager;
+
+    Fixture()
+      : manager(test::NoteManager::test_notes_dir(), g)
+    {
+      g.notebook_manager(&manager.notebook_manager());
+    }
+
+    gnote::NoteBase & create(const Glib::ustring & title, const Glib::ustring & body)
+    {
+      return manager.create(Glib::ustring(title), Glib::ustring::compose("<note-content><note-title>%1</note-title>\n\n%2</note-content>", title, body));
+    }
+  };
+
+
+  TEST(extract_links)
+  {
+    auto links = gnote::LinkIndex::extract_links("<note-content>a <link:internal>First</link:internal> b "
+      "<link:internal>A &amp; B</link:internal> <link:url>http://x</link:url> <link:internal>First</link:internal>"
+      " <link:internal>unterminated</note-content>");
+    CHECK_EQUAL(2, links.size());
+    CHECK(links.count("First") == 1);
+    CHECK(links.count("A &amp; B") == 1);
+  }
+
+  TEST_FIXTURE(Fixture, linking_notes)
+  {
+    auto & target = create("Target & co", "text");
+    auto & source1 = create("Source 1", "see <link:internal>Target &amp; co</link:internal>");
+    create("Source 2", "no links");
+    // link to itself is not reported
+    auto & self = create("Self", "<link:internal>Self</link:internal>");
+
+    auto linking = manager.get_notes_linking_to(target.get_title());
+    REQUIRE CHECK_EQUAL(1, linking.size());
+    CHECK_EQUAL(&source1, &linking[0].get());
+    CHECK(manager.get_notes_linking_to(self.get_title()).empty());
+    CHECK_EQUAL(1, manager.link_index().links(source1.uri()).size());
+  }
+
+  TEST_FIXTURE(Fixture, updated_on_save)
+  {
+    create("Target", "text");
+    auto & source = create("Source", "no links yet");
+    CHECK(manager.get_notes_linking_to("Target").empty());
+
+    source.set_xml_content("<note-content><note-title>Source</note-title>\n\n<link:internal>Target</link:internal></note-content>");
+    source.save();
+    CHECK_EQUAL(1, manager.get_notes_linking_to("Target").size());
+
+    source.set_xml_content("<note-content><note-title>Source</note-title>\n\nlink removed</note-content>");
+    source.save();
+    CHECK(manager.get_notes_linking_to("Target").empty());
+    CHECK(manager.link_index().links(source.uri()).empty());
+  }
+
+  TEST_FIXTURE(Fixture, invalidated_note_rescanned)
+  {
+    create("Target", "text");
+    auto & source = create("Source", "no links yet");
+    CHECK(manager.get_notes_linking_to("Target").empty());
+
+    // edited, but not saved yet
+    source.data().text() = "<note-content><note-title>Source</note-title>\n\n<link:internal>Target</link:internal></note-content>";
+    CHECK(manager.get_notes_linking_to("Target").empty());
+    manager.link_index().invalidate(source);
+    CHECK_EQUAL(1, manager.get_notes_linking_to("Target").size());
+    CHECK_EQUAL(1, manager.link_index().links(source.uri()).size());
+  }
+
+  TEST_FIXTURE(Fixture, updated_on_delete)
+  {
+    create("Target", "text");
+    auto & source = create("Source", "<link:internal>Target</link:internal>");
+    CHECK_EQUAL(1, manager.get_notes_linking_to("Target").size());
+
+    manager.delete_note(source);
+    CHECK(manager.get_notes_linking_to("Target").empty());
+  }
+
+  TEST_FIXTURE(Fixture, built_on_first_use)
+  {
+    create("Target", "text");
+    create("Source", "<link:internal>Target</link:internal>");
+    CHECK(!manager.link_index().is_built());
+    CHECK_EQUAL(1, manager.get_notes_linking_to("Target").size());
+    CHECK(manager.link_index().is_built());
+  }
+}
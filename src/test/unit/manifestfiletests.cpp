@@ -109,5 +109,74 @@ SUITE(ManifestFile)
     auto revision = manifest.revision();
     CHECK_EQUAL(3, revision);
   }
-}
 
+  TEST(notes_indexed_by_id)
+  {
+    gnote::sync::ManifestFile manifest(Glib::ustring{TEST_MANIFEST_CONTENT});
+    REQUIRE CHECK(manifest.load());
+    CHECK_EQUAL(3, manifest.notes().size());
+    auto note = manifest.find_note("0ead2704-4c24-4110-b7da-22d00cae25f3");
+    REQUIRE CHECK(note != nullptr);
+    CHECK_EQUAL(2, note->rev);
+    CHECK(!note->pack);
+    CHECK(manifest.find_note("missing") == nullptr);
+  }
+
+  TEST(notes_since_ordered_by_revision)
+  {
+    gnote::sync::ManifestFile manifest(Glib::ustring{TEST_MANIFEST_CONTENT});
+    REQUIRE CHECK(manifest.load());
+    auto notes = manifest.notes_since(-1);
+    REQUIRE CHECK_EQUAL(3, notes.size());
+    CHECK_EQUAL("1006a78a-6e61-4492-b5cc-a42f62d0a9ef", notes[0]->id);
+    CHECK_EQUAL("064e27ed-eaf3-4769-9084-0fa925a5cf11", notes[1]->id);
+    CHECK_EQUAL("0ead2704-4c24-4110-b7da-22d00cae25f3", notes[2]->id);
+
+    notes = manifest.notes_since(0);
+    REQUIRE CHECK_EQUAL(2, notes.size());
+    CHECK_EQUAL(1, notes[0]->rev);
+    CHECK_EQUAL(2, notes[1]->rev);
+    CHECK_EQUAL(0, manifest.notes_since(2).size());
+  }
+
+  TEST(writer_output_loads)
+  {
+    gnote::sync::ManifestWriter writer(5, "0cac27e4-cb54-4d9a-aaaa-28a010f213d3");
+    writer.write_note("note1", 3, std::nullopt, "");
+    writer.write_note("note2", 5, gnote::sync::RevisionPackEntry{8, 120}, "abcd");
+
+    gnote::sync::ManifestFile manifest(writer.finish());
+    REQUIRE CHECK(manifest.load());
+    CHECK_EQUAL(5, manifest.revision());
+    CHECK_EQUAL("0cac27e4-cb54-4d9a-aaaa-28a010f213d3", manifest.server_id());
+    REQUIRE CHECK_EQUAL(2, manifest.notes().size());
+    auto note = manifest.find_note("note1");
+    REQUIRE CHECK(note != nullptr);
+    CHECK_EQUAL(3, note->rev);
+    CHECK(!note->pack);
+    CHECK_EQUAL("", note->content_hash);
+    note = manifest.find_note("note2");
+    REQUIRE CHECK(note != nullptr);
+    CHECK_EQUAL(5, note->rev);
+    REQUIRE CHECK(note->pack.has_value());
+    CHECK_EQUAL(8, note->pack->offset);
+    CHECK_EQUAL(120, note->pack->length);
+    CHECK_EQUAL("abcd", note->content_hash);
+  }
+
+  TEST(write_new_reparses_notes)
+  {
+    auto sync_path = Gio::File::create_for_path(test::make_temp_dir());
+    gnote::sync::ManifestFile manifest(sync_path->get_child("manifest.xml"));
+    manifest.write_new(TEST_MANIFEST_CONTENT);
+    CHECK_EQUAL(3, manifest.notes().size());
+
+    gnote::sync::ManifestWriter writer(3, "0cac27e4-cb54-4d9a-aaaa-28a010f213d3");
+    writer.write_note("note1", 3, std::nullopt, "");
+    manifest.write_new(writer.finish());
+    CHECK_EQUAL(3, manifest.revision());
+    CHECK_EQUAL(1, manifest.notes().size());
+    CHECK(manifest.find_note("note1") != nullptr);
+    test::remove_dir(sync_path->get_path());
+  }
+}
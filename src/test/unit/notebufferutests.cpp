@@ -0,0 +1,398 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <glibmm/miscutils.h>
+#include <UnitTest++/UnitTest++.h>
+
+#include "note.hpp"
+#include "notebuffer.hpp"
+#include "notemanager.hpp"
+#include "sharp/xmlwriter.hpp"
+#include "test/benchmark/legacyserializer.hpp"
+#include "test/testgnote.hpp"
+#include "test/testutils.hpp"
+
+
+SUITE(NoteBufferXmlCache)
+{
+  struct Fixture
+  {
+    Glib::RefPtr<Gtk::TextBuffer> buffer;
+    gnote::NoteTag::Ptr bold;
+    gnote::NoteTag::Ptr italic;
+    gnote::DepthNoteTag::Ptr depth;
+
+    Fixture()
+    {
+      auto table = Gtk::TextTagTable::create();
+      bold = gnote::NoteTag::create("bold", gnote::NoteTag::CAN_UNDO);
+      italic = gnote::NoteTag::create("italic", gnote::NoteTag::CAN_UNDO);
+      depth = Glib::make_refptr_for_instance(new gnote::DepthNoteTag(0));
+      table->add(bold);
+      table->add(italic);
+      table->add(depth);
+      buffer = Gtk::TextBuffer::create(table);
+
+      // plain, bold and list lines
+      for(int i = 0; i < 100; ++i) {
+        auto text = Glib::ustring::compose("Line %1 with <markup> & text\n", i);
+        if(i % 10 == 5 || i % 10 == 6) {
+          buffer->insert_with_tag(buffer->end(), "• ", depth);
+          buffer->insert(buffer->end(), text);
+        }
+        else if(i % 7 == 3) {
+          buffer->insert_with_tag(buffer->end(), text, bold);
+        }
+        else {
+          buffer->insert(buffer->end(), text);
+        }
+      }
+    }
+
+    Gtk::TextIter line_start(int line)
+    {
+      return buffer->get_iter_at_line(line);
+    }
+
+    Glib::ustring full()
+    {
+      return gnote::NoteBufferArchiver::serialize(buffer);
+    }
+  };
+
+  TEST_FIXTURE(Fixture, same_as_full_serialization)
+  {
+    gnote::NoteBufferXmlCache cache(buffer);
+    CHECK_EQUAL(full(), cache.serialize());
+    CHECK(cache.block_count() > 1);
+    // all blocks reused
+    CHECK_EQUAL(full(), cache.serialize());
+  }
+
+  TEST_FIXTURE(Fixture, edits_update_blocks)
+  {
+    gnote::NoteBufferXmlCache cache(buffer);
+    cache.serialize();
+
+    buffer->insert(line_start(40), "inserted ");
+    CHECK_EQUAL(full(), cache.serialize());
+    buffer->erase(line_start(20), line_start(22));
+    CHECK_EQUAL(full(), cache.serialize());
+    buffer->insert(line_start(30), "two\nlines\n");
+    CHECK_EQUAL(full(), cache.serialize());
+    buffer->insert(buffer->end(), "tail");
+    CHECK_EQUAL(full(), cache.serialize());
+  }
+
+  TEST_FIXTURE(Fixture, tags_across_blocks)
+  {
+    gnote::NoteBufferXmlCache cache(buffer);
+    cache.serialize();
+
+    buffer->apply_tag(italic, line_start(30), line_start(60));
+    CHECK_EQUAL(full(), cache.serialize());
+    buffer->remove_tag(italic, line_start(35), line_start(36));
+    CHECK_EQUAL(full(), cache.serialize());
+    buffer->remove_tag(italic, buffer->begin(), buffer->end());
+    CHECK_EQUAL(full(), cache.serialize());
+  }
+
+  TEST_FIXTURE(Fixture, lines_joining_lists)
+  {
+    gnote::NoteBufferXmlCache cache(buffer);
+    cache.serialize();
+
+    // every line start is a possible block start
+    for(int line = 1; line < 100; line += 9) {
+      buffer->insert_with_tag(line_start(line), "• ", depth);
+      CHECK_EQUAL(full(), cache.serialize());
+    }
+    auto start = line_start(46);
+    buffer->erase(start, line_start(47));
+    CHECK_EQUAL(full(), cache.serialize());
+  }
+
+  TEST_FIXTURE(Fixture, emptied_buffer)
+  {
+    gnote::NoteBufferXmlCache cache(buffer);
+    cache.serialize();
+
+    buffer->set_text("");
+    CHECK_EQUAL(full(), cache.serialize());
+    CHECK_EQUAL(0, cache.block_count());
+    buffer->set_text("new\ntext");
+    CHECK_EQUAL(full(), cache.serialize());
+  }
+}
+
+
+SUITE(NoteBufferArchiver)
+{
+  const char *CONTENT_START = "<note-content version=\"0.1\""
+    " xmlns:link=\"http://beatniksoftware.com/tomboy/link\""
+    " xmlns:size=\"http://beatniksoftware.com/tomboy/size\">";
+
+  struct Fixture
+  {
+    Glib::RefPtr<Gtk::TextBuffer> buffer;
+    std::map<Glib::ustring, Glib::RefPtr<Gtk::TextTag>> tags;
+    std::vector<gnote::DepthNoteTag::Ptr> depth;
+
+    Fixture()
+    {
+      auto table = Gtk::TextTagTable::create();
+      for(const char *name : {"bold", "italic", "strikethrough", "monospace", "size:large", "link:internal", "link:url"}) {
+        auto tag = gnote::NoteTag::create(name, gnote::NoteTag::CAN_UNDO);
+        table->add(tag);
+        tags[name] = tag;
+      }
+      // not saved
+      auto find_match = gnote::NoteTag::create("find-match", 0);
+      find_match->set_can_serialize(false);
+      table->add(find_match);
+      tags["find-match"] = find_match;
+      for(int i = 0; i < 3; ++i) {
+        depth.push_back(Glib::make_refptr_for_instance(new gnote::DepthNoteTag(i)));
+        table->add(depth.back());
+      }
+      buffer = Gtk::TextBuffer::create(table);
+    }
+
+    void apply(const char *tag, int start, int end)
+    {
+      buffer->apply_tag(tags[tag], buffer->get_iter_at_offset(start), buffer->get_iter_at_offset(end));
+    }
+
+    void append(const Glib::ustring & text, const char *tag = nullptr)
+    {
+      if(tag) {
+        buffer->insert_with_tag(buffer->end(), text, tags[tag]);
+      }
+      else {
+        buffer->insert(buffer->end(), text);
+      }
+    }
+
+    void append_item(int level, const Glib::ustring & text)
+    {
+      buffer->insert_with_tag(buffer->end(), "• ", depth[level]);
+      append(text);
+    }
+
+    void check_same_as_legacy()
+    {
+      CHECK_EQUAL(benchmark::legacy_serialize(buffer), gnote::NoteBufferArchiver::serialize(buffer));
+    }
+  };
+
+  TEST_FIXTURE(Fixture, round_trip)
+  {
+    const char *corpus[] = {
+      "",
+      "Title",
+      "Title\n\nPlain text\n",
+      "Escaped &amp; &lt;markup&gt; &quot;quotes&quot; and \ttabs",
+      "Unicode ąčęėįšųūž ☃ text",
+      "<bold>bold</bold> and <italic>italic</italic> text",
+      "Line one\n<bold>across\nlines</bold>\nend",
+      "<size:large>Large</size:large> <link:internal>Other note</link:internal> <link:url>http://example.com</link:url>",
+      "Ends with <monospace>code</monospace>",
+      "<strikethrough>x</strikethrough>y<bold>z</bold>",
+    };
+    for(const char *body : corpus) {
+      Glib::ustring xml = Glib::ustring(CONTENT_START) + body + "</note-content>";
+      buffer->set_text("");
+      gnote::NoteBufferArchiver::deserialize(buffer, xml);
+      Glib::ustring expected = *body ? xml + "\n" : gnote::NoteBufferArchiver::serialize(buffer);
+      CHECK_EQUAL(expected, gnote::NoteBufferArchiver::serialize(buffer));
+      check_same_as_legacy();
+    }
+  }
+
+  TEST_FIXTURE(Fixture, overlapping_tags)
+  {
+    append("Some bold, some italic and some both of them\nand on the next line too");
+    apply("bold", 5, 30);
+    apply("italic", 15, 40);
+    apply("strikethrough", 20, 22);
+    apply("monospace", 44, 60);
+    apply("find-match", 0, 50);
+    check_same_as_legacy();
+  }
+
+  TEST_FIXTURE(Fixture, lists)
+  {
+    append("Title\n\nText before list\n");
+    append_item(0, "first item\n");
+    append_item(1, "nested item\n");
+    append_item(2, "deeper item\n");
+    append_item(0, "back to top\n");
+    append("Text between lists\n");
+    append_item(1, "starts nested\n");
+    append("\n");
+    append_item(0, "after empty line");
+    check_same_as_legacy();
+  }
+
+  TEST_FIXTURE(Fixture, tags_across_list_items)
+  {
+    append("Intro ");
+    int start = buffer->size();
+    append("bold\n");
+    append_item(0, "item one\n");
+    append_item(1, "item two\n");
+    append("after");
+    apply("bold", start, buffer->size() - 2);
+    apply("italic", start + 2, start + 12);
+    check_same_as_legacy();
+  }
+
+  TEST_FIXTURE(Fixture, special_characters)
+  {
+    append("Line\xe2\x80\xa8separator and an ");
+    buffer->create_child_anchor(buffer->end());
+    append(" anchor\r\nwindows line end\n\nand <tags>");
+    apply("bold", 2, 12);
+    check_same_as_legacy();
+  }
+
+  TEST_FIXTURE(Fixture, partial_range)
+  {
+    append("Some bold text\nsecond line");
+    apply("bold", 5, 9);
+    auto start = buffer->get_iter_at_offset(7);
+    auto end = buffer->get_iter_at_offset(20);
+    sharp::XmlWriter xml, legacy_xml;
+    gnote::NoteBufferArchiver::serialize(buffer, start, end, xml);
+    benchmark::legacy_serialize(buffer, start, end, legacy_xml);
+    xml.close();
+    legacy_xml.close();
+    CHECK_EQUAL(legacy_xml.to_string(), xml.to_string());
+  }
+
+  // buffers of a real note, deserialization of lists depends on them
+  struct NoteFixture
+  {
+    test::Gnote g;
+    gnote::NoteManager manager;
+    gnote::Note::Ptr note;
+
+    NoteFixture()
+      : manager(g)
+    {
+      gnote::NoteTagTable::setup_instance(g.preferences());
+      note = gnote::Note::create_new_note("Note", Glib::build_filename(test::make_temp_dir(), "note.note"), manager, g);
+    }
+
+    gnote::NoteBuffer::Ptr create_buffer()
+    {
+      return gnote::NoteBuffer::create(gnote::NoteTagTable::instance(), *note, g.preferences());
+    }
+
+    // non-empty buffer is deserialized node by node
+    gnote::NoteBuffer::Ptr deserialize_by_text_nodes(const Glib::ustring & xml)
+    {
+      auto buffer = create_buffer();
+      buffer->set_text("x");
+      gnote::NoteBufferArchiver::deserialize(buffer, buffer->begin(), xml);
+      auto placeholder = buffer->end();
+      placeholder.backward_char();
+      buffer->erase(placeholder, buffer->end());
+      return buffer;
+    }
+
+    static std::vector<Glib::ustring> tag_names(const Gtk::TextIter & iter)
+    {
+      std::vector<Glib::ustring> names;
+      for(const auto & tag : iter.get_tags()) {
+        names.push_back(tag->property_name().get_value());
+      }
+      std::sort(names.begin(), names.end());
+      return names;
+    }
+
+    static void check_same_tags(const Glib::RefPtr<gnote::NoteBuffer> & expected, const Glib::RefPtr<gnote::NoteBuffer> & actual)
+    {
+      REQUIRE CHECK_EQUAL(expected->get_text(), actual->get_text());
+      for(int line = 0; line < expected->get_line_count(); ++line) {
+        auto expected_depth = gnote::NoteBuffer::find_depth_tag(expected->get_iter_at_line(line));
+        auto actual_depth = gnote::NoteBuffer::find_depth_tag(actual->get_iter_at_line(line));
+        CHECK_EQUAL(expected_depth ? expected_depth->get_depth() : -1, actual_depth ? actual_depth->get_depth() : -1);
+      }
+      for(int offset = 0; offset < expected->size(); ++offset) {
+        CHECK(tag_names(expected->get_iter_at_offset(offset)) == tag_names(actual->get_iter_at_offset(offset)));
+      }
+    }
+  };
+
+  TEST_FIXTURE(NoteFixture, load_same_as_by_text_nodes)
+  {
+    const char *corpus[] = {
+      "Title\n\n<bold>Bold <italic>and italic</italic></bold><italic> text</italic>\n",
+      "<monospace>a</monospace><monospace>b</monospace> <bold></bold>c",
+      "Ąžuolas <size:large>didelis <link:url>http://example.com</link:url></size:large>\n"
+        "<strikethrough>x</strikethrough>",
+      "Text &amp; <bold>tags\nacross <italic>two</italic>\nlines</bold> end",
+      // nested lists with formatting inside of items
+      "Title\n\nBefore\n<list><list-item dir=\"ltr\">first <bold>bold</bold> item\n"
+        "<list><list-item dir=\"ltr\">nested <italic>italic <monospace>code</monospace></italic>\n</list-item>"
+        "<list-item dir=\"ltr\"><strikethrough>struck</strikethrough>\n</list-item></list></list-item>"
+        "<list-item dir=\"ltr\">back to top\n</list-item></list>After list",
+      // double indentation, item containing only a list
+      "<list><list-item dir=\"ltr\"><list><list-item dir=\"ltr\"><list><list-item dir=\"ltr\">"
+        "deep <size:large>large</size:large>\n</list-item></list></list-item></list></list-item>"
+        "<list-item dir=\"ltr\">top\n</list-item></list>",
+      // empty items
+      "Title\n<list><list-item dir=\"ltr\"></list-item><list-item dir=\"ltr\">one\n</list-item>"
+        "<list-item dir=\"ltr\"><bold></bold></list-item><list-item dir=\"ltr\">two</list-item></list>",
+      // formatting across list boundaries
+      "<bold>Intro\n<list><list-item dir=\"ltr\">bold item\n</list-item></list></bold>"
+        "<list><list-item dir=\"ltr\"><italic>ąčę <link:url>http://example.com</link:url></italic>\n"
+        "<list><list-item dir=\"ltr\">Ūnicode ☃\n</list-item></list></list-item></list>end",
+    };
+    for(const char *body : corpus) {
+      Glib::ustring xml = Glib::ustring(CONTENT_START) + body + "</note-content>";
+      auto buffer = create_buffer();
+      unsigned inserts = 0;
+      auto conn = buffer->signal_insert().connect([&inserts](const Gtk::TextIter&, const Glib::ustring&, int) { ++inserts; });
+      gnote::NoteBufferArchiver::deserialize(buffer, xml);
+      conn.disconnect();
+      CHECK_EQUAL(1, inserts);
+
+      auto by_text_nodes = deserialize_by_text_nodes(xml);
+      check_same_tags(by_text_nodes, buffer);
+      auto serialized = gnote::NoteBufferArchiver::serialize(buffer);
+      CHECK_EQUAL(gnote::NoteBufferArchiver::serialize(by_text_nodes), serialized);
+
+      // serialized content loads back the same way
+      auto reloaded = create_buffer();
+      gnote::NoteBufferArchiver::deserialize(reloaded, serialized);
+      check_same_tags(buffer, reloaded);
+      CHECK_EQUAL(serialized, gnote::NoteBufferArchiver::serialize(reloaded));
+      auto reloaded_by_text_nodes = deserialize_by_text_nodes(serialized);
+      check_same_tags(buffer, reloaded_by_text_nodes);
+      CHECK_EQUAL(serialized, gnote::NoteBufferArchiver::serialize(reloaded_by_text_nodes));
+    }
+  }
+}
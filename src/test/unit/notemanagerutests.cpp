@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2017,2019-2020,2023,2025 Aurimas Cernius
+ * Copyright (C) 2017,2019-2020,2023,2025-2026 Aurimas Cernius
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -24,7 +24,9 @@
 
 #include "sharp/directory.hpp"
 #include "test/testgnote.hpp"
+#include "test/testnote.hpp"
 #include "test/testnotemanager.hpp"
+#include "test/testutils.hpp"
 
 
 SUITE(NoteManager)
@@ -221,5 +223,165 @@ SUITE(NoteManager)
       CHECK_EQUAL(Glib::ustring::compose("%1/file%2.txt", dir.c_str(), i), files[j]);
     }
   }
-}
 
+  TEST(load_note_files_parallel)
+  {
+    test::Gnote g;
+    auto serial_dir = Fixture::make_notes_dir();
+    auto parallel_dir = Fixture::make_notes_dir();
+    const unsigned note_count = 500;
+    test::NoteManager serial(serial_dir, g);
+    serial.load_note_files(test::write_test_notes(serial_dir, note_count), true, 1);
+    test::NoteManager parallel(parallel_dir, g);
+    parallel.load_note_files(test::write_test_notes(parallel_dir, note_count), true, 4);
+
+    CHECK_EQUAL(note_count, serial.note_count());
+    CHECK_EQUAL(note_count, parallel.note_count());
+    serial.for_each([&parallel](gnote::NoteBase & note) {
+      auto other = parallel.find_by_uri(note.uri());
+      CHECK(other.has_value());
+      if(!other) {
+        return;
+      }
+      auto & other_note = other.value().get();
+      CHECK_EQUAL(note.get_title(), other_note.get_title());
+      CHECK_EQUAL(note.xml_content(), other_note.xml_content());
+      CHECK(note.change_date().equal(other_note.change_date()));
+      CHECK_EQUAL(note.data().tags().size(), other_note.data().tags().size());
+      for(const auto & tag : note.data().tags()) {
+        CHECK(other_note.data().tags().count(tag) == 1);
+      }
+    });
+  }
+
+  TEST(load_note_files_without_text)
+  {
+    test::Gnote g;
+    auto dir = Fixture::make_notes_dir();
+    test::NoteManager manager(dir, g);
+    manager.load_note_files(test::write_test_notes(dir, 100), false);
+
+    CHECK_EQUAL(100, manager.note_count());
+    auto note = manager.find("Note 10");
+    REQUIRE CHECK(note.has_value());
+    CHECK(note.value().get().xml_content().empty());
+    CHECK_EQUAL(1, note.value().get().data().tags().size());
+  }
+
+  TEST_FIXTURE(Fixture, find_ignores_case)
+  {
+    auto & note = manager.create("Test Note");
+    auto found = manager.find("test NOTE");
+    REQUIRE CHECK(found.has_value());
+    CHECK_EQUAL(&note, &found.value().get());
+    CHECK(manager.find_by_uri(note.uri()).has_value());
+    CHECK(!manager.find("Test Note 2"));
+  }
+
+  TEST_FIXTURE(Fixture, find_after_rename)
+  {
+    auto & note = manager.create("Old title");
+    note.set_title("New title");
+    CHECK(!manager.find("old title"));
+    auto found = manager.find("new title");
+    REQUIRE CHECK(found.has_value());
+    CHECK_EQUAL(&note, &found.value().get());
+
+    // rename signal has new title as old one here
+    note.rename_without_link_update("Newest title");
+    CHECK(!manager.find("New title"));
+    CHECK(manager.find("Newest title").has_value());
+  }
+
+  TEST_FIXTURE(Fixture, find_during_rename)
+  {
+    auto & note = manager.create("Old title");
+    auto & linking = dynamic_cast<test::Note&>(manager.create("Linking",
+      "<note-content><note-title>Linking</note-title>\n\n<link:internal>Old title</link:internal></note-content>"));
+    unsigned link_renames = 0;
+    linking.signal_link_rename.connect([this, &note, &link_renames](const gnote::NoteBase & renamed) {
+      ++link_renames;
+      CHECK_EQUAL(&note, &renamed);
+      // rename signal is not emitted yet
+      CHECK(!manager.find("Old title"));
+      auto found = manager.find("New title");
+      REQUIRE CHECK(found.has_value());
+      CHECK_EQUAL(&note, &found.value().get());
+    });
+    note.set_title("New title", true);
+    CHECK_EQUAL(1, link_renames);
+    CHECK(manager.find("New title").has_value());
+  }
+
+  TEST_FIXTURE(Fixture, find_after_delete)
+  {
+    auto & note = manager.create("Deleted");
+    auto uri = note.uri();
+    manager.delete_note(note);
+    CHECK(!manager.find("Deleted"));
+    CHECK(!manager.find_by_uri(uri));
+
+    // title can be reused
+    auto & other = manager.create("Deleted");
+    CHECK_EQUAL(&other, &manager.find("deleted").value().get());
+  }
+
+  TEST_FIXTURE(Fixture, batch_change_updates_trie_at_end)
+  {
+    manager.create("Existing note");
+    unsigned finished = 0;
+    manager.signal_batch_change_finished.connect([&finished] { ++finished; });
+    {
+      gnote::NoteManagerBase::BatchChange batch(manager);
+      {
+        // nested batch doesn't finish the outer one
+        gnote::NoteManagerBase::BatchChange nested(manager);
+        manager.create("Batch note");
+      }
+      CHECK_EQUAL(0, finished);
+      CHECK(manager.in_batch_change());
+      auto & note = manager.create("Renamed note");
+      note.set_title("Batch renamed");
+      // notes can be found immediately, title matching waits for batch end
+      CHECK(manager.find("batch note").has_value());
+      CHECK(manager.find_trie_matches("a batch note").empty());
+    }
+    CHECK_EQUAL(1, finished);
+    CHECK(!manager.in_batch_change());
+    CHECK_EQUAL(1, manager.find_trie_matches("a batch note").size());
+    CHECK_EQUAL(1, manager.find_trie_matches("batch renamed").size());
+    CHECK(manager.find_trie_matches("renamed note").empty());
+    CHECK_EQUAL(1, manager.find_trie_matches("existing note").size());
+  }
+
+  TEST(find_in_large_store)
+  {
+    test::Gnote g;
+    auto dir = Fixture::make_notes_dir();
+    test::NoteManager manager(dir, g);
+    const unsigned note_count = 2000;
+    manager.load_note_files(test::write_test_notes(dir, note_count), false);
+    CHECK_EQUAL(note_count, manager.note_count());
+
+    unsigned checked = 0;
+    manager.for_each([&manager, &checked](gnote::NoteBase & note) {
+      CHECK_EQUAL(&note, &manager.find(note.get_title().uppercase()).value().get());
+      CHECK_EQUAL(&note, &manager.find_by_uri(note.uri()).value().get());
+      ++checked;
+    });
+    CHECK_EQUAL(note_count, checked);
+    CHECK(!manager.find(Glib::ustring::compose("note %1", note_count)));
+    CHECK(!manager.find_by_uri("note://gnote/missing"));
+
+    // renamed and deleted notes are no longer found by their old keys
+    auto & renamed = manager.find("note 10").value().get();
+    renamed.set_title("Renamed note");
+    CHECK(!manager.find("note 10"));
+    CHECK_EQUAL(&renamed, &manager.find("renamed note").value().get());
+    auto & deleted = manager.find("note 20").value().get();
+    auto uri = deleted.uri();
+    manager.delete_note(deleted);
+    CHECK(!manager.find("note 20"));
+    CHECK(!manager.find_by_uri(uri));
+  }
+}
@@ -0,0 +1,166 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <fstream>
+
+#include <glibmm/miscutils.h>
+#include <UnitTest++/UnitTest++.h>
+
+#include "notesnapshot.hpp"
+#include "test/testgnote.hpp"
+#include "test/testnotemanager.hpp"
+#include "test/testutils.hpp"
+
+
+SUITE(NoteSnapshot)
+{
+  struct Fixture
+  {
+    test::Gnote g;
+    Glib::ustring notes_dir;
+    test::NoteManager manager;
+    std::vector<Glib::ustring> files;
+
+    Fixture()
+      : notes_dir(test::NoteManager::test_notes_dir())
+      , manager(notes_dir, g)
+    {
+      g.notebook_manager(&manager.notebook_manager());
+      files = test::write_test_notes(notes_dir, 20);
+      manager.load_note_files(std::vector<Glib::ustring>(files), false);
+    }
+
+    Glib::ustring snapshot_file() const
+    {
+      return Glib::build_filename(notes_dir, "note-snapshot");
+    }
+
+    gnote::NoteArchiver::ParsedNote parsed(unsigned idx) const
+    {
+      gnote::NoteArchiver::ParsedNote note;
+      note.file = files[idx];
+      return note;
+    }
+  };
+
+
+  TEST_FIXTURE(Fixture, written_on_load)
+  {
+    gnote::NoteSnapshot snapshot(manager);
+    CHECK(snapshot.load(snapshot_file()));
+    CHECK_EQUAL(20, snapshot.size());
+    CHECK(!snapshot.is_modified());
+  }
+
+  TEST_FIXTURE(Fixture, read_matching_stamp)
+  {
+    gnote::NoteSnapshot snapshot(manager);
+    REQUIRE CHECK(snapshot.load(snapshot_file()));
+    auto stamp = gnote::NoteSnapshot::file_stamp(files[10]);
+    REQUIRE CHECK(stamp.has_value());
+
+    auto note = parsed(10);
+    CHECK(snapshot.read(*stamp, note));
+    REQUIRE CHECK(note.data != nullptr);
+    CHECK_EQUAL("Note 10", note.data->title());
+    CHECK(note.data->text().empty());
+    CHECK(!note.has_text);
+    CHECK_EQUAL(450, note.data->width());
+    CHECK_EQUAL(-1, note.data->selection_bound_position());
+    CHECK(note.data->change_date().equal(manager.find("Note 10").value().get().change_date()));
+    REQUIRE CHECK_EQUAL(1, note.tags.size());
+    CHECK_EQUAL("system:notebook:Notebook 3", note.tags[0]);
+  }
+
+  TEST_FIXTURE(Fixture, stale_stamp_not_read)
+  {
+    gnote::NoteSnapshot snapshot(manager);
+    REQUIRE CHECK(snapshot.load(snapshot_file()));
+    auto stamp = gnote::NoteSnapshot::file_stamp(files[3]);
+    REQUIRE CHECK(stamp.has_value());
+
+    stamp->size += 1;
+    auto note = parsed(3);
+    CHECK(!snapshot.read(*stamp, note));
+    CHECK(note.data == nullptr);
+  }
+
+  TEST_FIXTURE(Fixture, corrupt_snapshot_ignored)
+  {
+    {
+      std::ofstream out(snapshot_file(), std::ios::binary | std::ios::trunc);
+      out << "GNOTESNP garbage";
+    }
+    gnote::NoteSnapshot snapshot(manager);
+    CHECK(!snapshot.load(snapshot_file()));
+    CHECK_EQUAL(0, snapshot.size());
+
+    // loading falls back to parsing the files and rewrites the snapshot
+    test::NoteManager manager2(notes_dir, g);
+    manager2.load_note_files(std::vector<Glib::ustring>(files), false);
+    CHECK_EQUAL(20, manager2.note_count());
+    CHECK(snapshot.load(snapshot_file()));
+    CHECK_EQUAL(20, snapshot.size());
+  }
+
+  TEST_FIXTURE(Fixture, load_from_snapshot)
+  {
+    // change one note, so that it is parsed again
+    {
+      std::ofstream out(files[5], std::ios::app);
+      out << "\n";
+    }
+
+    test::NoteManager manager2(notes_dir, g);
+    manager2.load_note_files(std::vector<Glib::ustring>(files), false);
+    CHECK_EQUAL(manager.note_count(), manager2.note_count());
+    manager.for_each([&manager2](gnote::NoteBase & note) {
+      auto other = manager2.find_by_uri(note.uri());
+      CHECK(other.has_value());
+      if(!other) {
+        return;
+      }
+      auto & other_note = other.value().get();
+      CHECK_EQUAL(note.get_title(), other_note.get_title());
+      CHECK(note.change_date().equal(other_note.change_date()));
+      CHECK(note.create_date().equal(other_note.create_date()));
+      CHECK_EQUAL(note.data().tags().size(), other_note.data().tags().size());
+      for(const auto & tag : note.data().tags()) {
+        CHECK(other_note.data().tags().count(tag) == 1);
+      }
+    });
+  }
+
+  TEST_FIXTURE(Fixture, removed_files_dropped)
+  {
+    gnote::NoteSnapshot snapshot(manager);
+    REQUIRE CHECK(snapshot.load(snapshot_file()));
+    snapshot.retain(std::vector<Glib::ustring>(files.begin(), files.begin() + 5));
+    CHECK_EQUAL(5, snapshot.size());
+    CHECK(snapshot.is_modified());
+
+    snapshot.save(snapshot_file());
+    CHECK(!snapshot.is_modified());
+    gnote::NoteSnapshot snapshot2(manager);
+    CHECK(snapshot2.load(snapshot_file()));
+    CHECK_EQUAL(5, snapshot2.size());
+  }
+}
+
@@ -0,0 +1,132 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <UnitTest++/UnitTest++.h>
+
+#include "notebase.hpp"
+#include "test/testgnote.hpp"
+#include "test/testnotemanager.hpp"
+
+
+SUITE(NoteTextCache)
+{
+  struct Fixture
+  {
+    test::Gnote g;
+    test::NoteManager manager;
+    std::vector<Glib::ustring> files;
+
+    Fixture()
+      : manager(test::NoteManager::test_notes_dir(), g)
+    {
+      g.notebook_manager(&manager.notebook_manager());
+      for(int i = 1; i <= 3; ++i) {
+        Glib::ustring title = Glib::ustring::compose("Note %1", i);
+        auto & note = manager.create(Glib::ustring(title), Glib::ustring::compose("<note-content><note-title>%1</note-title>\n\nbody %2</note-content>", title, i));
+        note.save();
+        files.push_back(note.file_path());
+      }
+    }
+
+    std::unique_ptr<gnote::NoteDataBufferSynchronizerBase> lazy_note(const std::shared_ptr<gnote::NoteTextCache> & cache, unsigned idx)
+    {
+      auto data = std::make_unique<gnote::NoteData>(gnote::NoteBase::url_from_path(files[idx]));
+      manager.note_archiver().read_file_header(files[idx], *data);
+      auto note = std::make_unique<gnote::NoteDataBufferSynchronizerBase>(std::move(data));
+      note->set_text_lazy(cache, files[idx]);
+      return note;
+    }
+  };
+
+
+  TEST_FIXTURE(Fixture, read_file_header)
+  {
+    gnote::NoteData data(gnote::NoteBase::url_from_path(files[0]));
+    CHECK(manager.note_archiver().read_file_header(files[0], data));
+    CHECK_EQUAL("Note 1", data.title());
+    CHECK(data.text().empty());
+    CHECK(data.change_date());
+    CHECK(data.create_date());
+  }
+
+  TEST_FIXTURE(Fixture, read_text)
+  {
+    auto text = gnote::NoteArchiver::read_text(files[1]);
+    CHECK_EQUAL("<note-content><note-title>Note 2</note-title>\n\nbody 2</note-content>", text);
+  }
+
+  TEST_FIXTURE(Fixture, text_loaded_on_access)
+  {
+    auto cache = std::make_shared<gnote::NoteTextCache>(2);
+    auto note = lazy_note(cache, 0);
+    CHECK(!note->is_text_loaded());
+    CHECK_EQUAL(0, cache->size());
+
+    CHECK(note->text().find("body 1") != Glib::ustring::npos);
+    CHECK(note->is_text_loaded());
+    CHECK_EQUAL(1, cache->size());
+    CHECK_EQUAL("Note 1", note->data().title());
+  }
+
+  TEST_FIXTURE(Fixture, least_recently_used_evicted)
+  {
+    auto cache = std::make_shared<gnote::NoteTextCache>(2);
+    auto note1 = lazy_note(cache, 0);
+    auto note2 = lazy_note(cache, 1);
+    auto note3 = lazy_note(cache, 2);
+
+    note1->text();
+    note2->text();
+    note1->text();
+    note3->text();
+    CHECK_EQUAL(2, cache->size());
+    CHECK(note1->is_text_loaded());
+    CHECK(!note2->is_text_loaded());
+    CHECK(note3->is_text_loaded());
+
+    // evicted text is read again
+    CHECK(note2->text().find("body 2") != Glib::ustring::npos);
+    CHECK(!note1->is_text_loaded());
+  }
+
+  TEST_FIXTURE(Fixture, modified_text_not_evicted)
+  {
+    auto cache = std::make_shared<gnote::NoteTextCache>(1);
+    auto note1 = lazy_note(cache, 0);
+    auto note2 = lazy_note(cache, 1);
+
+    note1->set_text("<note-content><note-title>Note 1</note-title>\n\nchanged</note-content>");
+    note2->text();
+    CHECK_EQUAL(1, cache->size());
+    CHECK(note1->is_text_loaded());
+    CHECK(note1->text().find("changed") != Glib::ustring::npos);
+  }
+
+  TEST_FIXTURE(Fixture, destroyed_note_removed)
+  {
+    auto cache = std::make_shared<gnote::NoteTextCache>(2);
+    auto note = lazy_note(cache, 0);
+    note->synchronized_data();
+    CHECK_EQUAL(1, cache->size());
+    note.reset();
+    CHECK_EQUAL(0, cache->size());
+  }
+}
+
@@ -0,0 +1,182 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <glibmm/miscutils.h>
+#include <UnitTest++/UnitTest++.h>
+
+#include "notewriter.hpp"
+#include "sharp/directory.hpp"
+#include "sharp/files.hpp"
+#include "test/testnotemanager.hpp"
+#include "test/testutils.hpp"
+
+
+SUITE(NoteWriter)
+{
+  struct Fixture
+  {
+    Glib::ustring dir;
+
+    Fixture()
+      : dir(test::make_temp_dir())
+    {}
+
+    ~Fixture()
+    {
+      test::remove_dir(dir);
+    }
+
+    Glib::ustring file(unsigned idx) const
+    {
+      return Glib::build_filename(dir, Glib::ustring::compose("note%1.note", idx));
+    }
+  };
+
+
+  TEST_FIXTURE(Fixture, flush_writes_files)
+  {
+    gnote::NoteWriter writer;
+    for(unsigned i = 0; i < 10; ++i) {
+      writer.write(file(i), Glib::ustring::compose("content %1", i));
+    }
+    writer.flush();
+
+    for(unsigned i = 0; i < 10; ++i) {
+      CHECK(!writer.is_pending(file(i)));
+      CHECK_EQUAL(Glib::ustring::compose("content %1", i), sharp::file_read_all_text(file(i)));
+    }
+    CHECK_EQUAL(10, writer.written_count());
+    CHECK(writer.batch_count() <= writer.written_count());
+    // no temporary files left
+    CHECK_EQUAL(10, sharp::directory_get_files(dir).size());
+  }
+
+  TEST_FIXTURE(Fixture, latest_content_written)
+  {
+    gnote::NoteWriter writer;
+    for(unsigned i = 0; i < 100; ++i) {
+      writer.write(file(0), Glib::ustring::compose("content %1", i));
+    }
+    writer.flush();
+
+    CHECK_EQUAL("content 99", sharp::file_read_all_text(file(0)));
+    // repeated writes of the same file are coalesced while queued
+    CHECK(writer.written_count() <= 100);
+  }
+
+  TEST_FIXTURE(Fixture, replaces_existing_file)
+  {
+    gnote::NoteWriter writer;
+    writer.write(file(0), "old content");
+    writer.flush();
+    writer.write(file(0), "new content");
+    writer.flush();
+
+    CHECK_EQUAL("new content", sharp::file_read_all_text(file(0)));
+    CHECK_EQUAL(1, sharp::directory_get_files(dir).size());
+  }
+
+  TEST_FIXTURE(Fixture, blocks_when_queue_full)
+  {
+    gnote::NoteWriter writer(2);
+    for(unsigned i = 0; i < 50; ++i) {
+      writer.write(file(i), Glib::ustring::compose("content %1", i));
+    }
+    writer.flush();
+
+    CHECK_EQUAL(50, writer.written_count());
+    for(unsigned i = 0; i < 50; ++i) {
+      CHECK_EQUAL(Glib::ustring::compose("content %1", i), sharp::file_read_all_text(file(i)));
+    }
+  }
+
+  TEST_FIXTURE(Fixture, failure_does_not_block)
+  {
+    gnote::NoteWriter writer;
+    writer.write(Glib::build_filename(dir, "missing", "note.note"), "content");
+    writer.write(file(0), "content");
+    writer.flush();
+
+    CHECK_EQUAL(2, writer.written_count());
+    CHECK_EQUAL("content", sharp::file_read_all_text(file(0)));
+  }
+
+  TEST_FIXTURE(Fixture, destructor_writes_queued)
+  {
+    {
+      gnote::NoteWriter writer;
+      for(unsigned i = 0; i < 20; ++i) {
+        writer.write(file(i), "content");
+      }
+    }
+
+    for(unsigned i = 0; i < 20; ++i) {
+      CHECK(sharp::file_exists(file(i)));
+    }
+  }
+
+  TEST_FIXTURE(Fixture, durability_none_does_not_sync)
+  {
+    gnote::NoteWriter writer;
+    writer.durability(gnote::Durability::NONE);
+    gnote::reset_fsync_stats();
+    for(unsigned i = 0; i < 10; ++i) {
+      writer.write(file(i), "content");
+    }
+    writer.flush();
+
+    CHECK_EQUAL(0, gnote::fsync_stats().count);
+  }
+
+  TEST_FIXTURE(Fixture, durability_file_syncs_every_file)
+  {
+    gnote::NoteWriter writer;
+    writer.durability(gnote::Durability::FILE);
+    gnote::reset_fsync_stats();
+    for(unsigned i = 0; i < 10; ++i) {
+      writer.write(file(i), "content");
+    }
+    writer.flush();
+
+    // file before rename and directory after it
+    auto stats = gnote::fsync_stats();
+    CHECK_EQUAL(20, stats.count);
+    CHECK_EQUAL(0, stats.failures);
+    CHECK(stats.max_usec <= stats.total_usec);
+  }
+
+  TEST_FIXTURE(Fixture, durability_batch_syncs_directory_per_batch)
+  {
+    gnote::NoteWriter writer;
+    writer.durability(gnote::Durability::BATCH);
+    gnote::reset_fsync_stats();
+    for(unsigned i = 0; i < 40; ++i) {
+      writer.write(file(i), "content");
+    }
+    writer.flush();
+
+    // every file before renames and directory once per batch
+    CHECK_EQUAL(40 + writer.batch_count(), gnote::fsync_stats().count);
+    for(unsigned i = 0; i < 40; ++i) {
+      CHECK_EQUAL("content", sharp::file_read_all_text(file(i)));
+      CHECK(!sharp::file_exists(file(i) + ".tmp"));
+    }
+  }
+}
@@ -0,0 +1,95 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <UnitTest++/UnitTest++.h>
+
+#include "synchronization/revisionpack.hpp"
+
+
+SUITE(RevisionPack)
+{
+  const char *NOTE_CONTENT = ""
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+    "<note version=\"0.3\" xmlns:link=\"http://beatniksoftware.com/tomboy/link\">"
+    "<title>Ąžuolas</title><text xml:space=\"preserve\"><note-content version=\"0.1\">Ąžuolas\n\n"
+    "Some text, some text, some text, some text, some text.</note-content></text></note>";
+
+  TEST(round_trip)
+  {
+    gnote::sync::RevisionPackWriter writer;
+    auto entry1 = writer.add("note1", NOTE_CONTENT);
+    auto entry2 = writer.add("note2", "");
+    auto entry3 = writer.add("note3", "short");
+    CHECK_EQUAL(3, writer.size());
+
+    gnote::sync::RevisionPackReader reader(writer.finish());
+    CHECK_EQUAL(NOTE_CONTENT, reader.read(entry1));
+    CHECK_EQUAL("", reader.read(entry2));
+    CHECK_EQUAL("short", reader.read(entry3));
+  }
+
+  TEST(index_matches_entries)
+  {
+    gnote::sync::RevisionPackWriter writer;
+    auto entry = writer.add("note1", NOTE_CONTENT);
+    writer.add("note2", "other");
+
+    gnote::sync::RevisionPackReader reader(writer.finish());
+    CHECK_EQUAL(2, reader.index().size());
+    auto found = reader.find("note1");
+    REQUIRE CHECK(found.has_value());
+    CHECK_EQUAL(entry.offset, found->offset);
+    CHECK_EQUAL(entry.length, found->length);
+    CHECK(!reader.find("note3").has_value());
+  }
+
+  TEST(notes_are_compressed)
+  {
+    Glib::ustring content;
+    for(int i = 0; i < 100; ++i) {
+      content += NOTE_CONTENT;
+    }
+    gnote::sync::RevisionPackWriter writer;
+    auto entry = writer.add("note1", content);
+    CHECK(entry.length < content.bytes() / 10);
+  }
+
+  TEST(truncated_pack_throws)
+  {
+    gnote::sync::RevisionPackWriter writer;
+    writer.add("note1", NOTE_CONTENT);
+    auto data = writer.finish();
+    data.resize(data.size() - 1);
+    CHECK_THROW(gnote::sync::RevisionPackReader(std::move(data)), std::runtime_error);
+    CHECK_THROW(gnote::sync::RevisionPackReader(std::string("GNOTEPCK")), std::runtime_error);
+  }
+
+  TEST(out_of_range_entry_throws)
+  {
+    gnote::sync::RevisionPackWriter writer;
+    auto entry = writer.add("note1", NOTE_CONTENT);
+    gnote::sync::RevisionPackReader reader(writer.finish());
+    entry.length += 1000000;
+    CHECK_THROW(reader.read(entry), std::runtime_error);
+    entry.length = 4;
+    CHECK_THROW(reader.read(entry), std::runtime_error);
+  }
+}
+
@@ -0,0 +1,194 @@
+/*
+ * gnote
+ *
+ * Copyright (C) 2026 Aurimas Cernius
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <glibmm/miscutils.h>
+#include <UnitTest++/UnitTest++.h>
+
+#include "search.hpp"
+#include "searchindex.hpp"
+#include "test/testgnote.hpp"
+#include "test/testnotemanager.hpp"
+
+
+SUITE(SearchIndex)
+{
+  struct Fixture
+  {
+    test::Gnote g;
+    test::NoteManager manager;
+
+    Fixture()
+      : manager(test::NoteManager::test_notes_dir(), g)
+    {
+      g.notebook_manager(&manager.notebook_manager());
+      manager.create("Shopping", "<note-content><note-title>Shopping</note-title>\n\nApples, pears and apples again</note-content>");
+      manager.create("Recipes", "<note-content><note-title>Recipes</note-title>\n\nBake the pears with honey</note-content>");
+      manager.create("Travel", "<note-content><note-title>Travel</note-title>\n\nTrain tickets to Vilnius</note-content>");
+    }
+
+    gnote::Search::Results search_without_index(const Glib::ustring & query, bool case_sensitive)
+    {
+      gnote::Search search(manager);
+      gnote::Search::Results results;
+      std::vector<Glib::ustring> words;
+      gnote::Search::split_watching_quotes(words, case_sensitive ? query : query.lowercase());
+      manager.for_each([&search, &results, &words, case_sensitive](gnote::NoteBase & note) {
+        if(0 < search.find_match_count_in_note(note.get_title(), words, case_sensitive)) {
+          results.insert(std::make_pair(INT_MAX, std::ref(note)));
+        }
+        else if(int count = search.find_match_count_in_note(note.text_content(), words, case_sensitive)) {
+          results.insert(std::make_pair(count, std::ref(note)));
+        }
+      });
+      return results;
+    }
+
+    void check_same_results(const Glib::ustring & query, bool case_sensitive = false)
+    {
+      gnote::Search search(manager);
+      auto indexed = search.search_notes(query, case_sensitive, gnote::notebooks::Notebook::ORef());
+      auto expected = search_without_index(query, case_sensitive);
+      CHECK_EQUAL(expected.size(), indexed.size());
+      for(const auto & result : expected) {
+        bool found = false;
+        auto range = indexed.equal_range(result.first);
+        for(auto iter = range.first; iter != range.second; ++iter) {
+          if(&iter->second.get() == &result.second.get()) {
+            found = true;
+            break;
+          }
+        }
+        CHECK(found);
+      }
+    }
+
+    gnote::SearchIndex::UriSet candidates(const std::vector<Glib::ustring> & words)
+    {
+      auto result = manager.search_index().find_candidates(words);
+      CHECK(result);
+      return result ? *result : gnote::SearchIndex::UriSet();
+    }
+  };
+
+
+  TEST(split_terms)
+  {
+    auto terms = gnote::SearchIndex::split_terms("Hello, World! foo-bar42");
+    CHECK_EQUAL(4, terms.size());
+    CHECK_EQUAL("hello", terms.at(0));
+    CHECK_EQUAL("world", terms.at(1));
+    CHECK_EQUAL("foo", terms.at(2));
+    CHECK_EQUAL("bar42", terms.at(3));
+  }
+
+  TEST(split_terms_unicode)
+  {
+    auto terms = gnote::SearchIndex::split_terms("ŽALIAS šuo ΟΔΟΣ");
+    CHECK_EQUAL(3, terms.size());
+    CHECK_EQUAL("žalias", terms.at(0));
+    CHECK_EQUAL("šuo", terms.at(1));
+    CHECK_EQUAL("οδοσ", terms.at(2));
+  }
+
+  TEST_FIXTURE(Fixture, notes_indexed_when_added)
+  {
+    CHECK_EQUAL(3, manager.search_index().note_count());
+    auto uri = manager.find("Shopping").value().get().uri();
+    CHECK(manager.search_index().is_indexed(uri));
+    CHECK(candidates({"apples"}).count(uri) == 1);
+    CHECK(candidates({"honey"}).count(uri) == 0);
+  }
+
+  TEST_FIXTURE(Fixture, find_candidates)
+  {
+    auto result = candidates({"pear"});
+    CHECK_EQUAL(2, result.size());
+    result = candidates({"pear", "honey"});
+    CHECK_EQUAL(1, result.size());
+    CHECK(result.find(manager.find("Recipes").value().get().uri()) != result.end());
+    result = candidates({"bananas"});
+    CHECK(result.empty());
+    CHECK(!manager.search_index().find_candidates({"!?"}));
+  }
+
+  TEST_FIXTURE(Fixture, find_candidates_by_substring)
+  {
+    // middle of words, via trigrams
+    CHECK_EQUAL(2, candidates({"ear"}).size());
+    CHECK_EQUAL(1, candidates({"ilniu"}).size());
+    CHECK(candidates({"pearsx"}).empty());
+    // too short for trigrams
+    CHECK_EQUAL(2, candidates({"ea"}).size());
+    CHECK_EQUAL(3, candidates({"e"}).size());
+
+    // words removed with the last note having them are no longer found
+    manager.delete_note(manager.find("Travel").value().get());
+    CHECK(candidates({"ilniu"}).empty());
+    manager.create("Trip", "<note-content><note-title>Trip</note-title>\n\nBus to Vilnius</note-content>");
+    CHECK_EQUAL(1, candidates({"ilniu"}).size());
+  }
+
+  TEST_FIXTURE(Fixture, index_follows_save_and_delete)
+  {
+    auto & note = manager.find("Travel").value().get();
+    note.set_xml_content("<note-content><note-title>Travel</note-title>\n\nBus to Kaunas</note-content>");
+    note.queue_save(gnote::CONTENT_CHANGED);
+    CHECK(candidates({"vilnius"}).empty());
+    CHECK_EQUAL(1, candidates({"kaunas"}).size());
+
+    manager.delete_note(note);
+    CHECK_EQUAL(2, manager.search_index().note_count());
+    CHECK(candidates({"kaunas"}).empty());
+  }
+
+  TEST_FIXTURE(Fixture, search_results_unchanged)
+  {
+    check_same_results("pears");
+    check_same_results("APPLES");
+    check_same_results("apples", true);
+    check_same_results("Apples", true);
+    check_same_results("\"pears and\"");
+    check_same_results("ear ill");
+    check_same_results("travel");
+    check_same_results("nothing here");
+    check_same_results(", ");
+  }
+
+  TEST_FIXTURE(Fixture, save_and_load)
+  {
+    auto file = Glib::build_filename(manager.notes_dir(), "search-index");
+    auto & index = manager.search_index();
+    index.save(file);
+    CHECK(!index.is_modified());
+
+    gnote::SearchIndex loaded(manager);
+    CHECK(loaded.load(file));
+    CHECK_EQUAL(3, loaded.note_count());
+    auto uri = manager.find("Shopping").value().get().uri();
+    auto found = loaded.find_candidates({"apples"});
+    REQUIRE CHECK(found.has_value());
+    CHECK(found->count(uri) == 1);
+
+    // nothing changed since save, so nothing to reindex
+    loaded.update();
+    CHECK(!loaded.is_modified());
+  }
+}
+
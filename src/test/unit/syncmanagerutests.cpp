@@ -18,9 +18,11 @@
  */
 
 
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
 
+#include <giomm/file.h>
 #include <glib/gstdio.h>
 #include <glibmm/miscutils.h>
 #include <UnitTest++/UnitTest++.h>
@@ -33,6 +35,7 @@
 #include "testutils.hpp"
 #include "sharp/files.hpp"
 #include "sharp/directory.hpp"
+#include "synchronization/filesystemsyncserver.hpp"
 #include "synchronization/silentui.hpp"
 
 
@@ -65,6 +68,11 @@ SUITE(SyncManagerTests)
       return m_notesdir;
     }
 
+    void pack_revisions(bool pack)
+    {
+      m_sync_manager->pack_revisions(pack);
+    }
+
     void perform_sync()
     {
       auto _ = m_sync_manager->get_client(m_manifest);
@@ -72,6 +80,11 @@ SUITE(SyncManagerTests)
       m_sync_manager->perform_synchronization(ui);
     }
 
+    gnote::sync::SyncStats last_sync_stats() const
+    {
+      return m_sync_manager->last_sync_stats();
+    }
+
     std::vector<gnote::notebooks::INotebook::Ref> get_notebooks()
     {
       std::vector<gnote::notebooks::INotebook::Ref> notebooks;
@@ -323,6 +336,91 @@ SUITE(SyncManagerTests)
     CHECK(find_note_in_files(files, "note4"));
   }
 
+  TEST_FIXTURE(Fixture2, sync_stats)
+  {
+    synchronizer.perform_sync();
+    auto stats = synchronizer.last_sync_stats();
+    CHECK(stats.succeeded());
+    CHECK_EQUAL(3, stats.notes_uploaded);
+    CHECK_EQUAL(0, stats.notes_downloaded);
+    CHECK(stats.bytes_uploaded > 0);
+    CHECK(stats.total_usec() >= stats.phase_usec(gnote::sync::SyncStats::UPLOAD));
+
+    synchronizer2.perform_sync();
+    stats = synchronizer2.last_sync_stats();
+    CHECK(stats.succeeded());
+    CHECK_EQUAL(0, stats.notes_uploaded);
+    CHECK_EQUAL(3, stats.notes_downloaded);
+    CHECK(stats.bytes_downloaded > 0);
+    auto values = stats.to_map();
+    CHECK_EQUAL(3, values["notes-downloaded"]);
+    CHECK(values.find("manifest-load-usec") != values.end());
+  }
+
+  TEST(sync_stats_phases)
+  {
+    gnote::sync::SyncStats stats;
+    stats.start();
+    stats.begin_phase(gnote::sync::SyncStats::LOCK_WAIT);
+    g_usleep(2000);
+    stats.begin_phase(gnote::sync::SyncStats::DOWNLOAD);
+    stats.finish(true);
+
+    auto lock_wait = stats.phase_usec(gnote::sync::SyncStats::LOCK_WAIT);
+    CHECK(lock_wait >= 2000);
+    CHECK(stats.total_usec() >= lock_wait + stats.phase_usec(gnote::sync::SyncStats::DOWNLOAD));
+    stats.move_phase_time(gnote::sync::SyncStats::LOCK_WAIT, gnote::sync::SyncStats::MANIFEST_LOAD, 1000);
+    CHECK_EQUAL(lock_wait - 1000, stats.phase_usec(gnote::sync::SyncStats::LOCK_WAIT));
+    CHECK_EQUAL(1000, stats.phase_usec(gnote::sync::SyncStats::MANIFEST_LOAD));
+    // can't move more, than was measured
+    stats.move_phase_time(gnote::sync::SyncStats::COMMIT, gnote::sync::SyncStats::MANIFEST_LOAD, 1000);
+    CHECK_EQUAL(1000, stats.phase_usec(gnote::sync::SyncStats::MANIFEST_LOAD));
+  }
+
+  TEST_FIXTURE(Fixture2, metadata_change_not_uploaded)
+  {
+    synchronizer.perform_sync();
+
+    // touch note without changing synchronized content
+    auto & note = dynamic_cast<test::Note&>(synchronizer.note_manager().find("note2").value().get());
+    note.set_change_type(gnote::OTHER_DATA_CHANGED);
+    note.save();
+    synchronizer.perform_sync();
+
+    Glib::ustring syncednotesdir = syncdir + "/0";
+    REQUIRE CHECK(sharp::directory_exists(syncednotesdir));
+    CHECK_EQUAL(1, sharp::directory_get_directories(syncednotesdir).size());
+
+    // content change is uploaded
+    update_note(synchronizer.note_manager(), "note2", "note4", "updated content");
+    synchronizer.perform_sync();
+    CHECK_EQUAL(2, sharp::directory_get_directories(syncednotesdir).size());
+  }
+
+  TEST(content_hash)
+  {
+    gnote::NoteData data1("note://gnote/1");
+    data1.title() = "note";
+    data1.text() = "<note-content version=\"0.1\">note\n\ncontent</note-content>";
+    data1.tags().insert("tag1");
+    data1.tags().insert("tag2");
+    gnote::NoteData data2("note://gnote/2");
+    data2.title() = "note";
+    data2.text() = "<note-content>note\n\ncontent</note-content>";
+    data2.tags().insert("tag2");
+    data2.tags().insert("tag1");
+    CHECK_EQUAL(gnote::sync::note_content_hash(data1), gnote::sync::note_content_hash(data2));
+
+    data2.tags().erase("tag2");
+    CHECK(gnote::sync::note_content_hash(data1) != gnote::sync::note_content_hash(data2));
+    data2.tags().insert("tag2");
+    data2.title() = "note2";
+    CHECK(gnote::sync::note_content_hash(data1) != gnote::sync::note_content_hash(data2));
+    data2.title() = "note";
+    data2.text() = "<note-content>note\n\ncontent2</note-content>";
+    CHECK(gnote::sync::note_content_hash(data1) != gnote::sync::note_content_hash(data2));
+  }
+
   TEST_FIXTURE(Fixture2, download_note_update)
   {
     synchronizer.perform_sync();
@@ -360,6 +458,31 @@ SUITE(SyncManagerTests)
     CHECK(!find_note_in_files(files, "note2"));
   }
 
+  TEST(deletion_reconciliation)
+  {
+    const unsigned NOTE_COUNT = 5000;
+    std::vector<Glib::ustring> server_notes, local_notes;
+    for(unsigned i = 0; i < NOTE_COUNT; ++i) {
+      server_notes.push_back(Glib::ustring::compose("note-%1", i));
+      local_notes.push_back(Glib::ustring::compose("note-%1", i + 100));
+    }
+
+    const gnote::sync::NoteIdSet server_ids(server_notes.begin(), server_notes.end());
+    const gnote::sync::NoteIdSet local_ids(local_notes.begin(), local_notes.end());
+    auto deleted_locally = gnote::sync::note_ids_missing_from(server_notes, local_ids);
+    auto deleted_on_server = gnote::sync::note_ids_missing_from(local_notes, server_ids);
+
+    // missing ids keep the order of the source list
+    REQUIRE CHECK_EQUAL(100, deleted_locally.size());
+    CHECK_EQUAL("note-0", deleted_locally.front());
+    CHECK_EQUAL("note-99", deleted_locally.back());
+    REQUIRE CHECK_EQUAL(100, deleted_on_server.size());
+    CHECK_EQUAL("note-5000", deleted_on_server.front());
+    CHECK_EQUAL("note-5099", deleted_on_server.back());
+    CHECK(gnote::sync::note_ids_missing_from(server_notes, server_ids).empty());
+    CHECK_EQUAL(NOTE_COUNT, gnote::sync::note_ids_missing_from(server_notes, gnote::sync::NoteIdSet()).size());
+  }
+
   TEST_FIXTURE(Fixture2, note_modification_conflict)
   {
     synchronizer.perform_sync();
@@ -402,5 +525,184 @@ SUITE(SyncManagerTests)
     CHECK(find_note_in_files(files, "note3"));
     CHECK(!find_note_in_files(files, "note2"));
   }
-}
 
+  TEST_FIXTURE(Fixture2, packed_revisions)
+  {
+    synchronizer.pack_revisions(true);
+    synchronizer.perform_sync();
+
+    Glib::ustring syncednotesdir = syncdir + "/0/0";
+    REQUIRE CHECK(sharp::directory_exists(syncednotesdir));
+    CHECK_EQUAL(0, get_notes_in_dir(syncednotesdir).size());
+    CHECK(sharp::file_exists(Glib::build_filename(syncednotesdir, "notes.pack")));
+
+    synchronizer2.perform_sync();
+    auto files = get_notes_in_dir(synchronizer2.notes_dir());
+    REQUIRE CHECK_EQUAL(3, files.size());
+    CHECK(find_note_in_files(files, "note1"));
+    CHECK(find_note_in_files(files, "note2"));
+    CHECK(find_note_in_files(files, "note3"));
+  }
+
+  TEST_FIXTURE(Fixture2, packed_and_plain_revisions)
+  {
+    synchronizer.perform_sync();
+    synchronizer2.pack_revisions(true);
+    synchronizer2.perform_sync();
+
+    // packed update on top of plain revision
+    update_note(synchronizer2.note_manager(), "note2", "note4", "updated content");
+    create_note(synchronizer2.note_manager(), "note5", "content5");
+    synchronizer2.perform_sync();
+    CHECK(sharp::file_exists(Glib::build_filename(syncdir, "0", "1", "notes.pack")));
+
+    synchronizer.perform_sync();
+    auto files = get_notes_in_dir(synchronizer.notes_dir());
+    REQUIRE CHECK_EQUAL(4, files.size());
+    CHECK(find_note_in_files(files, "note1"));
+    CHECK(find_note_in_files(files, "note3"));
+    CHECK(find_note_in_files(files, "note4"));
+    CHECK(find_note_in_files(files, "note5"));
+    CHECK(!find_note_in_files(files, "note2"));
+
+    // plain update on top of packed revision
+    update_note(synchronizer.note_manager(), "note5", "note6", "content6");
+    synchronizer.perform_sync();
+    synchronizer2.perform_sync();
+    files = get_notes_in_dir(synchronizer2.notes_dir());
+    REQUIRE CHECK_EQUAL(4, files.size());
+    CHECK(find_note_in_files(files, "note6"));
+    CHECK(!find_note_in_files(files, "note5"));
+  }
+
+  TEST_FIXTURE(Fixture2, note_updates_in_batches)
+  {
+    synchronizer.perform_sync();
+    synchronizer2.pack_revisions(true);
+    synchronizer2.perform_sync();
+    update_note(synchronizer2.note_manager(), "note2", "note4", "updated content");
+    create_note(synchronizer2.note_manager(), "note5", "content5");
+    synchronizer2.perform_sync();
+
+    gnote::sync::FileSystemSyncServer server(Gio::File::create_for_path(syncdir), "reader");
+    REQUIRE CHECK(server.begin_sync_transaction());
+    std::vector<std::size_t> batches;
+    std::vector<Glib::ustring> titles;
+    auto consumer = [&batches, &titles](gnote::sync::SyncServer::NoteUpdatesMap && updates) {
+      batches.push_back(updates.size());
+      for(const auto & update : updates) {
+        titles.push_back(update.second.m_title);
+      }
+    };
+    // plain notes first, then packed ones
+    server.get_note_updates_since(-1, 1, consumer);
+    CHECK_EQUAL(4, batches.size());
+    CHECK_EQUAL(1, batches.front());
+    REQUIRE CHECK_EQUAL(4, titles.size());
+    std::sort(titles.begin(), titles.begin() + 2);
+    std::sort(titles.begin() + 2, titles.end());
+    CHECK_EQUAL("note1", titles[0]);
+    CHECK_EQUAL("note3", titles[1]);
+    CHECK_EQUAL("note4", titles[2]);
+    CHECK_EQUAL("note5", titles[3]);
+
+    batches.clear();
+    titles.clear();
+    server.get_note_updates_since(0, 64, consumer);
+    REQUIRE CHECK_EQUAL(1, batches.size());
+    CHECK_EQUAL(2, batches[0]);
+    server.cancel_sync_transaction();
+  }
+
+  TEST_FIXTURE(Fixture2, compaction_removes_superseded_files)
+  {
+    synchronizer.perform_sync();
+    update_note(synchronizer.note_manager(), "note2", "note4", "updated content");
+    synchronizer.perform_sync();
+    synchronizer.note_manager().delete_note(synchronizer.note_manager().find("note3").value());
+    synchronizer.perform_sync();
+
+    gnote::sync::FileSystemSyncServer server(Gio::File::create_for_path(syncdir), "compactor");
+    auto report = server.compact(false);
+    REQUIRE CHECK(report.has_value());
+    CHECK_EQUAL(-1, report->baseline_revision);
+    CHECK(report->removed_files > 0);
+    CHECK(report->reclaimed_bytes > 0);
+
+    // only note1 is still used from first revision
+    auto files = sharp::directory_get_files(syncdir + "/0/0");
+    REQUIRE CHECK_EQUAL(1, files.size());
+    CHECK(find_note_in_files(files, "note1"));
+    CHECK(sharp::file_exists(syncdir + "/0/2/manifest.xml"));
+
+    synchronizer2.perform_sync();
+    files = get_notes_in_dir(synchronizer2.notes_dir());
+    REQUIRE CHECK_EQUAL(2, files.size());
+    CHECK(find_note_in_files(files, "note1"));
+    CHECK(find_note_in_files(files, "note4"));
+    CHECK_EQUAL(1, synchronizer2.get_notebooks().size());
+  }
+
+  TEST_FIXTURE(Fixture2, compaction_folds_history)
+  {
+    synchronizer.perform_sync();
+    update_note(synchronizer.note_manager(), "note2", "note4", "updated content");
+    synchronizer.perform_sync();
+
+    gnote::sync::FileSystemSyncServer server(Gio::File::create_for_path(syncdir), "compactor");
+    auto report = server.compact(true);
+    REQUIRE CHECK(report.has_value());
+    CHECK_EQUAL(2, report->baseline_revision);
+    CHECK_EQUAL(2, report->removed_dirs);
+
+    auto revisions = sharp::directory_get_directories(syncdir + "/0");
+    REQUIRE CHECK_EQUAL(1, revisions.size());
+    CHECK_EQUAL(3, get_notes_in_dir(syncdir + "/0/2").size());
+
+    synchronizer2.perform_sync();
+    auto files = get_notes_in_dir(synchronizer2.notes_dir());
+    REQUIRE CHECK_EQUAL(3, files.size());
+    CHECK(find_note_in_files(files, "note4"));
+    CHECK_EQUAL(1, synchronizer2.get_notebooks().size());
+
+    // client that synchronized old history
+    synchronizer.perform_sync();
+    files = get_notes_in_dir(synchronizer.notes_dir());
+    REQUIRE CHECK_EQUAL(3, files.size());
+    CHECK(find_note_in_files(files, "note4"));
+  }
+
+  TEST_FIXTURE(Fixture2, compaction_folds_packed_revisions)
+  {
+    synchronizer.pack_revisions(true);
+    synchronizer.perform_sync();
+    update_note(synchronizer.note_manager(), "note2", "note4", "updated content");
+    synchronizer.perform_sync();
+
+    gnote::sync::FileSystemSyncServer server(Gio::File::create_for_path(syncdir), "compactor");
+    auto report = server.compact(true);
+    REQUIRE CHECK(report.has_value());
+    CHECK_EQUAL(1, sharp::directory_get_directories(syncdir + "/0").size());
+    CHECK(sharp::file_exists(syncdir + "/0/2/notes.pack"));
+
+    synchronizer2.perform_sync();
+    auto files = get_notes_in_dir(synchronizer2.notes_dir());
+    REQUIRE CHECK_EQUAL(3, files.size());
+    CHECK(find_note_in_files(files, "note1"));
+    CHECK(find_note_in_files(files, "note3"));
+    CHECK(find_note_in_files(files, "note4"));
+  }
+
+  TEST_FIXTURE(Fixture1, compaction_respects_sync_lock)
+  {
+    synchronizer.perform_sync();
+
+    gnote::sync::FileSystemSyncServer syncing(Gio::File::create_for_path(syncdir), "other");
+    REQUIRE CHECK(syncing.begin_sync_transaction());
+    gnote::sync::FileSystemSyncServer server(Gio::File::create_for_path(syncdir), "compactor");
+    CHECK(!server.compact(false).has_value());
+    syncing.cancel_sync_transaction();
+
+    CHECK(server.compact(false).has_value());
+  }
+}
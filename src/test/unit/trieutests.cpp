@@ -1,7 +1,7 @@
 /*
  * gnote
  *
- * Copyright (C) 2017,2023 Aurimas Cernius
+ * Copyright (C) 2017,2023,2026 Aurimas Cernius
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -22,6 +22,37 @@
 
 #include "trie.hpp"
 
+
+namespace {
+
+typedef gnote::TrieTree<Glib::ustring> TitleTrie;
+
+Glib::ustring match_string(TitleTrie & trie, const Glib::ustring & haystack)
+{
+  Glib::ustring result;
+  for(const auto & hit : trie.find_matches(haystack)) {
+    result += Glib::ustring::compose("%1-%2:%3;", hit.start(), hit.end(), hit.value());
+  }
+  return result;
+}
+
+Glib::ustring title(unsigned i)
+{
+  static const char *words[] = {"project", "meeting", "notes", "ideas", "plan", "todo", "review", "draft"};
+  return Glib::ustring::compose("%1 %2 %3", words[i % 8], words[(i / 8) % 8], i);
+}
+
+void fill_titles(TitleTrie & trie, unsigned count)
+{
+  for(unsigned i = 0; i < count; ++i) {
+    trie.add_keyword(title(i), title(i));
+  }
+  trie.compute_failure_graph();
+}
+
+}
+
+
 SUITE(TrieTree)
 {
   struct Fixture
@@ -142,5 +173,82 @@ SUITE(TrieTree)
     CHECK_EQUAL(72, hit->start());
     CHECK_EQUAL(81, hit->end());
   }
-}
 
+  TEST(insert_keyword_matches_rebuild)
+  {
+    const char *keywords[] = {"baz", "bazar", "zar", "ar", "a b", "b a", "foo", "oof", "ąčę"};
+    const Glib::ustring haystack = "bazar zar bar foof oofoo a b a baz ąčęąčę";
+    TitleTrie incremental(false);
+    TitleTrie rebuilt(false);
+    for(auto keyword : keywords) {
+      incremental.insert_keyword(keyword, keyword);
+      rebuilt.add_keyword(keyword, keyword);
+      rebuilt.compute_failure_graph();
+      CHECK_EQUAL(match_string(rebuilt, haystack), match_string(incremental, haystack));
+    }
+  }
+
+  TEST(remove_keyword_matches_rebuild)
+  {
+    std::vector<Glib::ustring> keywords = {"baz", "bazar", "zar", "ar", "a b", "b a", "foo", "oof", "ąčę"};
+    const Glib::ustring haystack = "bazar zar bar foof oofoo a b a baz ąčęąčę";
+    TitleTrie incremental(false);
+    for(const auto & keyword : keywords) {
+      incremental.add_keyword(keyword, keyword);
+    }
+    incremental.compute_failure_graph();
+
+    while(!keywords.empty()) {
+      auto removed = keywords[keywords.size() / 2];
+      CHECK(incremental.remove_keyword(removed, removed));
+      CHECK(!incremental.remove_keyword(removed, removed));
+      keywords.erase(keywords.begin() + keywords.size() / 2);
+
+      TitleTrie rebuilt(false);
+      for(const auto & keyword : keywords) {
+        rebuilt.add_keyword(keyword, keyword);
+      }
+      rebuilt.compute_failure_graph();
+      CHECK_EQUAL(match_string(rebuilt, haystack), match_string(incremental, haystack));
+    }
+    CHECK_EQUAL("", match_string(incremental, haystack));
+  }
+
+  TEST(remove_keyword_other_payload)
+  {
+    TitleTrie trie(false);
+    trie.insert_keyword("Foo", "note1");
+    CHECK(!trie.remove_keyword("foo", "note2"));
+    CHECK_EQUAL(1, trie.find_matches("a foo").size());
+    CHECK(trie.remove_keyword("foo", "note1"));
+    CHECK_EQUAL(0, trie.find_matches("a foo").size());
+  }
+
+  TEST(renames_match_rebuild)
+  {
+    const unsigned store_size = 200;
+    std::vector<Glib::ustring> titles;
+    TitleTrie incremental(false);
+    for(unsigned i = 0; i < store_size; ++i) {
+      titles.push_back(title(i));
+    }
+    fill_titles(incremental, store_size);
+
+    for(unsigned i = 0; i < 50; ++i) {
+      unsigned idx = i * 7 % store_size;
+      // renamed title both overlaps the old one and other titles
+      Glib::ustring renamed = i % 2 ? titles[idx] + " renamed" : title(idx + 1) + " " + titles[idx];
+      CHECK(incremental.remove_keyword(titles[idx], title(idx)));
+      incremental.insert_keyword(renamed, title(idx));
+      Glib::ustring haystack = titles[idx] + ", " + renamed + " and " + titles[(idx + 8) % store_size];
+      titles[idx] = renamed;
+
+      TitleTrie rebuilt(false);
+      for(unsigned t = 0; t < store_size; ++t) {
+        rebuilt.add_keyword(titles[t], title(t));
+      }
+      rebuilt.compute_failure_graph();
+      CHECK_EQUAL(match_string(rebuilt, haystack), match_string(incremental, haystack));
+    }
+  }
+}
@@ -22,193 +22,235 @@
 #ifndef __TRIE_HPP_
 #define __TRIE_HPP_
 
-#include <queue>
+#include <algorithm>
+#include <array>
+#include <unordered_map>
 
 #include "triehit.hpp"
 
 namespace gnote {
 
+/**
+ * Aho-Corasick automaton over keywords.
+ *
+ * States live in one array and refer to each other by 32-bit index. The
+ * transitions of a state are a sorted range in a shared transition array,
+ * ASCII transitions of the root are also in a direct lookup table.
+ * Keywords can be inserted and removed keeping the failure graph valid,
+ * the arrays are compacted in breadth-first order, when they get sparse.
+ */
 template<class value_t>
 class TrieTree
 {
 
 private:
 
-  class TrieState;
-  typedef TrieState* TrieStatePtr;
-  typedef std::deque<TrieStatePtr> TrieStateList;
-  typedef std::queue<TrieStatePtr> TrieStateQueue;
-
-  class TrieState
+  typedef guint32 StateIndex;
+  typedef std::vector<StateIndex> StateIndexList;
+
+  static constexpr StateIndex ROOT = 0;
+  // root is never a transition target
+  static constexpr StateIndex NO_TRANSITION = 0;
+  static constexpr StateIndex NO_STATE = G_MAXUINT32;
+  static constexpr std::size_t NOT_LINKED = std::size_t(-1);
+  static constexpr gunichar ASCII_END = 128;
+  // up to this many transitions linear search is faster than binary one
+  static constexpr guint32 LINEAR_SEARCH_MAX = 8;
+  // don't compact small trees
+  static constexpr std::size_t MIN_COMPACT_SIZE = 1024;
+
+  struct Transition
   {
-  public:
-
-    TrieState(gunichar v, int d, const TrieStatePtr & s)
-      : m_value(v)
-      , m_depth(d)
-      , m_fail_state(s)
-      , m_transitions()
-      , m_payload()
-      , m_payload_present(false)
-    {
-    }
-
-    gunichar value() const
-    {
-      return m_value;
-    }
-
-    int depth() const
-    {
-      return m_depth;
-    }
-
-    TrieStatePtr fail_state()
-    {
-      return m_fail_state;
-    }
-
-    void fail_state(const TrieStatePtr & s)
-    {
-      m_fail_state = s;
-    }
-
-    TrieStateList & transitions()
-    {
-      return m_transitions;
-    }
-
-    value_t payload() const
-    {
-      return m_payload;
-    }
-
-    void payload(const value_t & p)
-    {
-      m_payload = p;
-    }
-
-    bool payload_present() const
-    {
-      return m_payload_present;
-    }
-
-    void payload_present(bool pp)
-    {
-      m_payload_present = pp;
-    }
+    gunichar value;
+    StateIndex target;
+  };
 
-  private:
+  // data needed for matching, kept small so that more states fit in cache
+  struct State
+  {
+    gunichar value;
+    gint32 depth;
+    StateIndex fail;
+    guint32 transitions_begin;
+    guint32 transition_count;
+    guint32 transition_capacity;
+    bool payload_present;
+  };
 
-    gunichar m_value;
-    int m_depth;
-    TrieStatePtr m_fail_state;
-    TrieStateList m_transitions;
-    value_t m_payload;
-    bool m_payload_present;
+  // data needed to update the tree
+  struct StateLinks
+  {
+    StateIndex parent;
+    // states, which have this one as fail state
+    StateIndexList fail_sources;
+    // position in the fail sources of the fail state, NOT_LINKED if not there
+    std::size_t fail_source_pos;
   };
 
-  std::vector<std::unique_ptr<TrieState>> m_states;
+  std::vector<State> m_states;
+  std::vector<StateLinks> m_links;
+  std::vector<value_t> m_payloads;
+  std::vector<Transition> m_transitions;
+  std::array<StateIndex, ASCII_END> m_root_ascii;
+  // many states fail to root, so these are split by value
+  std::unordered_map<gunichar, StateIndexList> m_root_fail_sources;
+  StateIndexList m_free_states;
+  // transition slots not used by any state
+  std::size_t m_free_transitions;
   const bool m_case_sensitive;
-  const TrieStatePtr m_root;
   size_t m_max_length;
 
 public:
 
   TrieTree(bool case_sensitive)
-    : m_case_sensitive(case_sensitive)
-    , m_root(new TrieState('\0', -1, TrieStatePtr()))
+    : m_free_transitions(0)
+    , m_case_sensitive(case_sensitive)
     , m_max_length(0)
   {
-    m_states.push_back(std::unique_ptr<TrieState>(m_root));
+    m_root_ascii.fill(NO_TRANSITION);
+    new_state('\0', -1, NO_STATE);
+    m_states[ROOT].fail = NO_STATE;
   }
 
+  // Add keyword, compute_failure_graph() has to be called afterwards.
+  // Used to build the tree at once.
   void add_keyword(const Glib::ustring & keyword, const value_t & pattern_id)
   {
-    TrieStatePtr current_state = m_root;
-    Glib::ustring::size_type i;
-    Glib::ustring::const_iterator iter;
-    for(i = 0, iter = keyword.begin(); iter != keyword.end(); ++i, ++iter) {
-      gunichar c = *iter;
-      if (!m_case_sensitive)
-        c = Glib::Unicode::tolower(c);
+    add_states(keyword, pattern_id, nullptr);
+  }
 
-      TrieStatePtr target_state = find_state_transition(current_state, c);
-      if (0 == target_state) {
-        target_state = new TrieState(c, i, m_root);
-        m_states.push_back(std::unique_ptr<TrieState>(target_state));
-        current_state->transitions().push_front(target_state);
+  // Add keyword to a tree with computed failure graph, keeping it valid.
+  // Only fail states of the states, that have the new keyword prefixes as suffix, are changed.
+  void insert_keyword(const Glib::ustring & keyword, const value_t & pattern_id)
+  {
+    StateIndexList created;
+    add_states(keyword, pattern_id, &created);
+
+    // new states are on single path, so they go by increasing depth,
+    // fail state of each one is computed, when the shorter ones are already in place
+    for(StateIndex state : created) {
+      gunichar value = m_states[state].value;
+      StateIndex parent = m_links[state].parent;
+      StateIndex fail_state = ROOT;
+      if(parent != ROOT) {
+        fail_state = m_states[parent].fail;
+        while(fail_state != NO_STATE && NO_TRANSITION == find_transition(fail_state, value)) {
+          fail_state = m_states[fail_state].fail;
+        }
+        fail_state = fail_state != NO_STATE ? find_transition(fail_state, value) : ROOT;
       }
 
-      current_state = target_state;
+      // States ending with the new one now fail to it, unless they have a longer suffix.
+      // Their parents end with the parent of new state, so they are found following fail sources from it,
+      // the fail state of the new state is set first, as it might be on the way.
+      m_states[state].fail = fail_state;
+      if(parent == ROOT) {
+        StateIndexList & sources = fail_sources(ROOT, value);
+        while(!sources.empty()) {
+          link_fail_state(sources.back(), state);
+        }
+      }
+      else {
+        StateIndexList parents(1, parent);
+        while(!parents.empty()) {
+          StateIndex current = parents.back();
+          parents.pop_back();
+          const StateIndexList & current_sources = m_links[current].fail_sources;
+          parents.insert(parents.end(), current_sources.begin(), current_sources.end());
+
+          StateIndex source = find_transition(current, value);
+          if(source != NO_TRANSITION && source != state && m_states[source].fail == fail_state
+             && m_links[source].fail_source_pos != NOT_LINKED) {
+            link_fail_state(source, state);
+          }
+        }
+      }
+
+      link_fail_state(state, fail_state);
     }
 
-    current_state->payload(pattern_id);
-    current_state->payload_present(true);
-    m_max_length = std::max(m_max_length, keyword.size());
+    if(m_transitions.size() > MIN_COMPACT_SIZE && m_free_transitions > m_transitions.size() / 2) {
+      compact(true);
+    }
   }
 
-  void compute_failure_graph()
+  // Remove keyword having the given payload, keeping the failure graph valid.
+  // Returns false, if there is no such keyword.
+  bool remove_keyword(const Glib::ustring & keyword, const value_t & pattern_id)
   {
-    // Failure state is computed breadth-first (-> Queue)
-    TrieStateQueue state_queue;
-
-    // For each direct child of the root state
-    // * Set the fail state to the root state
-    // * Enqueue the state for failure graph computing
-    for (typename TrieStateList::iterator iter = m_root->transitions().begin();
-         m_root->transitions().end() != iter; iter++) {
-      TrieStatePtr & transition = *iter;
-      transition->fail_state(m_root);
-      state_queue.push(transition);
+    StateIndex state = ROOT;
+    for(Glib::ustring::const_iterator iter = keyword.begin(); iter != keyword.end(); ++iter) {
+      gunichar c = *iter;
+      if (!m_case_sensitive)
+        c = Glib::Unicode::tolower(c);
+      state = find_transition(state, c);
+      if(state == NO_TRANSITION) {
+        return false;
+      }
+    }
+    if(!m_states[state].payload_present || !(m_payloads[state] == pattern_id)) {
+      return false;
     }
 
-    while (false == state_queue.empty()) {
-      // Current state already has a valid fail state at this point
-      TrieStatePtr current_state = state_queue.front();
-      state_queue.pop();
-
-      for (typename TrieStateList::iterator iter
-             = current_state->transitions().begin();
-           current_state->transitions().end() != iter; iter++) {
-        TrieStatePtr & transition = *iter;
-        state_queue.push(transition);
-
-        TrieStatePtr fail_state = current_state->fail_state();
-        while ((0 != fail_state)
-               && 0 == find_state_transition(fail_state, transition->value())) {
-          fail_state = fail_state->fail_state();
-        }
-
-        if (0 == fail_state)
-          transition->fail_state(m_root);
-        else
-          transition->fail_state(find_state_transition(fail_state, transition->value()));
+    m_states[state].payload_present = false;
+    m_payloads[state] = value_t();
+
+    // Remove the states, that are no longer a prefix of any keyword.
+    // Longest suffix of the states that failed to removed one is the fail state of it.
+    // m_max_length is left as is, it is only an upper bound for the hit length.
+    while(state != ROOT && !m_states[state].payload_present && m_states[state].transition_count == 0) {
+      StateIndex parent = m_links[state].parent;
+      remove_transition(parent, m_states[state].value);
+
+      StateIndexList sources;
+      sources.swap(m_links[state].fail_sources);
+      for(StateIndex source : sources) {
+        m_links[source].fail_source_pos = NOT_LINKED;
+        link_fail_state(source, m_states[state].fail);
       }
+      unlink_fail_state(state);
+      free_state(state);
+
+      state = parent;
     }
+
+    return true;
   }
 
-  static TrieStatePtr find_state_transition(const TrieStatePtr & state,
-                                            gunichar value)
+  void compute_failure_graph()
   {
-    if (true == state->transitions().empty())
-      return TrieStatePtr();
+    // after compaction states are in breadth-first order,
+    // so fail state of the parent is always computed before the child
+    compact(false);
+    for(auto & links : m_links) {
+      links.fail_sources.clear();
+      links.fail_source_pos = NOT_LINKED;
+    }
+    m_root_fail_sources.clear();
+
+    for(StateIndex state = 1; state < m_states.size(); ++state) {
+      StateIndex parent = m_links[state].parent;
+      gunichar value = m_states[state].value;
+      if(parent == ROOT) {
+        link_fail_state(state, ROOT);
+        continue;
+      }
 
-    for (typename TrieStateList::const_iterator iter
-           = state->transitions().begin();
-         state->transitions().end() != iter; iter++) {
-      const TrieStatePtr & transition = *iter;
-      if (transition->value() == value)
-        return transition;
+      StateIndex fail_state = m_states[parent].fail;
+      while(fail_state != NO_STATE && NO_TRANSITION == find_transition(fail_state, value)) {
+        fail_state = m_states[fail_state].fail;
+      }
 
+      if(fail_state == NO_STATE)
+        link_fail_state(state, ROOT);
+      else
+        link_fail_state(state, find_transition(fail_state, value));
     }
-
-    return TrieStatePtr();
   }
 
-  typename TrieHit<value_t>::List find_matches (const Glib::ustring & haystack)
+  typename TrieHit<value_t>::List find_matches (const Glib::ustring & haystack) const
   {
-    TrieStatePtr current_state = m_root;
+    StateIndex current_state = ROOT;
     typename TrieHit<value_t>::List matches;
     int start_index = 0;
 
@@ -218,30 +260,30 @@ public:
       if (!m_case_sensitive)
         c = Glib::Unicode::tolower(c);
 
-      if (current_state == m_root)
+      if (current_state == ROOT)
         start_index = i;
 
       // While there's no matching transition, follow the fail states
       // Because we're potentially changing the depths (aka length of
       // matched characters) in the tree we're updating the start_index
       // accordingly
-      while ((current_state != m_root)
-             && 0 == find_state_transition(current_state, c)) {
-        TrieStatePtr old_state = current_state;
-        current_state = current_state->fail_state();
-        start_index += old_state->depth() - current_state->depth();
+      StateIndex next_state = find_transition(current_state, c);
+      while (current_state != ROOT && NO_TRANSITION == next_state) {
+        const State & old_state = m_states[current_state];
+        current_state = old_state.fail;
+        start_index += old_state.depth - m_states[current_state].depth;
+        next_state = find_transition(current_state, c);
       }
 
-      current_state = find_state_transition (current_state, c);
-      if (0 == current_state)
-        current_state = m_root;
+      // no transition from root means staying at root
+      current_state = next_state;
 
       // If the state contains a payload: We've got a hit
       // Return a TrieHit with the start and end index, the matched
       // string and the payload object
-      if (current_state->payload_present()) {
+      if (m_states[current_state].payload_present) {
         int hit_length = i - start_index + 1;
-        TrieHit<value_t> hit(start_index, start_index + hit_length, haystack.substr(start_index, hit_length), current_state->payload());
+        TrieHit<value_t> hit(start_index, start_index + hit_length, haystack.substr(start_index, hit_length), value_t(m_payloads[current_state]));
         matches.push_back(hit);
       }
     }
@@ -254,6 +296,222 @@ public:
     return m_max_length;
   }
 
+private:
+
+  StateIndex find_transition(StateIndex state, gunichar value) const
+  {
+    if(state == ROOT && value < ASCII_END) {
+      return m_root_ascii[value];
+    }
+
+    const State & s = m_states[state];
+    const Transition *begin = m_transitions.data() + s.transitions_begin;
+    const Transition *end = begin + s.transition_count;
+    if(s.transition_count <= LINEAR_SEARCH_MAX) {
+      for(; begin != end && begin->value <= value; ++begin) {
+        if(begin->value == value) {
+          return begin->target;
+        }
+      }
+      return NO_TRANSITION;
+    }
+
+    auto iter = std::lower_bound(begin, end, value, [](const Transition & t, gunichar v) { return t.value < v; });
+    return iter != end && iter->value == value ? iter->target : NO_TRANSITION;
+  }
+
+  StateIndex new_state(gunichar value, gint32 depth, StateIndex parent)
+  {
+    State state = {value, depth, ROOT, 0, 0, 0, false};
+    if(!m_free_states.empty()) {
+      StateIndex index = m_free_states.back();
+      m_free_states.pop_back();
+      m_states[index] = state;
+      m_links[index].parent = parent;
+      return index;
+    }
+
+    m_states.push_back(state);
+    m_links.push_back(StateLinks{parent, StateIndexList(), NOT_LINKED});
+    m_payloads.emplace_back();
+    return m_states.size() - 1;
+  }
+
+  void free_state(StateIndex state)
+  {
+    // state has no transitions, so its slots are already counted as free
+    State & s = m_states[state];
+    s.transition_capacity = 0;
+    s.fail = NO_STATE;
+    m_links[state].parent = NO_STATE;
+    m_payloads[state] = value_t();
+    m_free_states.push_back(state);
+  }
+
+  void add_transition(StateIndex state, gunichar value, StateIndex target)
+  {
+    if(m_states[state].transition_count == m_states[state].transition_capacity) {
+      // move to the end with space to grow, old place stays unused until compaction
+      State & s = m_states[state];
+      guint32 capacity = std::max<guint32>(1, s.transition_capacity * 2);
+      guint32 begin = m_transitions.size();
+      m_transitions.resize(begin + capacity);
+      std::copy(m_transitions.begin() + s.transitions_begin, m_transitions.begin() + s.transitions_begin + s.transition_count, m_transitions.begin() + begin);
+      m_free_transitions += s.transition_capacity + capacity - s.transition_count;
+      s.transitions_begin = begin;
+      s.transition_capacity = capacity;
+    }
+    --m_free_transitions;
+
+    State & s = m_states[state];
+    auto begin = m_transitions.begin() + s.transitions_begin;
+    auto end = begin + s.transition_count;
+    auto pos = std::lower_bound(begin, end, value, [](const Transition & t, gunichar v) { return t.value < v; });
+    std::copy_backward(pos, end, end + 1);
+    *pos = Transition{value, target};
+    ++s.transition_count;
+
+    if(state == ROOT && value < ASCII_END) {
+      m_root_ascii[value] = target;
+    }
+  }
+
+  void remove_transition(StateIndex state, gunichar value)
+  {
+    State & s = m_states[state];
+    auto begin = m_transitions.begin() + s.transitions_begin;
+    auto end = begin + s.transition_count;
+    auto pos = std::lower_bound(begin, end, value, [](const Transition & t, gunichar v) { return t.value < v; });
+    std::copy(pos + 1, end, pos);
+    --s.transition_count;
+    ++m_free_transitions;
+
+    if(state == ROOT && value < ASCII_END) {
+      m_root_ascii[value] = NO_TRANSITION;
+    }
+  }
+
+  void add_states(const Glib::ustring & keyword, const value_t & pattern_id, StateIndexList *created)
+  {
+    StateIndex current_state = ROOT;
+    Glib::ustring::size_type i;
+    Glib::ustring::const_iterator iter;
+    for(i = 0, iter = keyword.begin(); iter != keyword.end(); ++i, ++iter) {
+      gunichar c = *iter;
+      if (!m_case_sensitive)
+        c = Glib::Unicode::tolower(c);
+
+      StateIndex target_state = find_transition(current_state, c);
+      if (NO_TRANSITION == target_state) {
+        target_state = new_state(c, i, current_state);
+        add_transition(current_state, c, target_state);
+        if(created) {
+          created->push_back(target_state);
+        }
+      }
+
+      current_state = target_state;
+    }
+
+    m_states[current_state].payload_present = true;
+    m_payloads[current_state] = pattern_id;
+    m_max_length = std::max(m_max_length, keyword.size());
+  }
+
+  // Renumber states in breadth-first order and pack their transitions in the same order.
+  // Fail states are kept, if link_fails is false, fail sources have to be rebuilt by caller.
+  void compact(bool link_fails)
+  {
+    StateIndexList order(1, ROOT);
+    std::vector<StateIndex> new_index(m_states.size(), NO_STATE);
+    new_index[ROOT] = ROOT;
+    for(std::size_t i = 0; i < order.size(); ++i) {
+      const State & s = m_states[order[i]];
+      for(guint32 t = s.transitions_begin; t < s.transitions_begin + s.transition_count; ++t) {
+        new_index[m_transitions[t].target] = order.size();
+        order.push_back(m_transitions[t].target);
+      }
+    }
+
+    std::vector<State> states;
+    std::vector<StateLinks> links;
+    std::vector<value_t> payloads;
+    std::vector<Transition> transitions;
+    states.reserve(order.size());
+    links.reserve(order.size());
+    payloads.reserve(order.size());
+    transitions.reserve(order.size() - 1);
+    for(StateIndex old_index : order) {
+      State state = m_states[old_index];
+      guint32 begin = transitions.size();
+      for(guint32 t = state.transitions_begin; t < state.transitions_begin + state.transition_count; ++t) {
+        transitions.push_back(Transition{m_transitions[t].value, new_index[m_transitions[t].target]});
+      }
+      state.transitions_begin = begin;
+      state.transition_capacity = state.transition_count;
+      if(state.fail != NO_STATE) {
+        state.fail = new_index[state.fail];
+      }
+      states.push_back(state);
+
+      StateIndex parent = m_links[old_index].parent;
+      links.push_back(StateLinks{parent != NO_STATE ? new_index[parent] : NO_STATE, StateIndexList(), NOT_LINKED});
+      payloads.push_back(std::move(m_payloads[old_index]));
+    }
+
+    m_states.swap(states);
+    m_links.swap(links);
+    m_payloads.swap(payloads);
+    m_transitions.swap(transitions);
+    m_free_states.clear();
+    m_free_transitions = 0;
+    m_root_ascii.fill(NO_TRANSITION);
+    const State & root = m_states[ROOT];
+    for(guint32 t = root.transitions_begin; t < root.transitions_begin + root.transition_count; ++t) {
+      if(m_transitions[t].value < ASCII_END) {
+        m_root_ascii[m_transitions[t].value] = m_transitions[t].target;
+      }
+    }
+
+    m_root_fail_sources.clear();
+    if(link_fails) {
+      for(StateIndex state = 1; state < m_states.size(); ++state) {
+        link_fail_state(state, m_states[state].fail);
+      }
+    }
+  }
+
+  StateIndexList & fail_sources(StateIndex fail_state, gunichar value)
+  {
+    // apart from root, fail state has the same value as all states failing to it
+    if(fail_state == ROOT) {
+      return m_root_fail_sources[value];
+    }
+    return m_links[fail_state].fail_sources;
+  }
+
+  void link_fail_state(StateIndex state, StateIndex fail_state)
+  {
+    unlink_fail_state(state);
+    m_states[state].fail = fail_state;
+    StateIndexList & sources = fail_sources(fail_state, m_states[state].value);
+    m_links[state].fail_source_pos = sources.size();
+    sources.push_back(state);
+  }
+
+  void unlink_fail_state(StateIndex state)
+  {
+    std::size_t pos = m_links[state].fail_source_pos;
+    if(pos == NOT_LINKED) {
+      return;
+    }
+
+    StateIndexList & sources = fail_sources(m_states[state].fail, m_states[state].value);
+    sources[pos] = sources.back();
+    m_links[sources[pos]].fail_source_pos = pos;
+    sources.pop_back();
+    m_links[state].fail_source_pos = NOT_LINKED;
+  }
 };
 
 }
@@ -39,6 +39,7 @@
 #include "notemanager.hpp"
 #include "notewindow.hpp"
 #include "preferences.hpp"
+#include "searchindex.hpp"
 #include "triehit.hpp"
 #include "watchers.hpp"
 
@@ -354,7 +355,10 @@ namespace gnote {
   {
     detach_checker();
     m_enabled = false;
-    get_note()->get_window()->signal_popover_widgets_changed();
+    // not opened notes are shut down too, when plugins are unloaded
+    if(auto window = get_note()->get_window()) {
+      window->signal_popover_widgets_changed();
+    }
   }
 
 
@@ -679,6 +683,9 @@ namespace gnote {
       sigc::mem_fun(*this, &AppLinkWatcher::on_note_added));
     m_on_note_renamed_cid = note_manager().signal_note_renamed.connect(
       sigc::mem_fun(*this, &AppLinkWatcher::on_note_renamed));
+    m_on_batch_change_finished_cid = note_manager().signal_batch_change_finished.connect(
+      sigc::mem_fun(*this, &AppLinkWatcher::on_batch_change_finished));
+    m_linker = std::make_unique<AutoLinker>(note_manager(), sigc::mem_fun(*this, &AppLinkWatcher::highlight_in_buffer));
   }
 
   void AppLinkWatcher::shutdown()
@@ -687,6 +694,9 @@ namespace gnote {
     m_on_note_deleted_cid.disconnect();
     m_on_note_added_cid.disconnect();
     m_on_note_renamed_cid.disconnect();
+    m_on_batch_change_finished_cid.disconnect();
+    m_batch_notes.clear();
+    m_linker.reset();
   }
 
   bool AppLinkWatcher::initialized()
@@ -696,20 +706,12 @@ namespace gnote {
 
   void AppLinkWatcher::on_note_added(NoteBase & added)
   {
-    note_manager().for_each([this, &added](NoteBase & note) {
-      if(&added == &note) {
-        return;
-      }
-
-      if(!contains_text(note, added.get_title())) {
-        return;
-      }
+    if(note_manager().in_batch_change()) {
+      m_batch_notes.push_back(added.uri());
+      return;
+    }
 
-      // Highlight previously unlinked text
-      auto & n = static_cast<Note&>(note);
-      auto buffer = n.get_buffer();
-      highlight_in_block(note_manager(), n, buffer->begin(), buffer->end());
-    });
+    m_linker->link({added.uri()});
   }
 
   void AppLinkWatcher::on_note_deleted(NoteBase & deleted)
@@ -718,11 +720,18 @@ namespace gnote {
     auto link_tag = tag_table->get_link_tag();
     auto broken_link_tag = tag_table->get_broken_link_tag();
 
-    note_manager().for_each([this, &deleted, &link_tag, &broken_link_tag](NoteBase & note) {
+    // notes, that don't have all words of the title, can't link to it
+    const SearchIndex & index = note_manager().search_index();
+    auto candidates = index.find_candidates({deleted.get_title()});
+
+    note_manager().for_each([this, &deleted, &link_tag, &broken_link_tag, &index, &candidates](NoteBase & note) {
       if(&deleted == &note) {
         return;
       }
 
+      if(candidates && index.is_indexed(note.uri()) && candidates->find(note.uri()) == candidates->end()) {
+        return;
+      }
       if(!contains_text(note, deleted.get_title())) {
         return;
       }
@@ -744,51 +753,51 @@ namespace gnote {
 
   void AppLinkWatcher::on_note_renamed(const NoteBase & renamed, const Glib::ustring & /*old_title*/)
   {
-    note_manager().for_each([this, &renamed](NoteBase & note) {
-      if(&renamed == &note) {
-        return;
-      }
+    if(note_manager().in_batch_change()) {
+      m_batch_notes.push_back(renamed.uri());
+      return;
+    }
 
-      // Highlight previously unlinked text
-      if(contains_text(note, renamed.get_title())) {
-        auto & n = static_cast<Note&>(note);
-        auto buffer = n.get_buffer();
-        highlight_note_in_block(note_manager(), n, renamed, buffer->begin(), buffer->end());
-      }
-    });
+    m_linker->link({renamed.uri()});
   }
 
-  bool AppLinkWatcher::contains_text(const NoteBase & note, const Glib::ustring & text)
+  // Single pass over notes for all titles from the batch, instead of one per title
+  void AppLinkWatcher::on_batch_change_finished()
   {
-    Glib::ustring body = const_cast<NoteBase&>(note).text_content().lowercase();
-    Glib::ustring match = text.lowercase();
+    if(m_batch_notes.empty()) {
+      return;
+    }
 
-    return body.find(match) != Glib::ustring::npos;
+    m_linker->link(m_batch_notes);
+    m_batch_notes.clear();
   }
 
-  void AppLinkWatcher::highlight_in_block(NoteManagerBase & note_manager, Note & note, const Gtk::TextIter & start, const Gtk::TextIter & end)
+  // Notes without buffer are linked by AutoLinker in their XML
+  bool AppLinkWatcher::highlight_in_buffer(NoteBase & note)
   {
-    for(const auto & hit : note_manager.find_trie_matches(start.get_slice(end))) {
-      do_highlight(note_manager, note, hit, start, end);
+    auto & n = static_cast<Note&>(note);
+    if(!n.has_buffer()) {
+      return false;
     }
+
+    // Highlight previously unlinked text
+    auto buffer = n.get_buffer();
+    highlight_in_block(note_manager(), n, buffer->begin(), buffer->end());
+    return true;
   }
 
-  void AppLinkWatcher::highlight_note_in_block(NoteManagerBase & note_manager, Note & note, const NoteBase & find_note, const Gtk::TextIter & start, const Gtk::TextIter & end)
+  bool AppLinkWatcher::contains_text(const NoteBase & note, const Glib::ustring & text)
   {
-    Glib::ustring buffer_text = start.get_text(end).lowercase();
-    Glib::ustring find_title_lower = find_note.get_title().lowercase();
-    int idx = 0;
+    Glib::ustring body = const_cast<NoteBase&>(note).text_content().lowercase();
+    Glib::ustring match = text.lowercase();
 
-    while (true) {
-      idx = buffer_text.find(find_title_lower, idx);
-      if (idx < 0)
-        break;
+    return body.find(match) != Glib::ustring::npos;
+  }
 
-      auto title_len = find_title_lower.length();
-      TrieHit<Glib::ustring> hit(idx, idx + title_len, Glib::ustring(find_title_lower), Glib::ustring(find_note.uri()));
+  void AppLinkWatcher::highlight_in_block(NoteManagerBase & note_manager, Note & note, const Gtk::TextIter & start, const Gtk::TextIter & end)
+  {
+    for(const auto & hit : note_manager.find_trie_matches(start.get_slice(end))) {
       do_highlight(note_manager, note, hit, start, end);
-
-      idx += title_len;
     }
   }
 
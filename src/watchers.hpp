@@ -40,6 +40,7 @@ extern "C" {
 #include <gtkmm/texttag.h>
 
 #include "applicationaddin.hpp"
+#include "autolinker.hpp"
 #include "noteaddin.hpp"
 #include "triehit.hpp"
 #include "utils.hpp"
@@ -187,15 +188,20 @@ namespace gnote {
     virtual bool initialized() override;
   private:
     static bool contains_text(const NoteBase & note, const Glib::ustring & text);
-    static void highlight_note_in_block(NoteManagerBase &, Note &, const NoteBase &, const Gtk::TextIter &, const Gtk::TextIter &);
+    bool highlight_in_buffer(NoteBase & note);
     void on_note_added(NoteBase &);
     void on_note_deleted(NoteBase &);
     void on_note_renamed(const NoteBase&, const Glib::ustring&);
+    void on_batch_change_finished();
 
     bool m_initialized;
     sigc::connection m_on_note_deleted_cid;
     sigc::connection m_on_note_added_cid;
     sigc::connection m_on_note_renamed_cid;
+    sigc::connection m_on_batch_change_finished_cid;
+    // uris of notes added or renamed during batch change
+    std::vector<Glib::ustring> m_batch_notes;
+    std::unique_ptr<AutoLinker> m_linker;
   };
 
 